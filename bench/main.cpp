@@ -0,0 +1,64 @@
+
+/*!
+@file main.cpp
+@brief Benchmark driver, output one json object per line
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <map>
+
+#include "nw_bench.hpp"
+
+static std::map<std::string, bench::suite_fct_t> &	_suites(void) {
+	static std::map<std::string, bench::suite_fct_t>	suites;
+
+	return suites;
+}
+
+bench::suite::suite(const std::string &name, const suite_fct_t &fct) {
+	_suites()[name] = fct;
+}
+
+void				bench::report(const result &r) {
+	char	line[512];
+
+	std::snprintf(line, sizeof(line), "{ \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, \"bytes_per_sec\": %.0f }",
+		r.name.c_str(),
+		static_cast<unsigned long long>(r.iterations),
+		r.ns_per_op,
+		(r.ns_per_op > 0) ? 1e9 / r.ns_per_op : 0,
+		(r.ns_per_op > 0) ? static_cast<double>(r.bytes_per_op) * 1e9 / r.ns_per_op : 0
+	);
+	std::cout << line << std::endl;
+}
+
+nw::size_type		bench::run_suites(const std::list<std::string> &filters) {
+	nw::size_type	count = 0;
+
+	for (std::map<std::string, suite_fct_t>::const_iterator it = _suites().begin(); it != _suites().end(); ++it) {
+		bool	selected = filters.empty();
+
+		for (std::list<std::string>::const_iterator f = filters.begin(); !selected && f != filters.end(); ++f)
+			selected = it->first.find(*f) != std::string::npos;
+		if (!selected)
+			continue ;
+		it->second();
+		++count;
+	}
+	return count;
+}
+
+int	main(int ac, char *av[]) try {
+	std::list<std::string>	filters(av + 1, av + ac);
+
+	if (!bench::run_suites(filters)) {
+		std::cerr << "no benchmark suite selected" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+	std::cerr << "Exception: " << e.what() << std::endl;
+	return EXIT_FAILURE;
+}
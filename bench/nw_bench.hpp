@@ -0,0 +1,61 @@
+#ifndef __NW_BENCH_HPP__
+# define __NW_BENCH_HPP__
+
+/*!
+@file nw_bench.hpp
+@brief ...
+*/
+
+# include <string>
+# include <list>
+# include <functional>
+# include <chrono>
+
+# include "nw_typedef.hpp"
+
+namespace bench {
+	//! @brief One benchmark measure, reported as a json line
+	struct	result {
+		std::string		name;			//!< benchmark name, "suite/case"
+		uint64_t		iterations;		//!< measured iterations
+		double			ns_per_op;		//!< mean time per iteration
+		uint64_t		bytes_per_op;	//!< payload bytes per iteration, 0 if not relevant
+	};
+
+	typedef std::function<void(void)>	suite_fct_t;
+
+	//! @brief Register a benchmark suite at static initialization
+	struct	suite {
+		suite(const std::string &name, const suite_fct_t &fct);
+	};
+
+	//! @brief Print result as a json line on stdout
+	void	report(const result &r);
+
+	//! @brief Run registered suites which name contains one of filters, all if filters is empty
+	//! @return number of suites run
+	nw::size_type	run_suites(const std::list<std::string> &filters);
+
+	//! @brief Prevent the compiler from optimizing value away
+	template <typename T>
+	inline void	keep(const T &value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	//! @brief Time iterations calls of fct and report
+	template <typename F>
+	result	run(const std::string &name, const uint64_t &iterations, F fct, const uint64_t &bytes_per_op = 0) {
+		const std::chrono::steady_clock::time_point	start = std::chrono::steady_clock::now();
+
+		for (uint64_t i = 0; i != iterations; ++i)
+			fct();
+
+		const std::chrono::nanoseconds	elapsed = std::chrono::steady_clock::now() - start;
+		result							r = {name, iterations, static_cast<double>(elapsed.count()) / static_cast<double>(iterations), bytes_per_op};
+
+		report(r);
+		return r;
+	}
+};
+
+#endif
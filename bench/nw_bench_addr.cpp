@@ -0,0 +1,84 @@
+
+/*!
+@file nw_bench_addr.cpp
+@brief nw::addr and nw::slim_addr construction, copy, to_string and format, nw::protoent lookup
+*/
+
+#include "nw_bench.hpp"
+#include "nw_addr.hpp"
+#include "nw_slim_addr.hpp"
+#include "nw_protoent.hpp"
+
+static const uint64_t	ITERATIONS = 200000;
+
+static bench::suite	_addr_suite("addr", [](){
+	bench::run("addr/inet_construct", ITERATIONS, [](){
+		nw::addr<nw::sa_family::INET>	a(4242, "127.0.0.1");
+
+		bench::keep(a);
+	});
+	bench::run("addr/inet6_construct", ITERATIONS, [](){
+		nw::addr<nw::sa_family::INET6>	a(4242, "::1");
+
+		bench::keep(a);
+	});
+	bench::run("addr/local_construct", ITERATIONS, [](){
+		nw::addr<nw::sa_family::LOCAL>	a("/tmp/nw_bench.sock");
+
+		bench::keep(a);
+	});
+	{
+		const nw::addr<nw::sa_family::INET>		a(4242, "127.0.0.1");
+
+		char									buf[128];
+
+		bench::run("addr/inet_to_string", ITERATIONS, [&a](){
+			bench::keep(a.to_string());
+		});
+		bench::run("addr/inet_format", ITERATIONS, [&a, &buf](){
+			bench::keep(nw::to_chars(buf, sizeof(buf), a));
+		});
+		bench::run("addr/inet_copy", ITERATIONS, [&a](){
+			nw::addr<nw::sa_family::INET>	b(a);
+
+			bench::keep(b);
+		});
+	}
+	{
+		const nw::addr<nw::sa_family::INET6>	a(4242, "::1");
+
+		char									buf[128];
+
+		bench::run("addr/inet6_to_string", ITERATIONS, [&a](){
+			bench::keep(a.to_string());
+		});
+		bench::run("addr/inet6_format", ITERATIONS, [&a, &buf](){
+			bench::keep(nw::to_chars(buf, sizeof(buf), a));
+		});
+	}
+	{
+		const nw::slim_addr<nw::sa_family::INET>	a(4242, "127.0.0.1");
+
+		bench::run("addr/slim_inet_copy", ITERATIONS, [&a](){
+			nw::slim_addr<nw::sa_family::INET>	b(a);
+
+			bench::keep(b);
+		});
+		bench::run("addr/slim_inet_hash", ITERATIONS, [&a](){
+			bench::keep(a.hash());
+		});
+	}
+});
+
+static bench::suite	_protoent_suite("protoent", [](){
+	bench::run("protoent/by_name", ITERATIONS, [](){
+		nw::protoent	p("tcp");
+
+		bench::keep(p);
+	});
+	bench::run("protoent/by_number", ITERATIONS, [](){
+		nw::protoent	p(IPPROTO_UDP);
+
+		bench::keep(p);
+	});
+});
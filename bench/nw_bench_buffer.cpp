@@ -0,0 +1,61 @@
+
+/*!
+@file nw_bench_buffer.cpp
+@brief nw::buffer putn / getn and nw::ibuffer / nw::obuffer stream operators
+*/
+
+#include "nw_bench.hpp"
+#include "buffer/nw_ibuffer.hpp"
+#include "buffer/nw_obuffer.hpp"
+
+static const nw::size_type	BUFFER_SIZE = 1 << 12;
+static const uint64_t		ITERATIONS = 2000000;
+
+//! @brief Buffer which offsets can be placed, to measure wrapped and unwrapped copies
+template <nw::size_type SIZE>
+struct	probe : public nw::buffer<SIZE> {
+	void	seek(const nw::pos_type &pos) {
+		this->_off = {pos, pos};
+		this->_is_full = false;
+	}
+};
+
+static void	_putn_getn(const nw::size_type &n, const bool &wrapped) {
+	static probe<BUFFER_SIZE>	buf;
+	static char					data[BUFFER_SIZE];
+	const nw::pos_type			pos = (wrapped) ? BUFFER_SIZE - n / 2 : 0;
+	const std::string			name = std::string("buffer/") + ((wrapped) ? "wrapped" : "unwrapped") + "_putn_getn_" + std::to_string(n);
+
+	bench::run(name, ITERATIONS, [&](){
+		buf.seek(pos);
+		bench::keep(buf.putn(data, n));
+		bench::keep(buf.getn(data, n));
+	}, n);
+}
+
+static bench::suite	_suite("buffer", [](){
+	for (const int &n : {8, 64, 512, 2048}) {
+		_putn_getn(n, false);
+		_putn_getn(n, true);
+	}
+	{
+		static nw::ibuffer<BUFFER_SIZE>	ib;
+		uint64_t						v = 42;
+
+		bench::run("buffer/ibuffer_extract_u64", ITERATIONS, [&](){
+			ib.putn(&v, sizeof(v));
+			ib >> v;
+			bench::keep(v);
+		}, sizeof(v));
+	}
+	{
+		static nw::obuffer<BUFFER_SIZE>	ob;
+		uint64_t						v = 42;
+
+		bench::run("buffer/obuffer_insert_u64", ITERATIONS, [&](){
+			ob << v;
+			ob.getn(&v, sizeof(v));
+			bench::keep(v);
+		}, sizeof(v));
+	}
+});
@@ -0,0 +1,130 @@
+
+/*!
+@file nw_bench_coroutine.cpp
+@brief Loopback echo driven by nw::co_socket awaitables on one nw::io_loop, and nw::task start cost with and without nw::frame_pool
+@details Built with -std=c++20, the only translation unit of the tree compiling nw_coroutine.hpp
+*/
+
+#include "nw_bench.hpp"
+#include "nw_coroutine.hpp"
+
+#ifndef NW_COROUTINES
+# error "nw_bench_coroutine.cpp requires C++20 coroutines"
+#endif
+
+typedef nw::socket<nw::sa_family::INET, nw::sock_type::STREAM>	inet_stream;
+typedef nw::co_socket<nw::sa_family::INET, nw::sock_type::STREAM>	co_inet_stream;
+
+static const nw::size_type	BUFFER_SIZE = 256;
+static const nw::size_type	MSG_SIZE = 64;
+static const uint64_t		TASKS = 1000000;
+
+static nw::addr<nw::sa_family::INET>	_local_addr(const nw::sockfd_type &fd) {
+	nw::addr<nw::sa_family::INET>::type	sa = {};
+	socklen_t							len = sizeof(sa);
+
+	getsockname(fd, reinterpret_cast<struct sockaddr *>(&sa), &len);
+	return nw::addr<nw::sa_family::INET>(sa);
+}
+
+static void		_nodelay(inet_stream &sock) {
+	int32_t	one = 1;
+
+	setsockopt(sock.get_fd(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+//! @brief Send back every byte received until the peer closes
+static nw::task	_echo(nw::io_loop &loop, inet_stream sock) {
+	co_inet_stream				s(loop, sock);
+	nw::ibuffer<BUFFER_SIZE>	ib;
+	nw::obuffer<BUFFER_SIZE>	ob;
+	char						data[BUFFER_SIZE];
+
+	_nodelay(sock);
+	while (co_await s.recv(ib)) {
+		const nw::size_type	n = ib.in_avail();
+
+		ib.getn(data, n);
+		ob.putn(data, n);
+		while (!ob.is_empty())
+			co_await s.send(ob);
+	}
+}
+
+//! @brief Accept connections echo servers
+static nw::task	_serve(nw::io_loop &loop, inet_stream &listener, const nw::size_type connections) {
+	co_inet_stream	s(loop, listener);
+
+	for (nw::size_type i = 0; i != connections; ++i)
+		_echo(loop, co_await s.accept());
+}
+
+//! @brief Connect to addr and run rounds request/response exchanges of MSG_SIZE bytes
+static nw::task	_client(nw::io_loop &loop, const nw::addr<nw::sa_family::INET> addr, const uint64_t rounds, uint64_t &completed) {
+	inet_stream					sock("tcp");
+	co_inet_stream				s(loop, sock);
+	nw::ibuffer<BUFFER_SIZE>	ib;
+	nw::obuffer<BUFFER_SIZE>	ob;
+	char						msg[MSG_SIZE] = {};
+
+	co_await s.connect(addr);
+	_nodelay(sock);
+	for (uint64_t i = 0; i != rounds; ++i) {
+		ob.putn(msg, MSG_SIZE);
+		while (!ob.is_empty())
+			co_await s.send(ob);
+		while (ib.in_avail() < MSG_SIZE) {
+			if (!co_await s.recv(ib))
+				throw nw::logic_error("coroutine echo: connection closed");
+		}
+		ib.getn(msg, MSG_SIZE);
+		++completed;
+	}
+}
+
+static void		_echo_pingpong(const nw::size_type &connections, const uint64_t &rounds) {
+	nw::io_loop		loop;
+	inet_stream		listener("tcp");
+	uint64_t		completed = 0;
+
+	listener.bind(nw::addr<nw::sa_family::INET>(0, "127.0.0.1"));
+	listener.listen(connections);
+
+	const std::chrono::steady_clock::time_point	start = std::chrono::steady_clock::now();
+
+	_serve(loop, listener, connections);
+	for (nw::size_type i = 0; i != connections; ++i)
+		_client(loop, _local_addr(listener.get_fd()), rounds, completed);
+	loop.run();
+
+	const std::chrono::nanoseconds	elapsed = std::chrono::steady_clock::now() - start;
+
+	if (completed != connections * rounds)
+		throw nw::logic_error("coroutine echo: exchanges lost");
+	bench::report({"coroutine/echo_pingpong_" + std::to_string(MSG_SIZE) + "_c" + std::to_string(connections),
+		completed, static_cast<double>(elapsed.count()) / static_cast<double>(completed), MSG_SIZE * 2});
+}
+
+static nw::task	_noop(uint64_t &count) {
+	++count;
+	co_return ;
+}
+
+static bench::suite	_suite("coroutine", [](){
+	uint64_t	count = 0;
+
+	_echo_pingpong(1, 20000);
+	_echo_pingpong(16, 2000);
+
+	nw::frame_pool::release();
+	bench::run("coroutine/task_pooled", TASKS, [&](){
+		_noop(count);
+	});
+	if (!nw::frame_pool::cached())
+		throw nw::logic_error("coroutine: task frame not recycled");
+	bench::run("coroutine/task_heap", TASKS, [&](){
+		_noop(count);
+		nw::frame_pool::release();
+	});
+	bench::keep(count);
+});
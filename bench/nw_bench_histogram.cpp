@@ -0,0 +1,26 @@
+
+/*!
+@file nw_bench_histogram.cpp
+@brief nw::latency_histogram recording cost
+*/
+
+#include "nw_bench.hpp"
+#include "nw_histogram.hpp"
+
+static const uint64_t	ITERATIONS = 2000000;
+
+static bench::suite	_suite("histogram", [](){
+	static nw::latency_histogram	h;
+	uint64_t						v = 1;
+
+	bench::run("histogram/record", ITERATIONS, [&](){
+		v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+		h.record(v >> 30);
+	});
+	bench::run("histogram/scope", ITERATIONS, [&](){
+		const nw::latency_histogram::scope	s(h);
+	});
+	bench::run("histogram/percentile", 1000, [&](){
+		bench::keep(h.percentile(99.9));
+	});
+});
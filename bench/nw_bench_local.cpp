@@ -0,0 +1,167 @@
+
+/*!
+@file nw_bench_local.cpp
+@brief Shared memory channel and AF_LOCAL versus loopback AF_INET latency and throughput
+*/
+
+#include <thread>
+#include <utility>
+
+#include "nw_bench.hpp"
+#include "nw_socket.hpp"
+#include "nw_shm_channel.hpp"
+
+typedef nw::socket<nw::sa_family::LOCAL, nw::sock_type::STREAM>	local_stream;
+typedef nw::socket<nw::sa_family::LOCAL, nw::sock_type::DGRAM>	local_dgram;
+typedef nw::socket<nw::sa_family::INET, nw::sock_type::STREAM>	inet_stream;
+typedef nw::socket<nw::sa_family::INET, nw::sock_type::DGRAM>	inet_dgram;
+
+static const nw::size_type	BUFFER_SIZE = 1 << 16;
+
+typedef nw::shm_channel<BUFFER_SIZE>							shm_channel;
+
+static nw::addr<nw::sa_family::INET>	_local_addr(const nw::sockfd_type &fd) {
+	nw::addr<nw::sa_family::INET>::type	sa = {};
+	socklen_t							len = sizeof(sa);
+
+	getsockname(fd, reinterpret_cast<struct sockaddr *>(&sa), &len);
+	return nw::addr<nw::sa_family::INET>(sa);
+}
+
+static std::pair<inet_stream, inet_stream>	_inet_stream_pair(void) {
+	inet_stream	listener("tcp");
+	inet_stream	client("tcp");
+	int32_t		one = 1;
+
+	listener.bind(nw::addr<nw::sa_family::INET>(0, "127.0.0.1"));
+	listener.listen(1);
+	client.connect(_local_addr(listener.get_fd()));
+
+	inet_stream	server = listener.accept();
+
+	setsockopt(client.get_fd(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	setsockopt(server.get_fd(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return std::pair<inet_stream, inet_stream>(std::move(client), std::move(server));
+}
+
+static std::pair<inet_dgram, inet_dgram>	_inet_dgram_pair(void) {
+	inet_dgram	a("udp");
+	inet_dgram	b("udp");
+
+	a.bind(nw::addr<nw::sa_family::INET>(0, "127.0.0.1"));
+	b.bind(nw::addr<nw::sa_family::INET>(0, "127.0.0.1"));
+	a.connect(_local_addr(b.get_fd()));
+	b.connect(_local_addr(a.get_fd()));
+	return std::pair<inet_dgram, inet_dgram>(std::move(a), std::move(b));
+}
+
+template <typename S>
+static bool	_recv_n(S &s, nw::ibuffer<BUFFER_SIZE> &ib, const nw::size_type &n) {
+	while (ib.in_avail() < n) {
+		if (!s.recv(ib))
+			return false;
+	}
+	return true;
+}
+
+template <typename S>
+static void	_send_n(S &s, nw::obuffer<BUFFER_SIZE> &ob, const void *data, const nw::size_type &n) {
+	ob.putn(data, n);
+	while (!ob.is_empty())
+		s.send(ob);
+}
+
+template <typename S>
+static void	_pingpong(const std::string &name, S &client, S &server, const nw::size_type &msg_size, const uint64_t &count) {
+	std::thread	echo([&server, msg_size, count](){
+		nw::ibuffer<BUFFER_SIZE>	ib;
+		nw::obuffer<BUFFER_SIZE>	ob;
+		static char					msg[BUFFER_SIZE];
+
+		for (uint64_t i = 0; i != count && _recv_n(server, ib, msg_size); ++i) {
+			ib.getn(msg, msg_size);
+			_send_n(server, ob, msg, msg_size);
+		}
+	});
+	nw::ibuffer<BUFFER_SIZE>	ib;
+	nw::obuffer<BUFFER_SIZE>	ob;
+	static char					msg[BUFFER_SIZE];
+
+	bench::run(name + "_pingpong_" + std::to_string(msg_size), count, [&](){
+		_send_n(client, ob, msg, msg_size);
+		_recv_n(client, ib, msg_size);
+		ib.getn(msg, msg_size);
+	}, msg_size * 2);
+	echo.join();
+}
+
+template <typename S>
+static void	_throughput(const std::string &name, S &client, S &server, const nw::size_type &chunk_size, const uint64_t &count) {
+	const std::chrono::steady_clock::time_point	start = std::chrono::steady_clock::now();
+	std::thread	sink([&server, chunk_size, count](){
+		nw::ibuffer<BUFFER_SIZE>	ib;
+		uint64_t					left = chunk_size * count;
+
+		while (left) {
+			nw::size_type	n = server.recv(ib);
+
+			if (!n || n == nw::npos)
+				break ;
+			left -= std::min<uint64_t>(n, left);
+			ib.clear();
+		}
+	});
+	nw::obuffer<BUFFER_SIZE>	ob;
+	static char					chunk[BUFFER_SIZE];
+
+	for (uint64_t i = 0; i != count; ++i)
+		_send_n(client, ob, chunk, chunk_size);
+	sink.join();
+
+	const std::chrono::nanoseconds	elapsed = std::chrono::steady_clock::now() - start;
+
+	bench::report({name + "_throughput_" + std::to_string(chunk_size), count, static_cast<double>(elapsed.count()) / static_cast<double>(count), chunk_size});
+}
+
+static bench::suite	_suite("local_vs_loopback", [](){
+	const uint64_t	pingpongs = 20000;
+	const uint64_t	chunks = 20000;
+
+	for (const nw::shm_wakeup &wakeup : {nw::shm_wakeup::EVENTFD, nw::shm_wakeup::SPIN}) {
+		std::pair<local_stream, local_stream>	p = local_stream::pair();
+		shm_channel								client(p.first, wakeup);
+		shm_channel								server(p.second);
+		const std::string						name = (wakeup == nw::shm_wakeup::SPIN) ? "shm_spin" : "shm_eventfd";
+
+		_pingpong("local_vs_loopback/" + name, client, server, 64, pingpongs);
+		_throughput("local_vs_loopback/" + name, client, server, 16384, chunks);
+	}
+	{
+		std::pair<local_stream, local_stream>	p = local_stream::pair();
+		_pingpong("local_vs_loopback/local_stream", p.first, p.second, 64, pingpongs);
+	}
+	{
+		std::pair<inet_stream, inet_stream>		p = _inet_stream_pair();
+		_pingpong("local_vs_loopback/inet_stream", p.first, p.second, 64, pingpongs);
+	}
+	{
+		std::pair<local_dgram, local_dgram>		p = local_dgram::pair();
+		_pingpong("local_vs_loopback/local_dgram", p.first, p.second, 64, pingpongs);
+	}
+	{
+		std::pair<inet_dgram, inet_dgram>		p = _inet_dgram_pair();
+		_pingpong("local_vs_loopback/inet_dgram", p.first, p.second, 64, pingpongs);
+	}
+	{
+		std::pair<local_stream, local_stream>	p = local_stream::pair();
+		_throughput("local_vs_loopback/local_stream", p.first, p.second, 16384, chunks);
+	}
+	{
+		std::pair<inet_stream, inet_stream>		p = _inet_stream_pair();
+		_throughput("local_vs_loopback/inet_stream", p.first, p.second, 16384, chunks);
+	}
+	{
+		std::pair<local_dgram, local_dgram>		p = local_dgram::pair();
+		_throughput("local_vs_loopback/local_dgram", p.first, p.second, 16384, chunks);
+	}
+});
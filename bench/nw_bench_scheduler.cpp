@@ -0,0 +1,198 @@
+
+/*!
+@file nw_bench_scheduler.cpp
+@brief Skewed request load processed on the I/O thread versus offloaded to the work-stealing nw::scheduler
+*/
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstring>
+
+#include "nw_bench.hpp"
+#include "nw_socket.hpp"
+#include "nw_poller.hpp"
+#include "nw_scheduler.hpp"
+
+typedef nw::socket<nw::sa_family::LOCAL, nw::sock_type::SEQPACKET>	seqpacket;
+typedef nw::record_batch<16, 64>									batch;
+
+static const nw::size_type	IO_THREADS = 2;
+static const nw::size_type	CONNECTIONS = 8;
+static const nw::size_type	WINDOW = 8;			//!< outstanding requests per connection
+static const uint64_t		REQUESTS = 20000;
+static const uint64_t		HOT_PERCENT = 70;	//!< share of the requests sent on connection 0
+static const uint64_t		WORK = 2000;		//!< request processing cost, in hash rounds
+
+//! @brief Simulated request processing
+static uint64_t	_work(uint64_t seed) {
+	for (uint64_t i = 0; i != WORK; ++i) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+	}
+	return seed;
+}
+
+//! @brief Connection server side, owned by one I/O thread
+struct	connection {
+	seqpacket	sock;
+	batch		out;
+
+	explicit connection(seqpacket &&s) : sock(std::move(s)), out() {}
+
+	void	respond(const uint64_t &result) {
+		this->out.push(&result, sizeof(result));
+		this->sock.send_records(this->out);
+	}
+};
+
+//! @brief I/O thread loop: read requests of its connections and process them inline or on sched
+static void	_io_thread(std::vector<connection *> conns, nw::scheduler *sched, const std::atomic<bool> &stop) {
+	nw::poller		poller;
+	nw::mailbox		mailbox;
+	batch			in;
+
+	poller.add(mailbox.get_fd(), nw::poller::IN);
+	for (nw::size_type i = 0; i != conns.size(); ++i)
+		poller.add(conns[i]->sock.get_fd(), nw::poller::IN);
+	while (!stop.load(std::memory_order_relaxed)) {
+		poller.wait(nw::msec_type(10));
+		for (nw::poller::const_iterator ev = poller.begin(); ev != poller.end(); ++ev) {
+			if (ev->data.fd == mailbox.get_fd()) {
+				mailbox.drain();
+				continue ;
+			}
+			for (connection *c : conns) {
+				if (c->sock.get_fd() != ev->data.fd)
+					continue ;
+				c->sock.recv_records(in, MSG_DONTWAIT);
+				in.for_each([c, sched, &mailbox](const nw::record &r){
+					uint64_t	seed;
+
+					std::memcpy(&seed, r.data, sizeof(seed));
+					if (!sched)
+						return c->respond(_work(seed));
+					sched->submit([c, seed, &mailbox](){
+						const uint64_t	result = _work(seed);
+
+						mailbox.post([c, result](){ c->respond(result); });
+					});
+				});
+			}
+		}
+	}
+	if (sched)
+		sched->wait_idle();
+	mailbox.drain();
+}
+
+//! @brief Closed loop client: keep WINDOW requests in flight per connection until its budget is sent
+static void	_client(std::vector<seqpacket> &clients) {
+	nw::poller				poller;
+	std::vector<uint64_t>	budget(CONNECTIONS);
+	std::vector<uint64_t>	sent(CONNECTIONS, 0);
+	uint64_t				received = 0;
+	batch					in;
+	batch					out;
+
+	for (nw::size_type i = 0; i != CONNECTIONS; ++i) {
+		budget[i] = (!i) ? REQUESTS * HOT_PERCENT / 100 : REQUESTS * (100 - HOT_PERCENT) / 100 / (CONNECTIONS - 1);
+		poller.add(clients[i].get_fd(), nw::poller::IN);
+	}
+	auto	send = [&](const nw::size_type &i){
+		const uint64_t	seed = sent[i] + 1;
+
+		out.push(&seed, sizeof(seed));
+		clients[i].send_records(out);
+		++sent[i];
+	};
+	uint64_t	total = 0;
+
+	for (nw::size_type i = 0; i != CONNECTIONS; ++i) {
+		total += budget[i];
+		for (nw::size_type w = 0; w != WINDOW && sent[i] != budget[i]; ++w)
+			send(i);
+	}
+	while (received != total) {
+		poller.wait(nw::msec_type(100));
+		for (nw::poller::const_iterator ev = poller.begin(); ev != poller.end(); ++ev) {
+			for (nw::size_type i = 0; i != CONNECTIONS; ++i) {
+				if (clients[i].get_fd() != ev->data.fd)
+					continue ;
+				received += clients[i].recv_records(in, MSG_DONTWAIT);
+				for (nw::size_type n = 0; n != in.size() && sent[i] != budget[i]; ++n)
+					send(i);
+			}
+		}
+	}
+}
+
+static void	_skewed(const std::string &name, const bool &offload) {
+	std::vector<seqpacket>						clients;
+	std::vector<std::unique_ptr<connection> >	servers;
+	std::unique_ptr<nw::scheduler>				sched((offload) ? new nw::scheduler(IO_THREADS) : nullptr);
+	std::vector<std::thread>					threads;
+	std::atomic<bool>							stop(false);
+
+	for (nw::size_type i = 0; i != CONNECTIONS; ++i) {
+		std::pair<seqpacket, seqpacket>	p = seqpacket::pair();
+
+		p.second.set_nonblocking(true);
+		clients.push_back(std::move(p.first));
+		servers.push_back(std::unique_ptr<connection>(new connection(std::move(p.second))));
+	}
+
+	const std::chrono::steady_clock::time_point	start = std::chrono::steady_clock::now();
+
+	for (nw::size_type t = 0; t != IO_THREADS; ++t) {
+		std::vector<connection *>	owned;
+
+		for (nw::size_type i = t; i < CONNECTIONS; i += IO_THREADS)
+			owned.push_back(servers[i].get());
+		threads.push_back(std::thread(_io_thread, owned, sched.get(), std::cref(stop)));
+	}
+	_client(clients);
+
+	const std::chrono::nanoseconds	elapsed = std::chrono::steady_clock::now() - start;
+
+	stop.store(true);
+	for (std::thread &t : threads)
+		t.join();
+	bench::report({name, REQUESTS, static_cast<double>(elapsed.count()) / static_cast<double>(REQUESTS), sizeof(uint64_t)});
+}
+
+static bench::suite	_suite("scheduler", [](){
+	{
+		nw::scheduler			sched(IO_THREADS);
+		std::atomic<uint64_t>	count(0);
+
+		bench::run("scheduler/submit", 100000, [&](){
+			sched.submit([&count](){ count.fetch_add(1, std::memory_order_relaxed); });
+		});
+		sched.wait_idle();
+	}
+	{
+		nw::scheduler			sched(IO_THREADS);
+		std::atomic<uint64_t>	count(0);
+		std::function<void(int)>	tree = [&](int depth){
+			count.fetch_add(1, std::memory_order_relaxed);
+			if (!depth)
+				return ;
+			sched.spawn([&tree, depth](){ tree(depth - 1); });
+			sched.spawn([&tree, depth](){ tree(depth - 1); });
+		};
+		const std::chrono::steady_clock::time_point	start = std::chrono::steady_clock::now();
+
+		sched.submit([&tree](){ tree(16); });
+		sched.wait_idle();
+
+		const std::chrono::nanoseconds	elapsed = std::chrono::steady_clock::now() - start;
+
+		bench::report({"scheduler/spawn_tree", count.load(), static_cast<double>(elapsed.count()) / static_cast<double>(count.load()), 0});
+	}
+	_skewed("scheduler/skewed_run_on_io_thread", false);
+	_skewed("scheduler/skewed_work_stealing", true);
+});
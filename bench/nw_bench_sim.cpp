@@ -0,0 +1,140 @@
+/*!
+@file nw_bench_sim.cpp
+@brief nw::socket and buffer overhead over the in-process nw::sim_network backend, without kernel noise
+*/
+
+#include "nw_bench.hpp"
+#include "nw_socket.hpp"
+#include "nw_sim_network.hpp"
+
+typedef nw::socket<nw::sa_family::LOCAL, nw::sock_type::STREAM>	local_stream;
+typedef nw::socket<nw::sa_family::INET, nw::sock_type::STREAM>	inet_stream;
+
+static const nw::size_type	BUFFER_SIZE = 1 << 14;
+static const nw::size_type	MAX_PAYLOAD = 1024;
+static const uint64_t		ITERATIONS = 2000000;
+
+static void	_send_recv(const nw::size_type &n) {
+	nw::sim_network						net;
+	net.install();
+	std::pair<local_stream, local_stream>	pair = local_stream::pair();
+	nw::obuffer<BUFFER_SIZE>			out;
+	nw::ibuffer<BUFFER_SIZE>			in;
+	static char							data[BUFFER_SIZE];
+
+	bench::run("sim/send_recv_" + std::to_string(n), ITERATIONS, [&](){
+		out.putn(data, n);
+		bench::keep(pair.first.send(out, 0, std::nothrow));
+		bench::keep(pair.second.recv(in, 0, std::nothrow));
+		bench::keep(in.getn(data, n));
+	}, n);
+}
+
+//! @brief Length prefixed frames parsed from a nw::ibuffer
+class	frame_reader {
+	public:
+		uint64_t	frames = 0;
+		uint64_t	checksum = 0;
+
+		void	parse(nw::ibuffer<BUFFER_SIZE> &in) {
+			while (true) {
+				if (!this->_expected) {
+					uint8_t	header[4];
+
+					if (in.in_avail() < sizeof(header))
+						return ;
+					in.getn(header, sizeof(header));
+					this->_expected = (header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+				}
+				if (in.in_avail() < this->_expected)
+					return ;
+				in.getn(this->_payload, this->_expected);
+				for (uint32_t i = 0; i != this->_expected; ++i)
+					this->checksum = this->checksum * 31 + this->_payload[i];
+				++this->frames;
+				this->_expected = 0;
+			}
+		}
+
+	protected:
+		uint32_t	_expected = 0;
+		uint8_t		_payload[MAX_PAYLOAD];
+};
+
+//! @brief Frames of pseudo random sizes through partial writes, short reads and injected EAGAIN, checked end to end
+static void	_framing(void) {
+	nw::sim_network							net;
+	net.install();
+	std::pair<local_stream, local_stream>	pair = local_stream::pair();
+	nw::obuffer<BUFFER_SIZE>				out;
+	nw::ibuffer<BUFFER_SIZE>				in;
+	frame_reader							reader;
+	uint8_t									frame[4 + MAX_PAYLOAD];
+	uint64_t								frames = 0;
+	uint64_t								checksum = 0;
+	uint64_t								bytes = 0;
+	uint32_t								seed = 2463534242;
+
+	net.set_faults(pair.first.get_fd(), {100, 0, 7, 0});
+	net.set_faults(pair.second.get_fd(), {0, 333, 5, 0});
+
+	const bench::result	r = bench::run("sim/framing_faults", ITERATIONS, [&](){
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		const uint32_t	size = 1 + seed % MAX_PAYLOAD;
+
+		if (out.out_avail() >= 4 + size) {
+			frame[0] = size >> 24;
+			frame[1] = size >> 16;
+			frame[2] = size >> 8;
+			frame[3] = size;
+			for (uint32_t i = 0; i != size; ++i) {
+				frame[4 + i] = static_cast<uint8_t>(seed + i);
+				checksum = checksum * 31 + frame[4 + i];
+			}
+			out.putn(frame, 4 + size);
+			bytes += 4 + size;
+			++frames;
+		}
+		pair.first.send(out, 0, std::nothrow);
+		pair.second.recv(in, 0, std::nothrow);
+		reader.parse(in);
+	});
+
+	while (reader.frames != frames) {
+		pair.first.send(out, 0, std::nothrow);
+		pair.second.recv(in, 0, std::nothrow);
+		reader.parse(in);
+	}
+	if (reader.checksum != checksum)
+		throw nw::logic_error("sim/framing_faults: frame stream corrupted");
+	bench::report({"sim/framing_faults_per_frame", frames, r.ns_per_op * r.iterations / frames, bytes / frames});
+}
+
+static void	_connect_accept(void) {
+	nw::sim_network						net;
+	net.install();
+	const nw::addr<nw::sa_family::INET>	addr(8080, "127.0.0.1");
+	inet_stream							listener(0);
+
+	listener.bind(addr);
+	listener.listen(SOMAXCONN);
+	bench::run("sim/connect_accept_close", ITERATIONS / 4, [&](){
+		inet_stream	client(0);
+
+		client.connect(addr);
+
+		inet_stream	server = listener.accept();
+
+		bench::keep(server.get_fd());
+	});
+}
+
+static bench::suite	_suite("sim", [](){
+	for (const int &n : {8, 64, 512, 4096})
+		_send_recv(n);
+	_framing();
+	_connect_accept();
+});
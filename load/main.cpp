@@ -0,0 +1,185 @@
+/*!
+@file main.cpp
+@brief Load generator driver, output the nw::load_report as a json line
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/resource.h>
+
+#include "nw_load_generator.hpp"
+
+struct	options {
+	nw::load_config	config;
+	std::string		target;
+	bool			hgrm;	//!< print the latency distribution in HdrHistogram format
+	bool			echo;	//!< serve the target from an in process echo server
+};
+
+static void	_usage(const char *name) {
+	std::cerr << "usage: " << name << " [options] <ipv4:port | [ipv6]:port | unix:path>" << std::endl
+		<< "  -m closed|open  load mode (closed)" << std::endl
+		<< "  -c count        connections, 1 to " << nw::load_config::MAX_CONNECTIONS << " (1)" << std::endl
+		<< "  -t count        client threads (1)" << std::endl
+		<< "  -q bytes        request size (64)" << std::endl
+		<< "  -s bytes        response size, 0 for a sink (64)" << std::endl
+		<< "  -p depth        closed loop requests in flight per connection (1)" << std::endl
+		<< "  -r rate         open loop requests per second" << std::endl
+		<< "  -d seconds      recorded duration (10)" << std::endl
+		<< "  -w seconds      warmup (1)" << std::endl
+		<< "  -i usec         closed loop expected interval, 0 for the run mean, none for a sink (0)" << std::endl
+		<< "  -H              print the latency distribution in HdrHistogram format" << std::endl
+		<< "  -E              serve the target from an in process echo server" << std::endl;
+}
+
+//! @brief Raise the soft file descriptor limit to the hard one when connections need it
+static void	_raise_nofile(const nw::size_type &connections) {
+	struct rlimit	lim;
+
+	if (getrlimit(RLIMIT_NOFILE, &lim) == -1 || lim.rlim_cur >= connections + 64)
+		return ;
+	lim.rlim_cur = std::min<rlim_t>(lim.rlim_max, connections + 64);
+	if (setrlimit(RLIMIT_NOFILE, &lim) == -1)
+		throw nw::system_error(errno, std::generic_category(), "setrlimit");
+}
+
+//! @brief Single threaded echo server, enough to profile the library end to end on loopback
+template <nw::sa_family FAMILY>
+static void	_echo(nw::socket<FAMILY, nw::sock_type::STREAM> &listener, const std::atomic<bool> &stop) {
+	typedef nw::socket<FAMILY, nw::sock_type::STREAM>	socket_type;
+
+	nw::poller										events(256);
+	std::map<nw::sockfd_type, std::unique_ptr<socket_type> >	peers;
+	nw::ibuffer<16384>								in;
+	nw::obuffer<16384>								out;
+	uint8_t											data[16384];
+
+	events.add(listener.get_fd(), nw::poller::IN);
+	while (!stop.load()) {
+		events.wait(nw::msec_type(10));
+		for (nw::poller::const_iterator ev = events.begin(); ev != events.end(); ++ev) {
+			if (ev->data.fd == listener.get_fd()) {
+				std::unique_ptr<socket_type>	peer(new socket_type(listener.accept()));
+
+				events.add(peer->get_fd(), nw::poller::IN);
+				peers[peer->get_fd()] = std::move(peer);
+				continue ;
+			}
+
+			socket_type		&peer = *peers[ev->data.fd];
+			nw::size_type	ret;
+
+			in.clear();
+			ret = peer.recv(in, MSG_DONTWAIT, std::nothrow);
+			if (ret == nw::npos && (errno == EAGAIN || errno == EWOULDBLOCK))
+				continue ;
+			if (ret == nw::npos || !ret) {
+				events.remove(ev->data.fd, std::nothrow);
+				peers.erase(ev->data.fd);
+				continue ;
+			}
+			out.putn(data, in.getn(data, ret));
+			while (!out.is_empty())
+				if (peer.send(out, MSG_NOSIGNAL, std::nothrow) == nw::npos)
+					break ;
+			out.clear();
+		}
+	}
+}
+
+template <nw::sa_family FAMILY>
+static int	_run(const nw::addr<FAMILY> &target, const options &opts) {
+	std::unique_ptr<nw::socket<FAMILY, nw::sock_type::STREAM> >	listener;
+	std::atomic<bool>											stop(false);
+	std::thread													server;
+
+	if (opts.echo) {
+		listener.reset(new nw::socket<FAMILY, nw::sock_type::STREAM>(0));
+		listener->bind(target);
+		listener->listen(SOMAXCONN);
+		server = std::thread(_echo<FAMILY>, std::ref(*listener), std::cref(stop));
+	}
+
+	nw::load_report	report;
+
+	try {
+		report = nw::load_generator<FAMILY>(target, opts.config).run();
+	} catch (...) {
+		stop.store(true);
+		if (server.joinable())
+			server.join();
+		throw ;
+	}
+	stop.store(true);
+	if (server.joinable())
+		server.join();
+	std::cout << report << std::endl;
+	if (opts.hgrm)
+		std::cout << report.latency.to_hgrm();
+	return (report.responses) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int	main(int ac, char *av[]) try {
+	options	opts;
+	int		opt;
+
+	opts.hgrm = false;
+	opts.echo = false;
+	while ((opt = getopt(ac, av, "m:c:t:q:s:p:r:d:w:i:HE")) != -1) {
+		switch (opt) {
+			case 'm':
+				if (std::strcmp(optarg, "open") && std::strcmp(optarg, "closed"))
+					return _usage(av[0]), EXIT_FAILURE;
+				opts.config.mode = (std::strcmp(optarg, "open")) ? nw::load_mode::CLOSED : nw::load_mode::OPEN;
+				break ;
+			case 'c':	opts.config.connections = std::strtoull(optarg, nullptr, 10);				break ;
+			case 't':	opts.config.threads = std::strtoull(optarg, nullptr, 10);					break ;
+			case 'q':	opts.config.request_size = std::strtoull(optarg, nullptr, 10);				break ;
+			case 's':	opts.config.response_size = std::strtoull(optarg, nullptr, 10);				break ;
+			case 'p':	opts.config.pipeline = std::strtoull(optarg, nullptr, 10);					break ;
+			case 'r':	opts.config.rate = std::strtoull(optarg, nullptr, 10);						break ;
+			case 'd':	opts.config.duration = nw::msec_type(static_cast<int64_t>(std::strtod(optarg, nullptr) * 1000));	break ;
+			case 'w':	opts.config.warmup = nw::msec_type(static_cast<int64_t>(std::strtod(optarg, nullptr) * 1000));		break ;
+			case 'i':	opts.config.expected_interval = std::strtoull(optarg, nullptr, 10) * 1000;	break ;
+			case 'H':	opts.hgrm = true;															break ;
+			case 'E':	opts.echo = true;															break ;
+			default:
+				return _usage(av[0]), EXIT_FAILURE;
+		}
+	}
+	if (optind + 1 != ac)
+		return _usage(av[0]), EXIT_FAILURE;
+	opts.target = av[optind];
+	opts.config.validate();
+	_raise_nofile(opts.config.connections);
+
+	if (!opts.target.compare(0, 5, "unix:")) {
+		const std::string	path = opts.target.substr(5);
+
+		if (opts.echo)
+			unlink(path.c_str());
+		return _run<nw::sa_family::LOCAL>(nw::addr<nw::sa_family::LOCAL>(path), opts);
+	}
+
+	const std::string::size_type	colon = opts.target.rfind(':');
+
+	if (colon == std::string::npos)
+		return _usage(av[0]), EXIT_FAILURE;
+
+	const nw::port_type	port = static_cast<nw::port_type>(std::strtoul(opts.target.c_str() + colon + 1, nullptr, 10));
+
+	if (opts.target[0] == '[')
+		return _run<nw::sa_family::INET6>(nw::addr<nw::sa_family::INET6>(port, opts.target.substr(1, colon - 2)), opts);
+	return _run<nw::sa_family::INET>(nw::addr<nw::sa_family::INET>(port, opts.target.substr(0, colon)), opts);
+} catch (const std::exception &e) {
+	std::cerr << "Exception: " << e.what() << std::endl;
+	return EXIT_FAILURE;
+}
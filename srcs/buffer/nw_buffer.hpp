@@ -12,38 +12,49 @@
 # include <cstring>
 # include <cctype>
 
+# include <sys/uio.h>
+
 # include "../nw_typedef.hpp"
+# include "../nw_format.hpp"
 
 namespace nw {
 	template <size_type SIZE>
 	class buffer {
 		public:
 			typedef std::function<ssize_t(void *, size_type)>	sync_fct_t;
+			typedef std::function<ssize_t(struct iovec *, size_type)>	syncv_fct_t;
+			//! @brief Watermark crossing callback, called with true when the high watermark is reached, false when back to the low one
+			typedef std::function<void(bool)>	watermark_fct_t;
 
 			buffer(void)\
 				: _buf{0}, \
 				_is_full(false), \
-				_off{0, 0} {
+				_off{0, 0}, \
+				_throttled(false), \
+				_low(SIZE / 2), \
+				_high(SIZE) {
 			}
 
 			virtual	~buffer(void) {}
 
 			const std::string	to_string(void) const {
-				std::string str;
-
-				str = "{\"get_off\" : " + std::to_string(this->_off.get) + ", ";
-				str += "\"put_off\" : " + std::to_string(this->_off.put) + ", ";
-				str += "\"in_avail\" : " + std::to_string(this->in_avail()) + ", ";
-				str += "\"full\" : " + std::string((this->is_full()) ? "true" : "false") + ", ";
-				str += "\"data\" : [ ";
-				for (nw::size_type i = 0; i != this->size(); ++i) {
-					str += std::to_string(static_cast<uint8_t>(this->_buf[i]));
-					if (i + 1 != this->size())
-						str += ", ";
-				}
-				str += " ]}";
+				return format_string([this](formatter &f){ this->format(f, npos); }, 128 + 2 * SIZE);
+			}
 
-				return str;
+			//! @brief Write buffer state to a nw::formatter, without allocation
+			//! @details The storage is dumped in hexadecimal, cut after max bytes.
+			void				format(
+				formatter &f,				//!< destination
+				const size_type &max = 64	//!< maximum number of bytes dumped
+			) const {
+				f.begin_object();
+				f.key("get_off").value(static_cast<uint64_t>(this->_off.get));
+				f.key("put_off").value(static_cast<uint64_t>(this->_off.put));
+				f.key("in_avail").value(static_cast<uint64_t>(this->in_avail()));
+				f.key("full").value(this->is_full());
+				f.key("throttled").value(this->is_throttled());
+				f.key("data").hex(this->_buf, SIZE, max);
+				f.end_object();
 			}
 
 			inline size_type	size(void) const {
@@ -65,6 +76,48 @@ namespace nw {
 			void		clear(void) {
 				this->_off = {0, 0};
 				this->_is_full = false;
+				this->_watermark();
+			}
+
+			//! @brief Return the free space
+			inline size_type	out_avail(void) const {
+				return SIZE - this->in_avail();
+			}
+
+			//! @brief Set the fill level watermarks driving nw::buffer::is_throttled
+			//! @details
+			//! The buffer is throttled once it holds high bytes or more, until it is drained to low bytes or less. fct, if any,
+			//! is called on each transition, from the call filling or draining the buffer:
+			//! - on a nw::ibuffer, stop reading the socket (poller interest, SO_RCVLOWAT) while throttled;
+			//! - on a nw::obuffer, stop reading the producer feeding it while throttled, the peer is not keeping up.
+			//!
+			//! Defaults are SIZE / 2 and SIZE.
+			//! @throw nw::logic_error if low > high or high > SIZE
+			void		set_watermarks(
+				const size_type &low,					//!< resume level, in bytes
+				const size_type &high,					//!< throttle level, in bytes
+				const watermark_fct_t &fct = nullptr	//!< transition callback
+			) {
+				if (low > high || high > SIZE)
+					throw logic_error("buffer: invalid watermarks");
+				this->_low = low;
+				this->_high = high;
+				this->_on_watermark = fct;
+				this->_throttled = false;
+				this->_watermark();
+			}
+
+			inline size_type	get_low_watermark(void) const {
+				return this->_low;
+			}
+
+			inline size_type	get_high_watermark(void) const {
+				return this->_high;
+			}
+
+			//! @brief Return true from the high watermark is reached until the buffer is drained to the low watermark
+			inline bool		is_throttled(void) const {
+				return this->_throttled;
 			}
 
 			size_type	in_avail(void) const {
@@ -90,6 +143,7 @@ namespace nw {
 					this->_off.get += get_size;
 					if (this->_off.get == this->_off.put)
 						this->_off = {0, 0};
+					this->_watermark();
 					return get_size;
 				}
 
@@ -106,6 +160,7 @@ namespace nw {
 				}
 				if (this->_off.get == this->_off.put)
 					this->_off = {0, 0};
+				this->_watermark();
 				return gb_size + gf_size;
 			}
 
@@ -119,6 +174,7 @@ namespace nw {
 					this->_off.put += put_size;
 					if (this->_off.get == this->_off.put)
 						this->_is_full = true;
+					this->_watermark();
 					return put_size;
 				}
 
@@ -135,6 +191,7 @@ namespace nw {
 				}
 				if (this->_off.get == this->_off.put)
 					this->_is_full = true;
+				this->_watermark();
 				return pb_size + pf_size;
 			}
 
@@ -145,6 +202,25 @@ namespace nw {
 				pos_type	get;
 				pos_type	put;
 			}				_off;
+			bool			_throttled;
+			size_type		_low;
+			size_type		_high;
+			watermark_fct_t	_on_watermark;
+
+			//! @brief Update nw::buffer::is_throttled after the fill level changed
+			inline void		_watermark(void) {
+				if (!this->_throttled) {
+					if (this->in_avail() < this->_high)
+						return ;
+					this->_throttled = true;
+				} else {
+					if (this->in_avail() > this->_low)
+						return ;
+					this->_throttled = false;
+				}
+				if (this->_on_watermark)
+					this->_on_watermark(this->_throttled);
+			}
 
 		private:
 			buffer(const buffer &src) = delete;
@@ -10,6 +10,7 @@
 # include <string>
 
 # include "nw_buffer.hpp"
+# include "../nw_io_stats.hpp"
 
 namespace nw {
 	template <size_type SIZE>
@@ -19,8 +20,10 @@ namespace nw {
 			virtual	~ibuffer(void) {}
 
 			virtual size_type	sync(const typename nw::buffer<SIZE>::sync_fct_t fct) {
-				if (this->is_full())
+				if (this->is_full()) {
+					global_io_counters::add(io_counter::BUFFER_FULL);
 					return 0;
+				}
 				ssize_t ret = fct(&this->_buf[this->_off.put], (this->_off.put < this->_off.get) ? this->_off.get - this->_off.put : this->size() - this->_off.put);
 				if (!ret)
 					return 0;
@@ -29,6 +32,37 @@ namespace nw {
 				this->_off.put = (this->_off.put + ret) % this->size();
 				if (this->_off.get == this->_off.put)
 					this->_is_full = true;
+				this->_watermark();
+				return ret;
+			}
+
+			//! @brief Scatter/gather variant of sync, fct is given the whole free space as up to 2 iovec
+			size_type	syncv(const typename nw::buffer<SIZE>::syncv_fct_t fct) {
+				struct iovec	iov[2];
+				size_type		iovcnt = 1;
+
+				if (this->is_full()) {
+					global_io_counters::add(io_counter::BUFFER_FULL);
+					return 0;
+				}
+				iov[0].iov_base = &this->_buf[this->_off.put];
+				if (this->_off.put < this->_off.get)
+					iov[0].iov_len = this->_off.get - this->_off.put;
+				else {
+					iov[0].iov_len = this->size() - this->_off.put;
+					iov[1].iov_base = this->_buf;
+					iov[1].iov_len = this->_off.get;
+					iovcnt = (this->_off.get) ? 2 : 1;
+				}
+				ssize_t ret = fct(iov, iovcnt);
+				if (!ret)
+					return 0;
+				if (!(ret > 0))
+					return nw::npos;
+				this->_off.put = (this->_off.put + ret) % this->size();
+				if (this->_off.get == this->_off.put)
+					this->_is_full = true;
+				this->_watermark();
 				return ret;
 			}
 
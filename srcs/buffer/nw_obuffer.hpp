@@ -26,9 +26,40 @@ namespace nw {
 					return 0;
 				if (!(ret > 0))
 					return nw::npos;
+				this->_is_full = false;
 				this->_off.get = (this->_off.get + ret) % this->size();
 				if (this->_off.get == this->_off.put)
 					this->_off = {0, 0};
+				this->_watermark();
+				return ret;
+			}
+
+			//! @brief Scatter/gather variant of sync, fct is given every pending byte as up to 2 iovec
+			size_type	syncv(const typename nw::buffer<SIZE>::syncv_fct_t fct) {
+				struct iovec	iov[2];
+				size_type		iovcnt = 1;
+
+				if (this->is_empty())
+					return 0;
+				iov[0].iov_base = &this->_buf[this->_off.get];
+				if (this->_off.get < this->_off.put)
+					iov[0].iov_len = this->_off.put - this->_off.get;
+				else {
+					iov[0].iov_len = this->size() - this->_off.get;
+					iov[1].iov_base = this->_buf;
+					iov[1].iov_len = this->_off.put;
+					iovcnt = (this->_off.put) ? 2 : 1;
+				}
+				ssize_t ret = fct(iov, iovcnt);
+				if (!ret)
+					return 0;
+				if (!(ret > 0))
+					return nw::npos;
+				this->_is_full = false;
+				this->_off.get = (this->_off.get + ret) % this->size();
+				if (this->_off.get == this->_off.put)
+					this->_off = {0, 0};
+				this->_watermark();
 				return ret;
 			}
 
@@ -1,131 +1,526 @@
+/*!
+@file main.cpp
+@brief Reference echo and sink server, one engine per I/O model, output the process I/O counters as a json line on exit
+@details System calls count the socket calls and the waits of the engines, epoll_wait(2) or io_uring_enter(2).
+*/
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include <unistd.h>
+#include <getopt.h>
+#include <signal.h>
+#include <poll.h>
 
-//#include "nw_addr.hpp"
-//#include "nw_addrinfo.hpp"
-//#include "nw_protoent.hpp"
 #include "buffer/nw_ibuffer.hpp"
 #include "buffer/nw_obuffer.hpp"
+#include "nw_socket.hpp"
+#include "nw_poller.hpp"
+#include "nw_io_ring.hpp"
+#include "nw_io_stats.hpp"
+#include "nw_format.hpp"
 
-//#include <unistd.h>
-//#include <sys/types.h>
-//#include <sys/socket.h>
-//#include <netinet/in.h>
-//#include <arpa/inet.h>
-//
-//#include <sys/socket.h>
+//! @enum engine
+enum class	engine : uint8_t {
+	BLOCKING,	//!< thread per connection, blocking recv(2) and send(2)
+	READINESS,	//!< event loop per thread, nw::poller and non-blocking sockets
+	BUSY_POLL,	//!< readiness loop spinning on empty polls, SO_BUSY_POLL on inet sockets
+	COMPLETION	//!< event loop per thread, operations queued on a nw::io_ring
+};
 
-#include "nw_socket.hpp"
+//! @enum workload
+enum class	workload : uint8_t {
+	ECHO,		//!< send back every byte received
+	SINK		//!< discard every byte received
+};
 
-int	main(int ac, char *av[]) try {
-	//close
-
-	//setsockopt
-
-	//recv
-
-	//sendto
-	//recvfrom
-
-//	int fd = socket(AF_INET, SOCK_STREAM, 6);
-//
-//	struct sockaddr_in addr = {
-//		AF_INET,
-//		htons(80),
-//		{0},
-//		{0}
-//	};
-//
-//	inet_aton("192.168.1.9", &addr.sin_addr);
-//
-//	connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
-//
-//	nw::buffer<30>	b(nw::buffer<30>::dir::in, [fd](void *b, nw::size_type n){
-//			return read(fd, b, n);;
-//		});
-//
-//	char c[31] = {0};
-//	while (!b.eof()) {
-//		std::cout << "================================" << std::endl;
-//		b.sync();
-////		std::cout << b << std::endl;
-//		nw::size_type bc = b.in_avail();
-//		b.getn(c, bc);
-//		c[bc] = '\0';
-//		std::cout << c;
-//		std::cout << b << std::endl;
-//	}
-//
-//	b.clear();
-
-//	nw::ibuffer<38> i;
-
-//	i.putn("Hello world !", 13);
-//	std::cout << i << std::endl;
-
-	nw::obuffer<38> o;
-//	std::cout << (o << 0xFFFFFF00) << std::endl;
-
-//	std::cout << nw::addrinfo<nw::sa_family::INET>("80", "google.fr", "tcp") << std::endl;
-//	std::cout << nw::addrinfo<nw::sa_family::INET6V4M>("80", "google.fr", "tcp") << std::endl;
-//	std::cout << nw::addrinfo<nw::sa_family::UNSPEC>("80", "google.fr", 0, nw::sock_type::UNSPEC) << std::endl;
-
-	nw::socket<nw::sa_family::INET, nw::sock_type::STREAM> c("tcp");
-	c.connect({80, "127.0.0.1"});
-
-	o << "Hello world !" << '\n';
-	std::cout << o << std::endl;
-	std::cout << c << std::endl;
-	std::cout << "=====" << std::endl;
-	c.send(o);
-	std::cout << c << std::endl;
-	std::cout << "=====" << std::endl;
-	c.close();
-	std::cout << c << std::endl;
-	std::cout << "=====" << std::endl;
-	while(1) {}
-
-
-//	nw::socket<nw::sa_family::INET, nw::sock_type::STREAM>	so("tcp");
-//	std::cout << so << std::endl;
-//	so.bind(80);
-//	std::cout << so << std::endl;
-//	so.listen(10);
-//	std::cout << so << std::endl;
-//	std::cout << "=====" << std::endl;
-//	nw::socket<nw::sa_family::INET, nw::sock_type::STREAM> so0 = so.accept();
-//	std::cout << so0 << std::endl;
-//	std::cout << "=====" << std::endl;
-//	so0.send(o);
-//	so0.close();
-//	std::cout << so0 << std::endl;
-//	std::cout << "=====" << std::endl;
-//	nw::socket<nw::sa_family::INET, nw::sock_type::STREAM> so1 = so.accept();
-//	std::cout << so1 << std::endl;
-//	std::cout << "=====" << std::endl;
-//	nw::socket<nw::sa_family::INET6, nw::sock_type::STREAM> so2 = so.accept();
-//	std::cout << so2 << std::endl;
-
-
-//	nw::socket<nw::sa_family::UNSPEC, nw::sock_type::STREAM>	sc = std::move(so);
-//	std::cout << so << std::endl;
-//	std::cout << sc << std::endl;
-//
-//	nw::socket<nw::sa_family::INET6, nw::sock_type::STREAM>	sc0 = std::move(sc);
-//	std::cout << sc << std::endl;
-//	std::cout << sc0 << std::endl;
-
-
-
-
-
-//	std::cout << SO_REUSEADDR << std::endl;
+struct	options {
+	engine			eng;
+	workload		mode;
+	nw::size_type	threads;
+	int32_t			busy_poll;	//!< SO_BUSY_POLL microseconds, busy poll engine only
+	std::string		target;
+};
+
+static const nw::size_type	BUFFER_SIZE = 16384;
+static const nw::msec_type	TICK(100);	//!< longest wait before the stop flag is checked
+
+static std::atomic<bool>		_stop(false);
+static std::atomic<uint64_t>	_accepted(0);
+
+static const char *	_engine_names[] = {"blocking", "readiness", "busypoll", "completion"};
+static const char *	_workload_names[] = {"echo", "sink"};
+
+static void	_on_signal(int) {
+	_stop.store(true);
+}
+
+static void	_usage(const char *name) {
+	std::cerr << "usage: " << name << " [options] <ipv4:port | [ipv6]:port | unix:path>" << std::endl
+		<< "  -e blocking|readiness|busypoll|completion  I/O engine (readiness)" << std::endl
+		<< "  -m echo|sink    workload (echo)" << std::endl
+		<< "  -t count        event loop threads, ignored by the blocking engine (1)" << std::endl
+		<< "  -b usec         SO_BUSY_POLL duration of the busypoll engine (50)" << std::endl;
+}
+
+//! @brief Stop on SIGINT and SIGTERM, interrupting blocking system calls (no SA_RESTART)
+static void	_handle_signals(void) {
+	struct sigaction	sa = {};
+
+	sa.sa_handler = &_on_signal;
+	sigemptyset(&sa.sa_mask);
+	if (sigaction(SIGINT, &sa, nullptr) == -1 || sigaction(SIGTERM, &sa, nullptr) == -1)
+		throw nw::system_error(errno, std::generic_category(), "sigaction");
+	signal(SIGPIPE, SIG_IGN);
+}
+
+//! @brief Keep SIGINT and SIGTERM for the main thread, the only one waiting without timeout
+static void	_block_signals(void) {
+	sigset_t	set;
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+//! @brief Move as many bytes as fit from in to out
+static void	_transfer(nw::ibuffer<BUFFER_SIZE> &in, nw::obuffer<BUFFER_SIZE> &out) {
+	uint8_t			chunk[BUFFER_SIZE];
+	const nw::size_type	n = std::min(in.in_avail(), out.out_avail());
+
+	out.putn(chunk, in.getn(chunk, n));
+}
+
+//! @brief Thread per connection, the simplest model and the baseline of the others
+template <nw::sa_family FAMILY>
+class blocking_engine {
+	public:
+		typedef nw::socket<FAMILY, nw::sock_type::STREAM>	socket_type;
+
+		blocking_engine(socket_type &listener, const options &opts) \
+			: _listener(listener), _opts(opts), _mutex(), _idle(), _peers() {
+		}
+
+		void	run(void) {
+			while (!_stop.load()) {
+				std::shared_ptr<socket_type>	peer;
+
+				try {
+					peer.reset(new socket_type(this->_listener.accept()));
+				} catch (const nw::system_error &e) {
+					if (e.code().value() == EINTR || e.code().value() == ECONNABORTED)
+						continue ;
+					throw ;
+				}
+				++_accepted;
+				std::lock_guard<std::mutex>	lock(this->_mutex);
+
+				this->_peers.insert(peer.get());
+				std::thread(&blocking_engine::_serve, this, peer).detach();
+			}
+
+			std::unique_lock<std::mutex>	lock(this->_mutex);
+
+			for (typename std::set<socket_type *>::iterator it = this->_peers.begin(); it != this->_peers.end(); ++it)
+				(*it)->shutdown(SHUT_RDWR);
+			this->_idle.wait(lock, [this](){ return this->_peers.empty(); });
+		}
+
+	protected:
+		socket_type					&_listener;
+		const options				&_opts;
+		std::mutex					_mutex;
+		std::condition_variable		_idle;		//!< notified when _peers gets empty
+		std::set<socket_type *>		_peers;		//!< live connections, shut down on stop
+
+		void	_serve(std::shared_ptr<socket_type> peer) {
+			nw::ibuffer<BUFFER_SIZE>	in;
+			nw::obuffer<BUFFER_SIZE>	out;
+
+			_block_signals();
+			while (true) {
+				const nw::size_type	ret = peer->recv(in, 0, std::nothrow);
+
+				if (ret == nw::npos || !ret)
+					break ;
+				if (this->_opts.mode == workload::SINK) {
+					in.clear();
+					continue ;
+				}
+				_transfer(in, out);
+				while (!out.is_empty())
+					if (peer->send(out, MSG_NOSIGNAL, std::nothrow) == nw::npos)
+						break ;
+				if (!out.is_empty())
+					break ;
+			}
+
+			std::lock_guard<std::mutex>	lock(this->_mutex);
+
+			this->_peers.erase(peer.get());
+			if (this->_peers.empty())
+				this->_idle.notify_all();
+		}
+};
+
+//! @brief Event loop per thread sharing the listener, with back pressure: a connection is not read while its output is pending
+template <nw::sa_family FAMILY>
+class readiness_engine {
+	public:
+		typedef nw::socket<FAMILY, nw::sock_type::STREAM>	socket_type;
+
+		readiness_engine(socket_type &listener, const options &opts) \
+			: _listener(listener), _opts(opts), _busy(opts.eng == engine::BUSY_POLL) {
+		}
+
+		void	run(void) {
+			std::vector<std::thread>	threads;
+
+			this->_listener.set_nonblocking(true);
+			for (nw::size_type i = 1; i < this->_opts.threads; ++i)
+				threads.push_back(std::thread([this](){ _block_signals(); this->_loop(); }));
+			this->_loop();
+			for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+				it->join();
+		}
+
+	protected:
+		struct	connection {
+			socket_type					sock;
+			nw::ibuffer<BUFFER_SIZE>	in;
+			nw::obuffer<BUFFER_SIZE>	out;
+
+			explicit connection(socket_type &&s) : sock(std::move(s)), in(), out() {
+			}
+		};
+
+		socket_type		&_listener;
+		const options	&_opts;
+		const bool		_busy;
+
+		void	_loop(void) {
+			nw::poller									events(256);
+			std::vector<std::unique_ptr<connection> >	by_fd;
+
+			events.add(this->_listener.get_fd(), nw::poller::IN);
+			while (!_stop.load()) {
+				events.wait((this->_busy) ? nw::msec_type(0) : TICK);
+				nw::global_io_counters::add(nw::io_counter::SYSCALLS);
+				for (nw::poller::const_iterator ev = events.begin(); ev != events.end(); ++ev) {
+					if (ev->data.fd == this->_listener.get_fd()) {
+						this->_accept(events, by_fd);
+						continue ;
+					}
+					if (!this->_handle(events, *by_fd[ev->data.fd], ev->events)) {
+						events.remove(ev->data.fd, std::nothrow);
+						by_fd[ev->data.fd].reset();
+					}
+				}
+			}
+		}
+
+		void	_accept(nw::poller &events, std::vector<std::unique_ptr<connection> > &by_fd) {
+			while (true) {
+				std::unique_ptr<connection>	conn;
+
+				try {
+					conn.reset(new connection(this->_listener.accept()));
+				} catch (const nw::system_error &e) {
+					if (e.code().value() == EAGAIN || e.code().value() == EWOULDBLOCK)
+						return ;
+					if (e.code().value() == ECONNABORTED || e.code().value() == EINTR)
+						continue ;
+					throw ;
+				}
+				++_accepted;
+				conn->sock.set_nonblocking(true);
+				if (this->_busy && FAMILY != nw::sa_family::LOCAL) {
+					try {
+						conn->sock.set_busy_poll(this->_opts.busy_poll);
+					} catch (const nw::system_error &e) {
+						static std::once_flag	warned;
+
+						std::call_once(warned, [&e](){ std::cerr << "warning: SO_BUSY_POLL: " << e.code().message() << std::endl; });
+					}
+				}
 
+				const nw::sockfd_type	fd = conn->sock.get_fd();
+
+				if (by_fd.size() <= static_cast<nw::size_type>(fd))
+					by_fd.resize(fd + 1);
+				events.add(fd, nw::poller::IN);
+				by_fd[fd] = std::move(conn);
+			}
+		}
+
+		//! @return false once the connection is to be closed
+		bool	_handle(nw::poller &events, connection &conn, const uint32_t &ready) {
+			if ((ready & nw::poller::OUT) && !this->_flush(conn))
+				return false;
+			if (!conn.out.is_empty()) {
+				events.modify(conn.sock.get_fd(), nw::poller::IN | nw::poller::OUT);
+				return true;
+			}
+			if (ready & nw::poller::OUT)
+				events.modify(conn.sock.get_fd(), nw::poller::IN);
+			while (conn.out.is_empty()) {
+				const nw::size_type	ret = conn.sock.recv(conn.in, MSG_DONTWAIT, std::nothrow);
+
+				if (ret == nw::npos)
+					return errno == EAGAIN || errno == EWOULDBLOCK;
+				if (!ret)
+					return false;
+				if (this->_opts.mode == workload::SINK) {
+					conn.in.clear();
+					continue ;
+				}
+				_transfer(conn.in, conn.out);
+				if (!this->_flush(conn))
+					return false;
+				if (!conn.out.is_empty())
+					events.modify(conn.sock.get_fd(), nw::poller::IN | nw::poller::OUT);
+			}
+			return true;
+		}
+
+		//! @return false on send error
+		bool	_flush(connection &conn) {
+			while (!conn.out.is_empty())
+				if (conn.sock.send(conn.out, MSG_NOSIGNAL | MSG_DONTWAIT, std::nothrow) == nw::npos)
+					return errno == EAGAIN || errno == EWOULDBLOCK;
+			return true;
+		}
+};
+
+//! @brief Event loop per thread on a nw::io_ring, one operation in flight per connection: recv, then send of what was received
+template <nw::sa_family FAMILY>
+class completion_engine {
+	public:
+		typedef nw::socket<FAMILY, nw::sock_type::STREAM>	socket_type;
+
+		completion_engine(socket_type &listener, const options &opts) \
+			: _listener(listener), _opts(opts) {
+		}
+
+		void	run(void) {
+			std::vector<std::thread>	threads;
+
+			this->_listener.set_nonblocking(true);
+			for (nw::size_type i = 1; i < this->_opts.threads; ++i)
+				threads.push_back(std::thread([this](){ _block_signals(); this->_loop(); }));
+			this->_loop();
+			for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+				it->join();
+		}
+
+	protected:
+		static const uint64_t	LISTENER = 0;	//!< user_data of the listener poll, connections use their address
+
+		struct	connection {
+			socket_type		sock;
+			uint8_t			data[BUFFER_SIZE];
+			nw::size_type	len;	//!< bytes received and not sent yet
+			nw::size_type	off;	//!< bytes of data already sent
+
+			explicit connection(socket_type &&s) : sock(std::move(s)), len(0), off(0) {
+			}
+		};
+
+		socket_type		&_listener;
+		const options	&_opts;
+
+		void	_loop(void) {
+			std::vector<std::unique_ptr<connection> >	conns;	//!< declared before the ring, outlives operations in flight
+			nw::io_ring									ring(256);
+
+			this->_queue(ring, [this, &ring](){ return ring.poll(this->_listener.get_fd(), POLLIN, LISTENER); });
+			while (!_stop.load()) {
+				ring.submit(1, TICK);
+				ring.complete([this, &ring, &conns](const nw::io_completion &c){
+					if (c.user_data == LISTENER)
+						return this->_accept(ring, conns);
+
+					connection	*conn = reinterpret_cast<connection *>(c.user_data);
+
+					if (!this->_on_completion(ring, *conn, c.res)) {
+						const nw::sockfd_type	fd = conn->sock.get_fd();
+
+						conns[fd].reset();
+					}
+				});
+			}
+			nw::global_io_counters::add(nw::io_counter::SYSCALLS, ring.get_stats().enters);
+		}
+
+		//! @brief Queue an operation, handing the full submission ring over first if needed
+		template <typename F>
+		void	_queue(nw::io_ring &ring, const F &op) {
+			while (!op())
+				ring.submit();
+		}
+
+		void	_recv(nw::io_ring &ring, connection &conn) {
+			this->_queue(ring, [&ring, &conn](){
+				return ring.recv(conn.sock.get_fd(), conn.data, BUFFER_SIZE, reinterpret_cast<uint64_t>(&conn));
+			});
+		}
+
+		void	_send(nw::io_ring &ring, connection &conn) {
+			this->_queue(ring, [&ring, &conn](){
+				return ring.send(conn.sock.get_fd(), conn.data + conn.off, conn.len - conn.off, reinterpret_cast<uint64_t>(&conn), MSG_NOSIGNAL);
+			});
+		}
+
+		void	_accept(nw::io_ring &ring, std::vector<std::unique_ptr<connection> > &conns) {
+			while (true) {
+				std::unique_ptr<connection>	conn;
+
+				try {
+					conn.reset(new connection(this->_listener.accept()));
+				} catch (const nw::system_error &e) {
+					if (e.code().value() == EAGAIN || e.code().value() == EWOULDBLOCK)
+						break ;
+					if (e.code().value() == ECONNABORTED || e.code().value() == EINTR)
+						continue ;
+					throw ;
+				}
+				++_accepted;
+
+				const nw::sockfd_type	fd = conn->sock.get_fd();
+
+				if (conns.size() <= static_cast<nw::size_type>(fd))
+					conns.resize(fd + 1);
+				this->_recv(ring, *conn);
+				conns[fd] = std::move(conn);
+			}
+			this->_queue(ring, [this, &ring](){ return ring.poll(this->_listener.get_fd(), POLLIN, LISTENER); });
+		}
+
+		//! @return false once the connection is to be closed
+		bool	_on_completion(nw::io_ring &ring, connection &conn, const int32_t &res) {
+			if (res <= 0) {
+				if (res < 0)
+					nw::global_io_counters::error(-res);
+				return false;
+			}
+			if (conn.len) {
+				nw::global_io_counters::add(nw::io_counter::BYTES_OUT, res);
+				conn.off += res;
+				if (conn.off < conn.len)
+					return this->_send(ring, conn), true;
+				conn.len = conn.off = 0;
+				return this->_recv(ring, conn), true;
+			}
+			nw::global_io_counters::add(nw::io_counter::BYTES_IN, res);
+			if (this->_opts.mode == workload::SINK)
+				return this->_recv(ring, conn), true;
+			conn.len = res;
+			return this->_send(ring, conn), true;
+		}
+};
+
+template <nw::sa_family FAMILY>
+const uint64_t	completion_engine<FAMILY>::LISTENER;
+
+template <nw::sa_family FAMILY>
+static int	_run(const nw::addr<FAMILY> &target, const options &opts) {
+	nw::socket<FAMILY, nw::sock_type::STREAM>	listener(0);
+
+	if (FAMILY != nw::sa_family::LOCAL)
+		listener.set_reuseaddr(true);
+	listener.bind(target);
+	listener.listen(SOMAXCONN);
+	switch (opts.eng) {
+		case engine::BLOCKING:		blocking_engine<FAMILY>(listener, opts).run();		break ;
+		case engine::READINESS:
+		case engine::BUSY_POLL:		readiness_engine<FAMILY>(listener, opts).run();		break ;
+		case engine::COMPLETION:	completion_engine<FAMILY>(listener, opts).run();	break ;
+	}
+
+	std::cout << nw::format_string([&opts](nw::formatter &f){
+		f.begin_object();
+		f.key("engine").value(_engine_names[static_cast<uint8_t>(opts.eng)]);
+		f.key("workload").value(_workload_names[static_cast<uint8_t>(opts.mode)]);
+		f.key("threads").value(static_cast<uint64_t>((opts.eng == engine::BLOCKING) ? 0 : opts.threads));
+		f.key("accepted").value(_accepted.load());
+		const std::string	io = nw::global_io_counters::snapshot().to_string();
+
+		f.key("io").raw(io.c_str(), io.size());
+		f.end_object();
+	}) << std::endl;
 	return EXIT_SUCCESS;
-	static_cast<void>(ac);
-	static_cast<void>(av);
+}
+
+static bool	_parse_name(const char *arg, const char *names[], const nw::size_type &count, uint8_t &value) {
+	for (nw::size_type i = 0; i < count; ++i)
+		if (!std::strcmp(arg, names[i]))
+			return value = static_cast<uint8_t>(i), true;
+	return false;
+}
+
+int	main(int ac, char *av[]) try {
+	options	opts;
+	int		opt;
+	uint8_t	value;
+
+	opts.eng = engine::READINESS;
+	opts.mode = workload::ECHO;
+	opts.threads = 1;
+	opts.busy_poll = 50;
+	while ((opt = getopt(ac, av, "e:m:t:b:")) != -1) {
+		switch (opt) {
+			case 'e':
+				if (!_parse_name(optarg, _engine_names, sizeof(_engine_names) / sizeof(*_engine_names), value))
+					return _usage(av[0]), EXIT_FAILURE;
+				opts.eng = static_cast<engine>(value);
+				break ;
+			case 'm':
+				if (!_parse_name(optarg, _workload_names, sizeof(_workload_names) / sizeof(*_workload_names), value))
+					return _usage(av[0]), EXIT_FAILURE;
+				opts.mode = static_cast<workload>(value);
+				break ;
+			case 't':	opts.threads = std::strtoull(optarg, nullptr, 10);						break ;
+			case 'b':	opts.busy_poll = static_cast<int32_t>(std::strtol(optarg, nullptr, 10));	break ;
+			default:
+				return _usage(av[0]), EXIT_FAILURE;
+		}
+	}
+	if (optind + 1 != ac || !opts.threads)
+		return _usage(av[0]), EXIT_FAILURE;
+	opts.target = av[optind];
+	_handle_signals();
+
+	if (!opts.target.compare(0, 5, "unix:")) {
+		const std::string	path = opts.target.substr(5);
+
+		unlink(path.c_str());
+
+		const int	ret = _run<nw::sa_family::LOCAL>(nw::addr<nw::sa_family::LOCAL>(path), opts);
+
+		unlink(path.c_str());
+		return ret;
+	}
+
+	const std::string::size_type	colon = opts.target.rfind(':');
+
+	if (colon == std::string::npos)
+		return _usage(av[0]), EXIT_FAILURE;
+
+	const nw::port_type	port = static_cast<nw::port_type>(std::strtoul(opts.target.c_str() + colon + 1, nullptr, 10));
+
+	if (opts.target[0] == '[')
+		return _run<nw::sa_family::INET6>(nw::addr<nw::sa_family::INET6>(port, opts.target.substr(1, colon - 2)), opts);
+	return _run<nw::sa_family::INET>(nw::addr<nw::sa_family::INET>(port, opts.target.substr(0, colon)), opts);
 } catch (const std::exception &e) {
-	std::cerr << "Excpetion: " << e.what() << std::endl;
+	std::cerr << "Exception: " << e.what() << std::endl;
 	return EXIT_FAILURE;
 }
@@ -12,8 +12,11 @@
 # include <cstring>
 
 # include "nw_typedef.hpp"
+# include "nw_format.hpp"
 
 # include <arpa/inet.h>
+# include <sys/un.h>
+# include <cstddef>
 
 namespace nw {
 	//! Protected address storage class
@@ -30,9 +33,10 @@ namespace nw {
 			virtual	~addr_storage(void) {}
 
 			virtual const std::string	to_string(void) const = 0;
+			virtual void				format(formatter &f) const = 0;
 
-			virtual const sa_family &	get_family(void) const {
-				return *reinterpret_cast<const sa_family *>(&this->_struct.ss_family);
+			virtual sa_family			get_family(void) const {
+				return static_cast<sa_family>(this->_struct.ss_family);
 			}
 
 			const type &				get_ref(void) const {
@@ -63,11 +67,15 @@ namespace nw {
 			virtual	~addr(void) {}
 
 			virtual const std::string	to_string(void) const = delete;
+			virtual void				format(formatter &f) const = delete;
 
 			virtual addr &	operator=(const addr &src) = delete;
 			virtual addr &	operator=(addr &&src) = delete;
 	};
 
+	template <>
+	class addr<sa_family::UNSPEC>;
+
 	template <>
 	//! IPv4 addr template specialization
 	class addr<sa_family::INET> : protected addr_storage {
@@ -114,6 +122,12 @@ namespace nw {
 				addr &&src			//!< nw::sa_family::INET nw::addr
 			) : addr(src._struct) {}
 
+			//! @brief Construct from nw::sa_family::UNSPEC nw::addr
+			//! @throw nw::logic_error if src does not hold an IPv4 address
+			explicit addr(
+				const addr<sa_family::UNSPEC> &src	//!< nw::sa_family::UNSPEC nw::addr
+			);
+
 			//! @brief Destructor
 			virtual	~addr(void) {}
 
@@ -138,13 +152,29 @@ namespace nw {
 			//! @brief Return a json formated std::string containing addr data
 			//! @return json formated std::string
 			const std::string	to_string(void) const {
-				std::string	str;
-
-				str = "{ \"family\": \"" + sa_family_str(static_cast<sa_family>(this->_struct.sin_family)) + "\", ";
-				str += "\"port\": " + std::to_string(ntohs(this->_struct.sin_port)) + ", ";
-				str += "\"ip\": \"" + std::string(inet_ntoa(this->_struct.sin_addr)) + "\" }";
+				return format_string([this](formatter &f){ this->format(f); }, 64);
+			}
 
-				return str;
+			//! @brief Write addr data to a nw::formatter, without allocation
+			void				format(formatter &f) const {
+				const uint8_t	*bytes = reinterpret_cast<const uint8_t *>(&this->_struct.sin_addr);
+				char			ip[INET_ADDRSTRLEN];
+				size_type		len = 0;
+
+				for (uint8_t i = 0; i != 4; ++i) {
+					if (i)
+						ip[len++] = '.';
+					if (bytes[i] >= 100)
+						ip[len++] = static_cast<char>('0' + bytes[i] / 100);
+					if (bytes[i] >= 10)
+						ip[len++] = static_cast<char>('0' + bytes[i] / 10 % 10);
+					ip[len++] = static_cast<char>('0' + bytes[i] % 10);
+				}
+				f.begin_object();
+				f.key("family").value(sa_family_name(static_cast<sa_family>(this->_struct.sin_family)));
+				f.key("port").value(static_cast<uint32_t>(ntohs(this->_struct.sin_port)));
+				f.key("ip").value(ip, len);
+				f.end_object();
 			}
 
 		protected:
@@ -160,6 +190,12 @@ namespace nw {
 			template <sa_family, sock_type>
 			friend class socket;
 
+			template <sa_family>
+			friend class slim_addr;
+
+			template <sa_family, sock_type>
+			friend class socket_handle;
+
 		private:
 	};
 
@@ -217,6 +253,12 @@ namespace nw {
 				addr &&src			//!< nw::sa_family::INET6 nw::addr
 			) : addr(src._struct) {}
 
+			//! @brief Construct from nw::sa_family::UNSPEC nw::addr
+			//! @throw nw::logic_error if src does not hold an IPv6 address
+			explicit addr(
+				const addr<sa_family::UNSPEC> &src	//!< nw::sa_family::UNSPEC nw::addr
+			);
+
 			//! @brief Destructor
 			virtual	~addr(void) {}
 
@@ -241,16 +283,23 @@ namespace nw {
 			//! @brief Return a json formated std::string containing addr data
 			//! @return json formated std::string
 			const std::string	to_string(void) const {
-				std::string	str;
-				char		addr[INET6_ADDRSTRLEN];
-
-				str = "{ \"family\": \"" + sa_family_str(static_cast<sa_family>(this->_struct.sin6_family)) + "\", ";
-				str += "\"port\": " + std::to_string(ntohs(this->_struct.sin6_port)) + ", ";
-				str += "\"flowinfo\": " + std::to_string(ntohl(this->_struct.sin6_flowinfo)) + ", ";
-				str += "\"ipv6\": \"" + std::string(inet_ntop(AF_INET6, &this->_struct.sin6_addr, reinterpret_cast<char *>(&addr), sizeof(type))) + "\", ";
-				str += "\"scope_id\": " + std::to_string(ntohl(this->_struct.sin6_scope_id)) + " }";
+				return format_string([this](formatter &f){ this->format(f); }, 128);
+			}
 
-				return str;
+			//! @brief Write addr data to a nw::formatter, without allocation
+			void				format(formatter &f) const {
+				char	ip[INET6_ADDRSTRLEN];
+
+				f.begin_object();
+				f.key("family").value(sa_family_name(static_cast<sa_family>(this->_struct.sin6_family)));
+				f.key("port").value(static_cast<uint32_t>(ntohs(this->_struct.sin6_port)));
+				f.key("flowinfo").value(static_cast<uint32_t>(ntohl(this->_struct.sin6_flowinfo)));
+				if (inet_ntop(AF_INET6, &this->_struct.sin6_addr, ip, sizeof(ip)))
+					f.key("ipv6").value(ip);
+				else
+					f.key("ipv6").null();
+				f.key("scope_id").value(static_cast<uint32_t>(ntohl(this->_struct.sin6_scope_id)));
+				f.end_object();
 			}
 
 		protected:
@@ -266,6 +315,12 @@ namespace nw {
 			template <sa_family, sock_type>
 			friend class socket;
 
+			template <sa_family>
+			friend class slim_addr;
+
+			template <sa_family, sock_type>
+			friend class socket_handle;
+
 		private:
 	};
 
@@ -321,6 +376,11 @@ namespace nw {
 				return addr<sa_family::INET6>::to_string();
 			}
 
+			//! @brief Write addr data to a nw::formatter, without allocation
+			void				format(formatter &f) const {
+				addr<sa_family::INET6>::format(f);
+			}
+
 		protected:
 			addr(const addr_storage &src) : addr<sa_family::INET6>::addr(src) {}
 
@@ -329,6 +389,142 @@ namespace nw {
 		private:
 	};
 
+	template <>
+	//! Local communication (AF_UNIX) addr template specialization
+	class addr<sa_family::LOCAL> : protected addr_storage {
+		public:
+			//! @brief type is sockaddr_un
+			using type = struct sockaddr_un;
+
+			//! @brief Default constructor, unnamed address
+			addr(void) : _struct(reinterpret_cast<const type &>(get_ref())) {
+				const_cast<type &>(this->_struct).sun_family = AF_LOCAL;
+				const_cast<socklen_type &>(this->_sizeof) = offsetof(type, sun_path);
+			}
+
+			//! @brief Construct from pathname or abstract name
+			//! @details
+			//! An abstract name (linux specific) is not bound to the filesystem, it may contain any byte.
+			//!
+			//! @throw nw::logic_error if path does not fit in sockaddr_un.sun_path
+			addr(
+				const std::string &path,		//!< pathname or abstract name
+				const bool &abstract = false	//!< true for an abstract name
+			) : addr::addr() {
+				type			&ref = const_cast<type &>(this->_struct);
+				const size_type	len = path.size() + 1;
+
+				if (len > sizeof(ref.sun_path))
+					throw logic_error("addr: path too long");
+				std::memset(ref.sun_path, 0, sizeof(ref.sun_path));
+				std::memcpy(ref.sun_path + ((abstract) ? 1 : 0), path.data(), path.size());
+				const_cast<socklen_type &>(this->_sizeof) = static_cast<socklen_type>(offsetof(type, sun_path) + len);
+			}
+
+			//! @brief Construct from nw::addr::type and its length
+			addr(
+				const type &sa_un,					//!< struct sockaddr_un
+				const socklen_type &len = sizeof(type)	//!< address length returned by the kernel
+			) : addr::addr() {
+				const_cast<type &>(this->_struct) = sa_un;
+				const_cast<socklen_type &>(this->_sizeof) = std::min<socklen_type>(std::max<socklen_type>(len, offsetof(type, sun_path)), sizeof(type));
+			}
+
+			//! @brief Copy constructor
+			addr(
+				const addr &src		//!< nw::sa_family::LOCAL nw::addr
+			) : addr(src._struct, src._sizeof) {}
+
+			//! @brief Move constructor
+			addr(
+				addr &&src			//!< nw::sa_family::LOCAL nw::addr
+			) : addr(src._struct, src._sizeof) {}
+
+			//! @brief Construct from nw::sa_family::UNSPEC nw::addr
+			//! @throw nw::logic_error if src does not hold a local address
+			explicit addr(
+				const addr<sa_family::UNSPEC> &src	//!< nw::sa_family::UNSPEC nw::addr
+			);
+
+			//! @brief Destructor
+			virtual	~addr(void) {}
+
+			//! @brief Assignment operator
+			//! @return nw::sa_family::LOCAL nw::addr
+			addr &	operator=(
+				const addr &src		//!< nw::sa_family::LOCAL nw::addr
+			) {
+				const_cast<type &>(this->_struct) = src._struct;
+				const_cast<socklen_type &>(this->_sizeof) = src._sizeof;
+				return *this;
+			}
+
+			//! @brief Move operator
+			//! @return nw::sa_family::LOCAL nw::addr
+			addr &	operator=(
+				addr &&src			//!< nw::sa_family::LOCAL nw::addr
+			) {
+				const_cast<type &>(this->_struct) = src._struct;
+				const_cast<socklen_type &>(this->_sizeof) = src._sizeof;
+				return *this;
+			}
+
+			//! @brief Return true if address is an abstract name
+			bool				is_abstract(void) const {
+				return this->_sizeof > offsetof(type, sun_path) && this->_struct.sun_path[0] == '\0';
+			}
+
+			//! @brief Return pathname or abstract name, empty if unnamed
+			const std::string	get_path(void) const {
+				const size_type	len = this->_sizeof - offsetof(type, sun_path);
+
+				if (this->is_abstract())
+					return std::string(this->_struct.sun_path + 1, len - 1);
+				return std::string(this->_struct.sun_path, strnlen(this->_struct.sun_path, len));
+			}
+
+			//! @brief Return a json formated std::string containing addr data
+			//! @return json formated std::string
+			const std::string	to_string(void) const {
+				return format_string([this](formatter &f){ this->format(f); });
+			}
+
+			//! @brief Write addr data to a nw::formatter, without allocation
+			//! @details Abstract names are written escaped.
+			void				format(formatter &f) const {
+				const size_type	len = this->_sizeof - offsetof(type, sun_path);
+
+				f.begin_object();
+				f.key("family").value(sa_family_name(static_cast<sa_family>(this->_struct.sun_family)));
+				if (this->is_abstract())
+					f.key("abstract").value(this->_struct.sun_path + 1, len - 1);
+				else
+					f.key("path").value(this->_struct.sun_path, strnlen(this->_struct.sun_path, len));
+				f.end_object();
+			}
+
+		protected:
+			const type	&_struct;
+
+			addr(const addr_storage &src) : addr(static_cast<const addr<sa_family::LOCAL> &>(src)._struct, static_cast<const addr<sa_family::LOCAL> &>(src)._sizeof) {
+				if (this->_struct.sun_family != static_cast<sa_family_t>(sa_family::LOCAL))
+					throw logic_error("addr_storage: invalid conversion");
+			}
+
+			friend addr<sa_family::UNSPEC>;
+
+			template <sa_family, sock_type>
+			friend class socket;
+
+			template <sa_family>
+			friend class slim_addr;
+
+			template <sa_family, sock_type>
+			friend class socket_handle;
+
+		private:
+	};
+
 	template <>
 	//! Unspecified IP addr template specialization
 	class addr<sa_family::UNSPEC> : protected addr_storage {
@@ -361,6 +557,10 @@ namespace nw {
 						reinterpret_cast<nw::addr<sa_family::INET6>::type &>(const_cast<type &>(this->_struct)) = reinterpret_cast<const nw::addr<sa_family::INET6>::type &>(addr);
 						const_cast<socklen_type &>(this->_sizeof) = sizeof(nw::addr<sa_family::INET6>::type);
 						break ;
+					case sa_family::LOCAL:
+						reinterpret_cast<nw::addr<sa_family::LOCAL>::type &>(const_cast<type &>(this->_struct)) = reinterpret_cast<const nw::addr<sa_family::LOCAL>::type &>(addr);
+						const_cast<socklen_type &>(this->_sizeof) = sizeof(nw::addr<sa_family::LOCAL>::type);
+						break ;
 				}
 			}
 
@@ -389,6 +589,13 @@ namespace nw {
 				const addr<sa_family::INET6V4M> &src	//!< nw::sa_family::INET6V4M nw::addr
 			) : addr(reinterpret_cast<const type &>(src._struct)) {}
 
+			//! @brief Construct from nw::sa_family::LOCAL nw::addr
+			addr(
+				const addr<sa_family::LOCAL> &src		//!< nw::sa_family::LOCAL nw::addr
+			) : addr(reinterpret_cast<const type &>(src._struct)) {
+				const_cast<socklen_type &>(this->_sizeof) = src._sizeof;
+			}
+
 			//! @brief Destructor
 			virtual	~addr(void) {}
 
@@ -413,31 +620,48 @@ namespace nw {
 			//! @brief return a json formated std::string containing addr data
 			//! @return json formated std::string
 			virtual const std::string	to_string(void) const {
-				std::string	str;
+				return format_string([this](formatter &f){ this->format(f); });
+			}
 
+			//! @brief Write addr data to a nw::formatter, without allocation
+			virtual void				format(formatter &f) const {
 				switch (this->get_family()) {
 					default:
-						str = "{ \"family\" :\"" + sa_family_str(sa_family::UNSPEC) + "\" }";
+						f.begin_object().key("family").value(sa_family_name(sa_family::UNSPEC)).end_object();
 						break ;
 					case sa_family::INET:
-						str = addr<sa_family::INET>(*this).to_string();
+						addr<sa_family::INET>(*this).format(f);
 						break ;
 					case sa_family::INET6:
-						str = addr<sa_family::INET6>(*this).to_string();
+						addr<sa_family::INET6>(*this).format(f);
+						break ;
+					case sa_family::LOCAL:
+						addr<sa_family::LOCAL>(*this).format(f);
 						break ;
 				}
-
-				return str;
 			}
 
 		protected:
 			const type	&_struct;
 
+			friend addr<sa_family::INET>;
+			friend addr<sa_family::INET6>;
+			friend addr<sa_family::LOCAL>;
+
 			template <sa_family, sock_type>
 			friend class socket;
 
+			template <sa_family>
+			friend class slim_addr;
+
 		private:
 	};
+
+	inline addr<sa_family::INET>::addr(const addr<sa_family::UNSPEC> &src) : addr(static_cast<const addr_storage &>(src)) {}
+
+	inline addr<sa_family::INET6>::addr(const addr<sa_family::UNSPEC> &src) : addr(static_cast<const addr_storage &>(src)) {}
+
+	inline addr<sa_family::LOCAL>::addr(const addr<sa_family::UNSPEC> &src) : addr(static_cast<const addr_storage &>(src)) {}
 };
 
 template <nw::sa_family FAMILY>
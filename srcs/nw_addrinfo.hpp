@@ -54,23 +54,6 @@ namespace nw {
 			addrinfo(const std::string &service, const std::string &node, const protoent &proto, const sock_type &type = sock_type::UNSPEC) \
 				: addrinfo<FAMILY>(type, node.c_str(), service.c_str(), proto) {}
 
-			virtual	~addrinfo(void) {}
-
-			const std::string	to_string(void) const {
-				std::string str;
-
-				str = '[';
-				for (typename std::list<addrinfo<FAMILY>::data>::const_iterator it = this->_addrinfo_list.begin(); it != this->_addrinfo_list.end() ; ++it) {
-					str += it->to_string();
-					if (std::next(it) != this->_addrinfo_list.end())
-						str += ", ";
-				}
-				str += ']';
-
-				return str;
-			}
-
-		protected:
 			class data {
 				public:
 					data(const int32_t &flags, const sa_family &family, const sock_type &type, const protoent &proto, const addr<FAMILY> &addr, const std::string &canonname) \
@@ -80,22 +63,56 @@ namespace nw {
 					data(data &&src) : _flags(src._flags), _family(src._family), _type(src._type), _proto(src._proto), _addr(src._addr), _canonname(src._canonname) {}
 
 					const std::string	to_string(void) const {
-						std::string str;
-						char		flags[5] = {0};
+						return format_string([this](formatter &f){ this->format(f); }, 512);
+					}
+
+					//! @brief Write addrinfo data to a nw::formatter, without allocation
+					void				format(formatter &f) const {
+						char	flags[5] = {0};
 
 						snprintf(flags, sizeof(flags), "%0#4X", this->_flags);
-						str = "{ \"flags\": \"" + std::string(flags) + "\", ";
-						str += "\"family\": \"" + sa_family_str(this->_family) + "\", ";
-						str += "\"type\": \"" + sock_type_str(this->_type) + "\", ";
-						str += "\"protocol\": " + this->_proto.to_string() + ", ";
-						str += "\"sockaddr\": " + this->_addr.to_string() + ", ";
-						str += "\"canonname\": " + ((this->_canonname == "null") ? this->_canonname : '\"' + this->_canonname + '\"') + " }";
-
-						return str;
+						f.begin_object();
+						f.key("flags").value(flags);
+						f.key("family").value(sa_family_name(this->_family));
+						f.key("type").value(sock_type_name(this->_type));
+						f.key("protocol");
+						this->_proto.format(f);
+						f.key("sockaddr");
+						this->_addr.format(f);
+						f.key("canonname");
+						if (this->_canonname == "null")
+							f.null();
+						else
+							f.value(this->_canonname);
+						f.end_object();
 					}
 
 					~data(void) {}
 
+					const int32_t &		get_flags(void) const {
+						return this->_flags;
+					}
+
+					const sa_family &	get_family(void) const {
+						return this->_family;
+					}
+
+					const sock_type &	get_type(void) const {
+						return this->_type;
+					}
+
+					const protoent &	get_proto(void) const {
+						return this->_proto;
+					}
+
+					const addr<FAMILY> &	get_addr(void) const {
+						return this->_addr;
+					}
+
+					const std::string &	get_canonname(void) const {
+						return this->_canonname;
+					}
+
 				protected:
 					const int32_t		_flags;
 					const sa_family		_family;
@@ -114,6 +131,35 @@ namespace nw {
 					data &	operator=(data &&src) = delete;
 			};
 
+			typedef typename std::list<data>::const_iterator	const_iterator;
+
+			virtual	~addrinfo(void) {}
+
+			const_iterator	begin(void) const {
+				return this->_addrinfo_list.begin();
+			}
+
+			const_iterator	end(void) const {
+				return this->_addrinfo_list.end();
+			}
+
+			size_type		size(void) const {
+				return this->_addrinfo_list.size();
+			}
+
+			const std::string	to_string(void) const {
+				return format_string([this](formatter &f){ this->format(f); }, 512 * (this->size() + 1));
+			}
+
+			//! @brief Write every addrinfo data to a nw::formatter, without allocation
+			void				format(formatter &f) const {
+				f.begin_array();
+				for (const_iterator it = this->begin(); it != this->end(); ++it)
+					it->format(f);
+				f.end_array();
+			}
+
+		protected:
 			typedef addrinfo_struct		type;
 
 			const std::list<data>		_addrinfo_list;
@@ -0,0 +1,268 @@
+
+/*!
+@file nw_bpf.cpp
+@brief ...
+*/
+
+#include <functional>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include "nw_bpf.hpp"
+#include "nw_transport.hpp"
+
+static const std::function<int(int, int, int, const void *, socklen_t)> &	_s_setsockopt = nw::transport::current.setsockopt;
+
+const nw::size_type	nw::bpf_program::MAX_SIZE;
+
+nw::bpf_program::bpf_program(void) : _insns() {
+}
+
+nw::bpf_program::bpf_program(const std::vector<instruction> &insns) : _insns(insns) {
+}
+
+nw::bpf_program::~bpf_program(void) {
+}
+
+nw::bpf_program::instruction	nw::bpf_program::stmt(const uint16_t &code, const uint32_t &k) {
+	instruction	insn = BPF_STMT(code, k);
+
+	return insn;
+}
+
+nw::bpf_program::instruction	nw::bpf_program::jump(const uint16_t &code, const uint32_t &k, const uint8_t &jt, const uint8_t &jf) {
+	instruction	insn = BPF_JUMP(code, k, jt, jf);
+
+	return insn;
+}
+
+nw::bpf_program &				nw::bpf_program::push(const instruction &insn) {
+	this->_insns.push_back(insn);
+	return *this;
+}
+
+nw::bpf_program					nw::bpf_program::reuseport_cpu(const uint32_t &group_size) {
+	if (!group_size)
+		throw logic_error("reuseport_cpu: empty group");
+
+	bpf_program	prog;
+
+	prog.push(stmt(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+	prog.push(stmt(BPF_ALU | BPF_MOD | BPF_K, group_size));
+	prog.push(stmt(BPF_RET | BPF_A, 0));
+	return prog;
+}
+
+void							nw::bpf_program::attach(const sockfd_type &fd) const {
+	this->_setsockopt(fd, SO_ATTACH_FILTER);
+}
+
+void							nw::bpf_program::attach_reuseport(const sockfd_type &fd) const {
+	this->_setsockopt(fd, SO_ATTACH_REUSEPORT_CBPF);
+}
+
+void							nw::bpf_program::detach(const sockfd_type &fd) {
+	int32_t	value = 0;
+
+	if (_s_setsockopt(fd, SOL_SOCKET, SO_DETACH_FILTER, &value, sizeof(value)) == -1)
+		throw system_error(errno, std::generic_category(), "setsockopt");
+}
+
+void							nw::bpf_program::lock(const sockfd_type &fd) {
+	int32_t	value = 1;
+
+	if (_s_setsockopt(fd, SOL_SOCKET, SO_LOCK_FILTER, &value, sizeof(value)) == -1)
+		throw system_error(errno, std::generic_category(), "setsockopt");
+}
+
+nw::size_type					nw::bpf_program::size(void) const {
+	return this->_insns.size();
+}
+
+const nw::bpf_program::instruction *	nw::bpf_program::data(void) const {
+	return this->_insns.data();
+}
+
+const std::string				nw::bpf_program::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 64 * (this->_insns.size() + 1));
+}
+
+void							nw::bpf_program::format(formatter &f) const {
+	f.begin_array();
+	for (const instruction &insn : this->_insns) {
+		f.begin_object();
+		f.key("code").value(static_cast<uint32_t>(insn.code));
+		f.key("jt").value(static_cast<uint32_t>(insn.jt));
+		f.key("jf").value(static_cast<uint32_t>(insn.jf));
+		f.key("k").value(insn.k);
+		f.end_object();
+	}
+	f.end_array();
+}
+
+void							nw::bpf_program::_setsockopt(const sockfd_type &fd, const int32_t &option) const {
+	struct sock_fprog	fprog = {};
+
+	if (this->_insns.size() > MAX_SIZE)
+		throw logic_error("bpf_program: too many instructions");
+	fprog.len = static_cast<uint16_t>(this->_insns.size());
+	fprog.filter = const_cast<instruction *>(this->_insns.data());
+	if (_s_setsockopt(fd, SOL_SOCKET, option, &fprog, sizeof(fprog)) == -1)
+		throw system_error(errno, std::generic_category(), "setsockopt");
+}
+
+nw::bpf_filter::bpf_filter(const uint8_t &protocol) : _protocol(protocol), _insns(), _rejects(), _payload(false) {
+	if (protocol != IPPROTO_UDP && protocol != IPPROTO_TCP)
+		throw logic_error("bpf_filter: unsupported protocol");
+}
+
+nw::bpf_filter::~bpf_filter(void) {
+}
+
+nw::bpf_filter &				nw::bpf_filter::src_port(const uint16_t &port) {
+	this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_H | BPF_ABS, 0));
+	this->_require(BPF_JMP | BPF_JEQ | BPF_K, port);
+	return *this;
+}
+
+nw::bpf_filter &				nw::bpf_filter::dst_port(const uint16_t &port) {
+	this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_H | BPF_ABS, 2));
+	this->_require(BPF_JMP | BPF_JEQ | BPF_K, port);
+	return *this;
+}
+
+nw::bpf_filter &				nw::bpf_filter::dst_port_range(const uint16_t &first, const uint16_t &last) {
+	this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_H | BPF_ABS, 2));
+	this->_require(BPF_JMP | BPF_JGE | BPF_K, first);
+	this->_reject_if(BPF_JMP | BPF_JGT | BPF_K, last);
+	return *this;
+}
+
+nw::bpf_filter &				nw::bpf_filter::min_length(const uint32_t &len) {
+	this->_load_payload();
+	this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_W | BPF_LEN, 0));
+	this->_insns.push_back(bpf_program::stmt(BPF_ALU | BPF_SUB | BPF_X, 0));
+	this->_require(BPF_JMP | BPF_JGE | BPF_K, len);
+	return *this;
+}
+
+nw::bpf_filter &				nw::bpf_filter::max_length(const uint32_t &len) {
+	this->_load_payload();
+	this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_W | BPF_LEN, 0));
+	this->_insns.push_back(bpf_program::stmt(BPF_ALU | BPF_SUB | BPF_X, 0));
+	this->_reject_if(BPF_JMP | BPF_JGT | BPF_K, len);
+	return *this;
+}
+
+nw::bpf_filter &				nw::bpf_filter::prefix(const void *data, const size_type &len, const uint32_t &offset) {
+	const uint8_t	*bytes = static_cast<const uint8_t *>(data);
+	size_type		i = 0;
+
+	this->_load_payload();
+	while (i != len) {
+		const size_type	width = (len - i >= 4) ? 4 : (len - i >= 2) ? 2 : 1;
+		uint32_t		value = 0;
+
+		for (size_type j = 0; j != width; ++j)
+			value = (value << 8) | bytes[i + j];
+		this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_IND | ((width == 4) ? BPF_W : (width == 2) ? BPF_H : BPF_B), static_cast<uint32_t>(offset + i)));
+		this->_require(BPF_JMP | BPF_JEQ | BPF_K, value);
+		i += width;
+	}
+	return *this;
+}
+
+nw::bpf_filter &				nw::bpf_filter::prefix(const std::string &data, const uint32_t &offset) {
+	return this->prefix(data.data(), data.size(), offset);
+}
+
+nw::bpf_filter &				nw::bpf_filter::src_net(const std::string &net, const uint8_t &prefix_len) {
+	uint8_t		bytes[16] = {0};
+	uint32_t	version;
+	uint32_t	src;
+
+	if (inet_pton(AF_INET, net.c_str(), bytes) == 1) {
+		version = 4;
+		src = 12;
+	} else if (inet_pton(AF_INET6, net.c_str(), bytes) == 1) {
+		version = 6;
+		src = 8;
+	} else
+		throw logic_error("src_net: invalid address");
+	if (prefix_len > ((version == 4) ? 32 : 128))
+		throw logic_error("src_net: invalid prefix length");
+	this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_B | BPF_ABS, static_cast<uint32_t>(SKF_NET_OFF)));
+	this->_insns.push_back(bpf_program::stmt(BPF_ALU | BPF_AND | BPF_K, 0xf0));
+	this->_require(BPF_JMP | BPF_JEQ | BPF_K, version << 4);
+	for (uint32_t bits = 0; bits < prefix_len; bits += 32) {
+		const uint32_t	mask = (prefix_len - bits >= 32) ? 0xffffffff : ~(0xffffffff >> (prefix_len - bits));
+		uint32_t		word;
+
+		std::memcpy(&word, bytes + bits / 8, sizeof(word));
+		this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_NET_OFF) + src + bits / 8));
+		if (mask != 0xffffffff)
+			this->_insns.push_back(bpf_program::stmt(BPF_ALU | BPF_AND | BPF_K, mask));
+		this->_require(BPF_JMP | BPF_JEQ | BPF_K, ntohl(word) & mask);
+	}
+	return *this;
+}
+
+nw::bpf_program					nw::bpf_filter::compile(void) const {
+	std::vector<instruction>	insns(this->_insns);
+	const size_type				reject = insns.size() + 1;
+
+	if (reject + 1 > bpf_program::MAX_SIZE)
+		throw logic_error("bpf_filter: too many instructions");
+	for (const std::pair<size_type, bool> &site : this->_rejects) {
+		const size_type	offset = reject - site.first - 1;
+
+		if (offset > 0xff)
+			throw logic_error("bpf_filter: jump out of range");
+		if (site.second)
+			insns[site.first].jt = static_cast<uint8_t>(offset);
+		else
+			insns[site.first].jf = static_cast<uint8_t>(offset);
+	}
+	insns.push_back(bpf_program::stmt(BPF_RET | BPF_K, 0xffffffff));
+	insns.push_back(bpf_program::stmt(BPF_RET | BPF_K, 0));
+	return bpf_program(insns);
+}
+
+const std::string				nw::bpf_filter::to_string(void) const {
+	return this->compile().to_string();
+}
+
+void							nw::bpf_filter::_load_payload(void) {
+	if (this->_payload)
+		return ;
+	if (this->_protocol == IPPROTO_TCP) {
+		this->_insns.push_back(bpf_program::stmt(BPF_LD | BPF_B | BPF_ABS, 12));
+		this->_insns.push_back(bpf_program::stmt(BPF_ALU | BPF_RSH | BPF_K, 2));
+		this->_insns.push_back(bpf_program::stmt(BPF_ALU | BPF_AND | BPF_K, 0x3c));
+		this->_insns.push_back(bpf_program::stmt(BPF_MISC | BPF_TAX, 0));
+	} else
+		this->_insns.push_back(bpf_program::stmt(BPF_LDX | BPF_W | BPF_IMM, 8));
+	this->_payload = true;
+}
+
+void							nw::bpf_filter::_require(const uint16_t &code, const uint32_t &k) {
+	this->_rejects.push_back(std::make_pair(this->_insns.size(), false));
+	this->_insns.push_back(bpf_program::jump(code, k, 0, 0));
+}
+
+void							nw::bpf_filter::_reject_if(const uint16_t &code, const uint32_t &k) {
+	this->_rejects.push_back(std::make_pair(this->_insns.size(), true));
+	this->_insns.push_back(bpf_program::jump(code, k, 0, 0));
+}
+
+std::ostream &					operator<<(std::ostream &o, const nw::bpf_program &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &					operator<<(std::ostream &o, const nw::bpf_filter &C) {
+	o << C.to_string();
+	return (o);
+}
@@ -0,0 +1,186 @@
+#ifndef __NW_BPF_HPP__
+# define __NW_BPF_HPP__
+
+/*!
+@file nw_bpf.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <vector>
+# include <utility>
+
+# include <linux/filter.h>
+# include <netinet/in.h>
+
+# include "nw_typedef.hpp"
+# include "nw_format.hpp"
+
+namespace nw {
+	//! @brief Classic BPF program, attached to a socket to drop packets in the kernel
+	//! @details
+	//! On nw::sock_type::DGRAM and nw::sock_type::STREAM inet sockets, absolute loads are relative to the transport header
+	//! (offset 0 is the source port), the network header is reached at SKF_NET_OFF and the packet length includes the
+	//! transport header. A program returns the number of bytes to keep, 0 to drop the packet.
+	class bpf_program {
+		public:
+			using instruction = struct sock_filter;
+
+			//! @brief Largest program accepted by the kernel
+			static const size_type	MAX_SIZE = BPF_MAXINSNS;
+
+			//! @brief Construct an empty program
+			bpf_program(void);
+
+			//! @brief Construct from instructions
+			bpf_program(
+				const std::vector<instruction> &insns	//!< classic BPF instructions
+			);
+
+			bpf_program(const bpf_program &src) = default;
+			bpf_program(bpf_program &&src) = default;
+
+			virtual	~bpf_program(void);
+
+			bpf_program &	operator=(const bpf_program &src) = default;
+			bpf_program &	operator=(bpf_program &&src) = default;
+
+			//! @brief Build a statement, see BPF_STMT
+			static instruction	stmt(const uint16_t &code, const uint32_t &k);
+
+			//! @brief Build a conditional jump, see BPF_JUMP
+			static instruction	jump(const uint16_t &code, const uint32_t &k, const uint8_t &jt, const uint8_t &jf);
+
+			//! @brief Append an instruction
+			bpf_program &	push(const instruction &insn);
+
+			//! @brief Reuseport group program returning the index of the socket bound on the receiving CPU
+			//! @details
+			//! Sockets of a SO_REUSEPORT group are indexed in the order they were bound: the socket bound by the worker pinned
+			//! on CPU i must be the i-th one. Packets received on a CPU out of the group fall back to the kernel hash.
+			static bpf_program	reuseport_cpu(
+				const uint32_t &group_size	//!< number of sockets in the group, the CPU number is taken modulo group_size
+			);
+
+			//! @brief Attach the program as socket filter (SO_ATTACH_FILTER), replacing the previous one
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	attach(
+				const sockfd_type &fd	//!< socket file descriptor
+			) const;
+
+			//! @brief Attach the program as SO_REUSEPORT group selector (SO_ATTACH_REUSEPORT_CBPF)
+			//! @details fd must be bound, the program applies to every socket of its group.
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	attach_reuseport(
+				const sockfd_type &fd	//!< socket file descriptor
+			) const;
+
+			//! @brief Remove the socket filter (SO_DETACH_FILTER)
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			static void	detach(
+				const sockfd_type &fd	//!< socket file descriptor
+			);
+
+			//! @brief Prevent the socket filter from being detached or replaced (SO_LOCK_FILTER)
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			static void	lock(
+				const sockfd_type &fd	//!< socket file descriptor
+			);
+
+			//! @brief Return the number of instructions
+			size_type			size(void) const;
+
+			const instruction *	data(void) const;
+
+			//! @brief Return a json formated std::string containing the instructions
+			const std::string	to_string(void) const;
+
+			//! @brief Write the instructions to a nw::formatter, without allocation
+			void				format(formatter &f) const;
+
+		protected:
+			std::vector<instruction>	_insns;
+
+			void	_setsockopt(const sockfd_type &fd, const int32_t &option) const;
+	};
+
+	//! @brief Builder of classic BPF socket filters accepting the packets matching every condition
+	//! @details
+	//! Conditions are checked in the order they are added, cheapest and most selective first is best.
+	//! Payload offsets and lengths are counted after the transport header, TCP options included.
+	//!
+	//! @code
+	//! nw::bpf_filter().dst_port(5353).min_length(12).compile().attach(sock.get_fd());
+	//! @endcode
+	class bpf_filter {
+		public:
+			//! @brief Construct a filter accepting every packet
+			//! @throw nw::logic_error if protocol is neither IPPROTO_UDP nor IPPROTO_TCP
+			bpf_filter(
+				const uint8_t &protocol = IPPROTO_UDP	//!< transport protocol of the socket
+			);
+
+			virtual	~bpf_filter(void);
+
+			//! @brief Match source port
+			bpf_filter &	src_port(const uint16_t &port);
+
+			//! @brief Match destination port
+			bpf_filter &	dst_port(const uint16_t &port);
+
+			//! @brief Match destination port in [first, last]
+			bpf_filter &	dst_port_range(const uint16_t &first, const uint16_t &last);
+
+			//! @brief Match payloads of at least len bytes
+			bpf_filter &	min_length(const uint32_t &len);
+
+			//! @brief Match payloads of at most len bytes
+			bpf_filter &	max_length(const uint32_t &len);
+
+			//! @brief Match payload bytes at offset
+			bpf_filter &	prefix(
+				const void *data,				//!< bytes to compare
+				const size_type &len,			//!< number of bytes
+				const uint32_t &offset			//!< payload offset
+			);
+
+			//! @brief Match payload prefix
+			bpf_filter &	prefix(const std::string &data, const uint32_t &offset = 0);
+
+			//! @brief Match source address in network net/prefix_len, IPv4 or IPv6
+			//! @throw nw::logic_error if net is not an address or prefix_len is too large
+			bpf_filter &	src_net(
+				const std::string &net,		//!< numeric IPv4 or IPv6 address
+				const uint8_t &prefix_len	//!< network prefix length
+			);
+
+			//! @brief Return the program
+			//! @throw nw::logic_error if the program is too large
+			bpf_program		compile(void) const;
+
+			const std::string	to_string(void) const;
+
+		protected:
+			using instruction = bpf_program::instruction;
+
+			const uint8_t								_protocol;
+			std::vector<instruction>					_insns;
+			std::vector<std::pair<size_type, bool> >	_rejects;	//!< conditional jumps to the reject instruction, true for the jt branch
+			bool										_payload;	//!< X register holds the payload offset
+
+			//! @brief Append a load of the payload offset in X, once
+			void	_load_payload(void);
+
+			//! @brief Append a conditional jump continuing if true, rejecting otherwise
+			void	_require(const uint16_t &code, const uint32_t &k);
+
+			//! @brief Append a conditional jump rejecting if true, continuing otherwise
+			void	_reject_if(const uint16_t &code, const uint32_t &k);
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::bpf_program &C);
+std::ostream &	operator<<(std::ostream &o, const nw::bpf_filter &C);
+
+#endif
@@ -0,0 +1,499 @@
+#ifndef __NW_COROUTINE_HPP__
+# define __NW_COROUTINE_HPP__
+
+/*!
+@file nw_coroutine.hpp
+@brief ...
+*/
+
+# if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+#  define NW_COROUTINES
+
+#  include <coroutine>
+#  include <exception>
+#  include <vector>
+#  include <new>
+#  include <utility>
+
+#  include "nw_typedef.hpp"
+#  include "nw_poller.hpp"
+#  include "nw_socket.hpp"
+
+namespace nw {
+	//! @brief Thread local recycling allocator of coroutine frames
+	//! @details
+	//! Frames are rounded up to 64 bytes and kept in per size free lists of the calling thread once freed, so that
+	//! starting a coroutine reuses the frame of a finished one without reaching the heap. Frames above 2KiB are not recycled.
+	class frame_pool {
+		public:
+			static const size_type	GRANULE	= 64;	//!< frame size rounding
+			static const size_type	CLASSES	= 32;	//!< number of recycled frame sizes
+
+			static void *	allocate(const size_type &size) {
+				const size_type	c = _class(size);
+
+				if (c >= CLASSES)
+					return ::operator new(size);
+
+				_lists	&lists = _local();
+				_node	*node = lists.heads[c];
+
+				if (!node)
+					return ::operator new((c + 1) * GRANULE);
+				lists.heads[c] = node->next;
+				--lists.cached;
+				return node;
+			}
+
+			static void		deallocate(void *ptr, const size_type &size) {
+				const size_type	c = _class(size);
+
+				if (c >= CLASSES) {
+					::operator delete(ptr);
+					return ;
+				}
+
+				_lists	&lists = _local();
+				_node	*node = static_cast<_node *>(ptr);
+
+				node->next = lists.heads[c];
+				lists.heads[c] = node;
+				++lists.cached;
+			}
+
+			//! @brief Number of frames held for reuse by the calling thread
+			static size_type	cached(void) {
+				return _local().cached;
+			}
+
+			//! @brief Free every frame held for reuse by the calling thread
+			static void			release(void) {
+				_local().release();
+			}
+
+		protected:
+			struct	_node {
+				_node	*next;
+			};
+
+			struct	_lists {
+				_node		*heads[CLASSES] = {};
+				size_type	cached = 0;
+
+				~_lists(void) {
+					this->release();
+				}
+
+				void	release(void) {
+					for (size_type c = 0; c != CLASSES; ++c) {
+						while (_node *node = this->heads[c]) {
+							this->heads[c] = node->next;
+							::operator delete(node);
+						}
+					}
+					this->cached = 0;
+				}
+			};
+
+			static size_type	_class(const size_type &size) {
+				return (size) ? (size - 1) / GRANULE : 0;
+			}
+
+			static _lists &		_local(void) {
+				static thread_local _lists	lists;
+
+				return lists;
+			}
+	};
+
+	class task;
+
+	//! @brief Readiness loop resuming coroutines suspended on sockets (epoll(7) instance)
+	//! @details
+	//! Sockets are registered edge triggered on their first suspension and stay registered until nw::io_loop::forget.
+	//! A suspended operation is retried on every readiness notification of its fd and its coroutine resumed once it
+	//! does not report EAGAIN anymore. At most one reader and one writer may be suspended on a fd.
+	class io_loop {
+		public:
+			//! @brief Operation suspended on a fd
+			class waiter {
+				public:
+					std::coroutine_handle<>	handle;
+
+					//! @brief Retry the operation
+					//! @return false if it would still block
+					virtual bool	retry(void) = 0;
+
+				protected:
+					virtual	~waiter(void) {}
+			};
+
+			//! @brief Construct with the maximum number of events returned by one epoll_wait(2)
+			//! @throw nw::system_error if epoll_create1(2) function fail's
+			explicit io_loop(const size_type &max_events = 64) : _poller(max_events), _suspended(0) {}
+
+			//! @brief Destructor, coroutines still suspended are not resumed nor destroyed
+			virtual	~io_loop(void) {}
+
+			//! @brief Suspend w until fd is ready for events (nw::poller::IN or nw::poller::OUT)
+			//! @throw nw::logic_error if an operation is already suspended on fd for events
+			//! @throw nw::system_error if epoll_ctl(2) function fail's
+			void		suspend(const sockfd_type &fd, const uint32_t &events, waiter &w) {
+				if (fd < 0)
+					throw logic_error("io_loop: invalid fd");
+				if (static_cast<size_type>(fd) >= this->_fds.size())
+					this->_fds.resize(fd + 1);
+
+				_entry	&entry = this->_fds[fd];
+				waiter	*&slot = (events & poller::OUT) ? entry.out : entry.in;
+
+				if (slot)
+					throw logic_error("io_loop: operation already suspended");
+				if (!entry.registered) {
+					this->_poller.add(fd, poller::IN | poller::OUT | poller::RDHUP | poller::ET);
+					entry.registered = true;
+				}
+				slot = &w;
+				++this->_suspended;
+			}
+
+			//! @brief Unregister fd, to be called before fd is closed
+			//! @details Operations still suspended on fd are dropped and never resumed.
+			void		forget(const sockfd_type &fd) {
+				if (fd < 0 || static_cast<size_type>(fd) >= this->_fds.size())
+					return ;
+
+				_entry	&entry = this->_fds[fd];
+
+				this->_suspended -= (entry.in != nullptr) + (entry.out != nullptr);
+				if (entry.registered)
+					this->_poller.remove(fd, std::nothrow);
+				entry = _entry();
+			}
+
+			//! @brief Wait for readiness once and resume every coroutine whose operation completed
+			//! @return number of resumed coroutines
+			//! @throw nw::system_error if epoll_wait(2) function fail's (EINTR excepted)
+			//! @throw any exception escaped from a resumed nw::task
+			size_type	run_once(const msec_type &timeout = msec_type(-1)) {
+				size_type	resumed = 0;
+
+				this->_poller.wait(timeout);
+				for (poller::const_iterator it = this->_poller.begin(); it != this->_poller.end(); ++it) {
+					const sockfd_type	fd = it->data.fd;
+
+					if (static_cast<size_type>(fd) >= this->_fds.size())
+						continue ;
+
+					waiter	*in = (it->events & (poller::IN | poller::ERR | poller::HUP | poller::RDHUP)) ? this->_fds[fd].in : nullptr;
+					waiter	*out = (it->events & (poller::OUT | poller::ERR | poller::HUP)) ? this->_fds[fd].out : nullptr;
+
+					if (in && in->retry()) {
+						this->_resume(this->_fds[fd].in);
+						++resumed;
+					}
+					if (out && static_cast<size_type>(fd) < this->_fds.size() && this->_fds[fd].out == out && out->retry()) {
+						this->_resume(this->_fds[fd].out);
+						++resumed;
+					}
+				}
+				_rethrow();
+				return resumed;
+			}
+
+			//! @brief Resume coroutines until none is suspended
+			//! @throw nw::system_error if epoll_wait(2) function fail's (EINTR excepted)
+			//! @throw any exception escaped from a resumed nw::task
+			void		run(void) {
+				_rethrow();
+				while (this->_suspended)
+					this->run_once();
+			}
+
+			//! @brief Number of suspended operations
+			size_type	size(void) const {
+				return this->_suspended;
+			}
+
+		protected:
+			struct	_entry {
+				waiter	*in = nullptr;
+				waiter	*out = nullptr;
+				bool	registered = false;
+			};
+
+			poller				_poller;
+			std::vector<_entry>	_fds;
+			size_type			_suspended;
+
+			void	_resume(waiter *&slot) {
+				waiter	*w = slot;
+
+				slot = nullptr;
+				--this->_suspended;
+				w->handle.resume();
+			}
+
+			//! @brief Exception escaped from a nw::task of the calling thread, rethrown by the next run of any loop
+			static std::exception_ptr &	_failed(void) {
+				static thread_local std::exception_ptr	failed;
+
+				return failed;
+			}
+
+			static void	_rethrow(void) {
+				std::exception_ptr	&failed = _failed();
+
+				if (failed)
+					std::rethrow_exception(std::exchange(failed, nullptr));
+			}
+
+			friend class task;
+
+		private:
+			io_loop(const io_loop &src) = delete;
+			io_loop &	operator=(const io_loop &src) = delete;
+	};
+
+	//! @brief Detached coroutine, started on call and freed on completion
+	//! @details Frames come from nw::frame_pool. An exception escaping the coroutine is rethrown by nw::io_loop::run.
+	class task {
+		public:
+			struct	promise_type {
+				static void *	operator new(std::size_t size) {
+					return frame_pool::allocate(size);
+				}
+
+				static void		operator delete(void *ptr, std::size_t size) {
+					frame_pool::deallocate(ptr, size);
+				}
+
+				task				get_return_object(void) noexcept {
+					return task();
+				}
+
+				std::suspend_never	initial_suspend(void) noexcept {
+					return {};
+				}
+
+				std::suspend_never	final_suspend(void) noexcept {
+					return {};
+				}
+
+				void				return_void(void) noexcept {}
+
+				void				unhandled_exception(void) noexcept {
+					if (!io_loop::_failed())
+						io_loop::_failed() = std::current_exception();
+				}
+			};
+	};
+
+	//! @tparam FAMILY nw::sa_family
+	//! @tparam TYPE nw::sock_type
+	template <sa_family FAMILY, sock_type TYPE>
+	//! @brief Awaitable operations of a nw::socket driven by a nw::io_loop
+	//! @details
+	//! The socket is switched to non-blocking. Every operation is tried at once and suspends the awaiting coroutine only
+	//! when it would block, results and errors are those of the matching nw::socket call.
+	class co_socket {
+		public:
+			typedef socket<FAMILY, TYPE>	socket_type;
+
+			//! @throw nw::system_error if fcntl(2) function fail's
+			co_socket(
+				io_loop &loop,		//!< nw::io_loop resuming suspended operations
+				socket_type &sock	//!< nw::socket, must outlive the co_socket
+			) : _loop(loop), _sock(sock) {
+				this->_sock.set_nonblocking(true);
+			}
+
+			//! @brief Destructor, unregister the socket from the nw::io_loop
+			virtual	~co_socket(void) {
+				this->_loop.forget(this->_sock.get_fd());
+			}
+
+			//! @brief Awaitable operation base
+			class operation : public io_loop::waiter {
+				public:
+					bool	await_ready(void) {
+						return this->retry();
+					}
+
+					void	await_suspend(std::coroutine_handle<> handle) {
+						this->handle = handle;
+						this->_s._loop.suspend(this->_s._sock.get_fd(), this->_events, *this);
+					}
+
+				protected:
+					co_socket		&_s;
+					const uint32_t	_events;
+					int32_t			_error;
+
+					operation(co_socket &s, const uint32_t &events) : _s(s), _events(events), _error(0) {}
+
+					//! @return false on EAGAIN, true otherwise with _error set on failure
+					bool	_done(const bool &ok) {
+						if (ok)
+							return true;
+						if (errno == EAGAIN || errno == EWOULDBLOCK)
+							return false;
+						this->_error = errno;
+						return true;
+					}
+
+					void	_throw(const char *what) const {
+						if (this->_error)
+							throw system_error(this->_error, std::generic_category(), what);
+					}
+
+				private:
+					operation(const operation &src) = delete;
+					operation &	operator=(const operation &src) = delete;
+			};
+
+			//! @tparam SIZE nw::size_type
+			template <size_type SIZE>
+			//! @brief co_await nw::co_socket::recv
+			class recv_operation : public operation {
+				public:
+					recv_operation(co_socket &s, ibuffer<SIZE> &buf, const int &flags) : operation(s, poller::IN), _buf(buf), _flags(flags), _ret(0) {}
+
+					virtual bool	retry(void) {
+						this->_ret = this->_s._sock.recv(this->_buf, this->_flags, std::nothrow);
+						return this->_done(this->_ret != npos);
+					}
+
+					//! @return number of bytes received, 0 on end of stream or full buffer
+					//! @throw nw::system_error if recv(2) function fail's
+					size_type		await_resume(void) const {
+						this->_throw("recv");
+						return this->_ret;
+					}
+
+				protected:
+					ibuffer<SIZE>	&_buf;
+					const int		_flags;
+					size_type		_ret;
+			};
+
+			//! @tparam SIZE nw::size_type
+			template <size_type SIZE>
+			//! @brief co_await nw::co_socket::send
+			class send_operation : public operation {
+				public:
+					send_operation(co_socket &s, obuffer<SIZE> &buf, const int &flags) : operation(s, poller::OUT), _buf(buf), _flags(flags), _ret(0) {}
+
+					virtual bool	retry(void) {
+						this->_ret = this->_s._sock.send(this->_buf, this->_flags, std::nothrow);
+						return this->_done(this->_ret != npos);
+					}
+
+					//! @return number of bytes sent
+					//! @throw nw::system_error if send(2) function fail's
+					size_type		await_resume(void) const {
+						this->_throw("send");
+						return this->_ret;
+					}
+
+				protected:
+					obuffer<SIZE>	&_buf;
+					const int		_flags;
+					size_type		_ret;
+			};
+
+			//! @brief co_await nw::co_socket::accept
+			class accept_operation : public operation {
+				public:
+					explicit accept_operation(co_socket &s) : operation(s, poller::IN), _fd(-1), _addr(), _len(0) {}
+
+					//! @details A connection aborted before being accepted is skipped: the listener is edge-triggered, the
+					//! connections queued behind it would wait for the next one otherwise
+					virtual bool	retry(void) {
+						do {
+							this->_len = sizeof(this->_addr);
+							this->_fd = this->_s._sock._accept(this->_addr, this->_len);
+						} while (this->_fd == -1 && (errno == ECONNABORTED || errno == EINTR));
+						return this->_done(this->_fd != -1);
+					}
+
+					//! @return connected nw::socket, blocking
+					//! @throw nw::system_error if accept(2) function fail's
+					socket_type		await_resume(void) {
+						this->_throw("accept");
+						return this->_s._sock._accepted(this->_fd, this->_addr, this->_len);
+					}
+
+				protected:
+					sockfd_type					_fd;
+					typename addr<FAMILY>::type	_addr;
+					socklen_type				_len;
+			};
+
+			//! @brief co_await nw::co_socket::connect
+			class connect_operation : public operation {
+				public:
+					connect_operation(co_socket &s, const addr<FAMILY> &a) : operation(s, poller::OUT), _addr(a) {}
+
+					bool			await_ready(void) {
+						this->_error = this->_s._sock.connect(this->_addr, std::nothrow);
+						return this->_error != EINPROGRESS;
+					}
+
+					virtual bool	retry(void) {
+						try {
+							this->_error = this->_s._sock.get_error();
+						} catch (const system_error &e) {
+							this->_error = e.code().value();
+						}
+						return true;
+					}
+
+					//! @throw nw::system_error if connect(2) function or the connection fail's
+					void			await_resume(void) const {
+						this->_throw("connect");
+					}
+
+				protected:
+					const addr<FAMILY>	_addr;
+			};
+
+			//! @brief Receive into buf, suspended while no data is available
+			template <size_type SIZE>
+			recv_operation<SIZE>	recv(ibuffer<SIZE> &buf, const int &flags = 0) {
+				return recv_operation<SIZE>(*this, buf, flags);
+			}
+
+			//! @brief Send from buf, suspended while the send buffer is full
+			template <size_type SIZE>
+			send_operation<SIZE>	send(obuffer<SIZE> &buf, const int &flags = 0) {
+				return send_operation<SIZE>(*this, buf, flags);
+			}
+
+			//! @brief Accept a connection, suspended while none is pending
+			accept_operation		accept(void) {
+				return accept_operation(*this);
+			}
+
+			//! @brief Connect to addr, suspended while the connection is being established
+			connect_operation		connect(const addr<FAMILY> &addr) {
+				return connect_operation(*this, addr);
+			}
+
+			socket_type &	get_socket(void) const {
+				return this->_sock;
+			}
+
+		protected:
+			io_loop		&_loop;
+			socket_type	&_sock;
+
+		private:
+			co_socket(const co_socket &src) = delete;
+			co_socket &	operator=(const co_socket &src) = delete;
+	};
+};
+
+# endif
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef __NW_DATAGRAM_BATCH_HPP__
+# define __NW_DATAGRAM_BATCH_HPP__
+
+/*!
+@file nw_datagram_batch.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <cstring>
+# include <type_traits>
+
+# include <sys/socket.h>
+# include <netinet/in.h>
+
+# include "nw_typedef.hpp"
+# include "nw_slim_addr.hpp"
+# include "nw_format.hpp"
+
+namespace nw {
+	//! @tparam FAMILY nw::sa_family, nw::sa_family::INET or nw::sa_family::INET6
+	template <sa_family FAMILY>
+	//! @brief Datagram received by nw::socket::recv_batch, valid until the next receive in its nw::datagram_batch
+	struct	datagram {
+		const uint8_t		*data;			//!< payload
+		size_type			len;			//!< payload length
+		slim_addr<FAMILY>	source;			//!< sender address
+		slim_addr<FAMILY>	destination;	//!< destination address, the multicast group for multicast datagrams, port 0
+		uint32_t			ifindex;		//!< receiving interface index
+		bool				truncated;		//!< the datagram did not fit in its slot and was cut (MSG_TRUNC)
+
+		//! @brief Return a json formated std::string containing datagram data, without payload
+		const std::string	to_string(void) const {
+			return format_string([this](formatter &f){ this->format(f); }, 128);
+		}
+
+		//! @brief Write datagram data to a nw::formatter, without allocation
+		void				format(formatter &f) const {
+			f.begin_object();
+			f.key("len").value(static_cast<uint64_t>(this->len));
+			f.key("source");
+			this->source.format(f);
+			f.key("destination");
+			this->destination.format(f);
+			f.key("ifindex").value(this->ifindex);
+			f.key("truncated").value(this->truncated);
+			f.end_object();
+		}
+	};
+
+	//! @tparam FAMILY nw::sa_family, nw::sa_family::INET or nw::sa_family::INET6
+	//! @tparam COUNT maximum number of datagrams per receive
+	//! @tparam SIZE slot size, larger datagrams are truncated
+	template <sa_family FAMILY, size_type COUNT, size_type SIZE>
+	//! @brief Preallocated slots receiving up to COUNT datagrams with a single recvmmsg(2), see nw::socket::recv_batch
+	//! @details
+	//! Destination address and interface are set from IP_PKTINFO (IPV6_PKTINFO) control messages, enabled by
+	//! nw::socket::set_pktinfo: a socket joined to several multicast groups tells each datagram feed apart without a
+	//! socket per group. They are left zeroed otherwise.
+	class datagram_batch {
+		static_assert(FAMILY == sa_family::INET || FAMILY == sa_family::INET6, "nw::datagram_batch requires an inet family");
+		static_assert(COUNT && SIZE, "nw::datagram_batch requires slots");
+
+		public:
+			datagram_batch(void) : _count(0) {}
+
+			virtual	~datagram_batch(void) {}
+
+			//! @brief Return the number of datagrams of the last receive
+			inline size_type	size(void) const {
+				return this->_count;
+			}
+
+			inline bool			empty(void) const {
+				return !this->_count;
+			}
+
+			//! @brief Return the maximum number of datagrams per receive
+			static constexpr size_type	capacity(void) {
+				return COUNT;
+			}
+
+			//! @brief Return datagram i of the last receive
+			datagram<FAMILY>	operator[](const size_type &i) const {
+				datagram<FAMILY>	d;
+
+				d.data = this->_data[i];
+				d.len = this->_msgs[i].msg_len;
+				d.source = slim_addr<FAMILY>(this->_names[i]);
+				d.destination = this->_destinations[i];
+				d.ifindex = this->_ifindexes[i];
+				d.truncated = this->_msgs[i].msg_hdr.msg_flags & MSG_TRUNC;
+				return d;
+			}
+
+			//! @tparam F void(const nw::datagram<FAMILY> &) callable
+			template <typename F>
+			//! @brief Call fct on every datagram of the last receive, in order
+			void				for_each(const F &fct) const {
+				for (size_type i = 0; i != this->_count; ++i)
+					fct((*this)[i]);
+			}
+
+			//! @brief Forget the datagrams of the last receive
+			void				clear(void) {
+				this->_count = 0;
+			}
+
+			const std::string	to_string(void) const {
+				return format_string([this](formatter &f){ this->format(f); }, 128 * (this->_count + 1));
+			}
+
+			void				format(formatter &f) const {
+				f.begin_array();
+				for (size_type i = 0; i != this->_count; ++i)
+					(*this)[i].format(f);
+				f.end_array();
+			}
+
+		protected:
+			typedef typename slim_addr<FAMILY>::type	name_type;
+			typedef typename std::conditional<FAMILY == sa_family::INET, struct in_pktinfo, struct in6_pktinfo>::type	pktinfo_type;
+
+			static constexpr size_type	CONTROL_SIZE = CMSG_SPACE(sizeof(pktinfo_type));
+
+			uint8_t				_data[COUNT][SIZE];
+			struct mmsghdr		_msgs[COUNT];
+			struct iovec		_iov[COUNT];
+			name_type			_names[COUNT];
+			slim_addr<FAMILY>	_destinations[COUNT];
+			uint32_t			_ifindexes[COUNT];
+			char				_control[COUNT][CONTROL_SIZE];
+			size_type			_count;
+
+			//! @brief Reset message headers before recvmmsg(2)
+			struct mmsghdr *	_prepare(void) {
+				std::memset(this->_msgs, 0, sizeof(this->_msgs));
+				for (size_type i = 0; i != COUNT; ++i) {
+					this->_iov[i].iov_base = this->_data[i];
+					this->_iov[i].iov_len = SIZE;
+					this->_msgs[i].msg_hdr.msg_name = &this->_names[i];
+					this->_msgs[i].msg_hdr.msg_namelen = sizeof(name_type);
+					this->_msgs[i].msg_hdr.msg_iov = &this->_iov[i];
+					this->_msgs[i].msg_hdr.msg_iovlen = 1;
+					this->_msgs[i].msg_hdr.msg_control = this->_control[i];
+					this->_msgs[i].msg_hdr.msg_controllen = CONTROL_SIZE;
+				}
+				this->_count = 0;
+				return this->_msgs;
+			}
+
+			//! @brief Read destination addresses of count received datagrams
+			void				_complete(const size_type &count) {
+				this->_count = count;
+				for (size_type i = 0; i != count; ++i) {
+					struct msghdr	*msg = &this->_msgs[i].msg_hdr;
+
+					this->_destinations[i] = slim_addr<FAMILY>();
+					this->_ifindexes[i] = 0;
+					for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg))
+						_pktinfo(cmsg, this->_destinations[i], this->_ifindexes[i]);
+				}
+			}
+
+			static void			_pktinfo(const struct cmsghdr *cmsg, slim_addr<sa_family::INET> &destination, uint32_t &ifindex) {
+				struct in_pktinfo	info;
+				struct sockaddr_in	sin = {};
+
+				if (cmsg->cmsg_level != IPPROTO_IP || cmsg->cmsg_type != IP_PKTINFO)
+					return ;
+				std::memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+				sin.sin_family = AF_INET;
+				sin.sin_addr = info.ipi_addr;
+				destination = slim_addr<sa_family::INET>(sin);
+				ifindex = static_cast<uint32_t>(info.ipi_ifindex);
+			}
+
+			static void			_pktinfo(const struct cmsghdr *cmsg, slim_addr<sa_family::INET6> &destination, uint32_t &ifindex) {
+				struct in6_pktinfo	info;
+				struct sockaddr_in6	sin6 = {};
+
+				if (cmsg->cmsg_level != IPPROTO_IPV6 || cmsg->cmsg_type != IPV6_PKTINFO)
+					return ;
+				std::memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+				sin6.sin6_family = AF_INET6;
+				sin6.sin6_addr = info.ipi6_addr;
+				destination = slim_addr<sa_family::INET6>(sin6);
+				ifindex = info.ipi6_ifindex;
+			}
+
+			template <sa_family, sock_type>
+			friend class socket;
+
+		private:
+			datagram_batch(const datagram_batch &src) = delete;
+			datagram_batch &	operator=(const datagram_batch &src) = delete;
+	};
+
+	template <sa_family FAMILY, size_type COUNT, size_type SIZE>
+	constexpr size_type	datagram_batch<FAMILY, COUNT, SIZE>::CONTROL_SIZE;
+};
+
+template <nw::sa_family FAMILY>
+std::ostream &	operator<<(std::ostream &o, const nw::datagram<FAMILY> &C) {
+	o << C.to_string();
+	return o;
+}
+
+template <nw::sa_family FAMILY, nw::size_type COUNT, nw::size_type SIZE>
+std::ostream &	operator<<(std::ostream &o, const nw::datagram_batch<FAMILY, COUNT, SIZE> &C) {
+	o << C.to_string();
+	return o;
+}
+
+#endif
@@ -0,0 +1,216 @@
+
+/*!
+@file nw_format.cpp
+@brief ...
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "nw_format.hpp"
+
+const uint8_t	nw::formatter::MAX_DEPTH;
+
+static const char	_HEX[] = "0123456789abcdef";
+
+nw::formatter::formatter(char *buf, const size_type &size) : _buf(buf), _size(size) {
+	this->clear();
+}
+
+nw::formatter::~formatter(void) {
+}
+
+void				nw::formatter::clear(void) {
+	this->_len = 0;
+	this->_truncated = false;
+	this->_keyed = false;
+	this->_depth = 0;
+	this->_filled = 0;
+	if (this->_size)
+		this->_buf[0] = '\0';
+}
+
+void				nw::formatter::_put(const char *str, const size_type &len) {
+	if (!this->_size) {
+		this->_truncated |= (len != 0);
+		return ;
+	}
+
+	const size_type	n = std::min(len, this->_size - 1 - this->_len);
+
+	std::memcpy(this->_buf + this->_len, str, n);
+	this->_len += n;
+	this->_buf[this->_len] = '\0';
+	if (n != len)
+		this->_truncated = true;
+}
+
+void				nw::formatter::_put(const char &c) {
+	this->_put(&c, 1);
+}
+
+void				nw::formatter::_item(void) {
+	if (this->_keyed) {
+		this->_keyed = false;
+		return ;
+	}
+	if (!this->_depth)
+		return ;
+
+	const uint64_t	bit = uint64_t(1) << (this->_depth - 1);
+
+	this->_put((this->_filled & bit) ? ", " : " ", (this->_filled & bit) ? 2 : 1);
+	this->_filled |= bit;
+}
+
+void				nw::formatter::_open(const char &c) {
+	if (this->_depth == MAX_DEPTH)
+		throw logic_error("formatter: nesting too deep");
+	this->_item();
+	this->_put(c);
+	this->_filled &= ~(uint64_t(1) << this->_depth);
+	++this->_depth;
+}
+
+void				nw::formatter::_close(const char &c) {
+	if (!this->_depth)
+		throw logic_error("formatter: nothing to close");
+	--this->_depth;
+	this->_put(' ');
+	this->_put(c);
+}
+
+nw::formatter &		nw::formatter::begin_object(void) {
+	this->_open('{');
+	return *this;
+}
+
+nw::formatter &		nw::formatter::end_object(void) {
+	this->_close('}');
+	return *this;
+}
+
+nw::formatter &		nw::formatter::begin_array(void) {
+	this->_open('[');
+	return *this;
+}
+
+nw::formatter &		nw::formatter::end_array(void) {
+	this->_close(']');
+	return *this;
+}
+
+nw::formatter &		nw::formatter::key(const char *name) {
+	this->_item();
+	this->_quote(name, std::strlen(name));
+	this->_put(": ", 2);
+	this->_keyed = true;
+	return *this;
+}
+
+nw::formatter &		nw::formatter::value(const char *str) {
+	if (!str)
+		return this->null();
+	return this->value(str, std::strlen(str));
+}
+
+nw::formatter &		nw::formatter::value(const char *str, const size_type &len) {
+	this->_item();
+	this->_quote(str, len);
+	return *this;
+}
+
+//! @brief Put str as a json string: quoted, with quote, backslash and control characters escaped
+void				nw::formatter::_quote(const char *str, const size_type &len) {
+	this->_put('"');
+	for (size_type i = 0, done = 0; i <= len; ++i) {
+		const uint8_t	c = (i != len) ? static_cast<uint8_t>(str[i]) : 0;
+
+		if (i != len && c >= 0x20 && c != '"' && c != '\\')
+			continue ;
+		this->_put(str + done, i - done);
+		done = i + 1;
+		if (i == len)
+			break ;
+		if (c == '"' || c == '\\') {
+			const char	esc[2] = {'\\', static_cast<char>(c)};
+
+			this->_put(esc, sizeof(esc));
+		} else {
+			const char	esc[6] = {'\\', 'u', '0', '0', _HEX[c >> 4], _HEX[c & 0xf]};
+
+			this->_put(esc, sizeof(esc));
+		}
+	}
+	this->_put('"');
+}
+
+nw::formatter &		nw::formatter::value(const std::string &str) {
+	return this->value(str.data(), str.size());
+}
+
+nw::formatter &		nw::formatter::value(const uint64_t &n) {
+	char		digits[20];
+	uint8_t		i = sizeof(digits);
+	uint64_t	v = n;
+
+	do {
+		digits[--i] = static_cast<char>('0' + v % 10);
+		v /= 10;
+	} while (v);
+	this->_item();
+	this->_put(digits + i, sizeof(digits) - i);
+	return *this;
+}
+
+nw::formatter &		nw::formatter::value(const int64_t &n) {
+	if (n >= 0)
+		return this->value(static_cast<uint64_t>(n));
+	this->_item();
+	this->_put('-');
+	this->_keyed = true;
+	return this->value(~static_cast<uint64_t>(n) + 1);
+}
+
+nw::formatter &		nw::formatter::value(const uint32_t &n) {
+	return this->value(static_cast<uint64_t>(n));
+}
+
+nw::formatter &		nw::formatter::value(const int32_t &n) {
+	return this->value(static_cast<int64_t>(n));
+}
+
+nw::formatter &		nw::formatter::value(const bool &b) {
+	this->_item();
+	this->_put((b) ? "true" : "false", (b) ? 4 : 5);
+	return *this;
+}
+
+nw::formatter &		nw::formatter::null(void) {
+	this->_item();
+	this->_put("null", 4);
+	return *this;
+}
+
+nw::formatter &		nw::formatter::hex(const void *data, const size_type &len, const size_type &max) {
+	const uint8_t	*bytes = static_cast<const uint8_t *>(data);
+	const size_type	n = std::min(len, max);
+
+	this->_item();
+	this->_put('"');
+	for (size_type i = 0; i != n && !this->_truncated; ++i) {
+		const char	digits[2] = {_HEX[bytes[i] >> 4], _HEX[bytes[i] & 0xf]};
+
+		this->_put(digits, sizeof(digits));
+	}
+	if (n != len)
+		this->_put("...", 3);
+	this->_put('"');
+	return *this;
+}
+
+nw::formatter &		nw::formatter::raw(const char *str, const size_type &len) {
+	this->_item();
+	this->_put(str, len);
+	return *this;
+}
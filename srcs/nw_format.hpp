@@ -0,0 +1,137 @@
+#ifndef __NW_FORMAT_HPP__
+# define __NW_FORMAT_HPP__
+
+/*!
+@file nw_format.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <algorithm>
+
+# include "nw_typedef.hpp"
+
+namespace nw {
+	//! @brief Streaming json writer into a caller provided buffer
+	//! @details
+	//! Separators are inserted from the nesting state, so that objects are written as a flat sequence of keys and values.
+	//! The formatter never allocates: output not fitting the buffer is dropped and the formatter is marked truncated.
+	//! The written text is always NUL terminated, unless the buffer size is 0.
+	class formatter {
+		public:
+			static const uint8_t	MAX_DEPTH = 64;	//!< maximum nesting of objects and arrays
+
+			formatter(
+				char *buf,				//!< destination buffer
+				const size_type &size	//!< buffer size, including the terminating NUL
+			);
+
+			virtual	~formatter(void);
+
+			//! @throw nw::logic_error if nesting exceed nw::formatter::MAX_DEPTH
+			formatter &	begin_object(void);
+			formatter &	end_object(void);
+
+			//! @throw nw::logic_error if nesting exceed nw::formatter::MAX_DEPTH
+			formatter &	begin_array(void);
+			formatter &	end_array(void);
+
+			//! @brief Write an object key, the next value is its value
+			formatter &	key(const char *name);
+
+			//! @brief Write an escaped string value, null if str is NULL
+			formatter &	value(const char *str);
+			formatter &	value(const char *str, const size_type &len);
+			formatter &	value(const std::string &str);
+
+			formatter &	value(const uint64_t &n);
+			formatter &	value(const int64_t &n);
+			formatter &	value(const uint32_t &n);
+			formatter &	value(const int32_t &n);
+			formatter &	value(const bool &b);
+
+			formatter &	null(void);
+
+			//! @brief Write data as a lowercase hexadecimal string value
+			//! @details Only the first max bytes are written, followed by "..." if data was cut.
+			formatter &	hex(
+				const void *data,				//!< bytes to dump
+				const size_type &len,			//!< data length
+				const size_type &max = npos		//!< maximum number of bytes dumped
+			);
+
+			//! @brief Write an unescaped value
+			formatter &	raw(const char *str, const size_type &len);
+
+			//! @brief Restart writing at the beginning of the buffer
+			void		clear(void);
+
+			inline const char *	c_str(void) const {
+				return (this->_size) ? this->_buf : "";
+			}
+
+			//! @brief Written length, terminating NUL excluded
+			inline size_type	size(void) const {
+				return this->_len;
+			}
+
+			//! @brief True if output was dropped because the buffer is full
+			inline bool			truncated(void) const {
+				return this->_truncated;
+			}
+
+		protected:
+			char		*_buf;
+			size_type	_size;
+			size_type	_len;
+			bool		_truncated;
+			bool		_keyed;
+			uint8_t		_depth;
+			uint64_t	_filled;	//!< bit set for every nesting level holding at least one element
+
+			void		_put(const char *str, const size_type &len);
+			void		_put(const char &c);
+			void		_item(void);
+			void		_quote(const char *str, const size_type &len);
+			void		_open(const char &c);
+			void		_close(const char &c);
+
+		private:
+			formatter(void) = delete;
+			formatter(const formatter &src) = delete;
+
+			formatter &	operator=(const formatter &src) = delete;
+	};
+
+	//! @brief Format an object into a caller provided buffer
+	//! @return written length, terminating NUL excluded
+	template <typename T>
+	size_type			to_chars(char *buf, const size_type &size, const T &obj) {
+		formatter	f(buf, size);
+
+		obj.format(f);
+		return f.size();
+	}
+
+	//! @brief Return the output of fct as a std::string, growing it until it is not truncated
+	//! @details A single allocation is made when the output fits in reserve bytes, at least 64.
+	template <typename F>
+	const std::string	format_string(const F &fct, size_type reserve = 256) {
+		std::string	str;
+
+		for (reserve = std::max<size_type>(reserve, 64);; reserve *= 2) {
+			str.resize(reserve);
+
+			formatter	f(&str[0], str.size());
+
+			fct(f);
+			if (!f.truncated()) {
+				str.resize(f.size());
+				return str;
+			}
+		}
+	}
+};
+
+#endif
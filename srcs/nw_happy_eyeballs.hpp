@@ -0,0 +1,191 @@
+#ifndef __NW_HAPPY_EYEBALLS_HPP__
+# define __NW_HAPPY_EYEBALLS_HPP__
+
+/*!
+@file nw_happy_eyeballs.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <list>
+# include <algorithm>
+
+# include "nw_typedef.hpp"
+# include "nw_addr.hpp"
+# include "nw_addrinfo.hpp"
+# include "nw_socket.hpp"
+# include "nw_poller.hpp"
+
+namespace nw {
+	//! @tparam FAMILY nw::sa_family
+	template <sa_family FAMILY>
+	//! @brief Happy Eyeballs (RFC 8305) connection establishment over nw::addrinfo results
+	//! @details
+	//! Candidates are nw::sock_type::STREAM entries of the nw::addrinfo, interleaved by address family starting with the family of the first entry.
+	//! Non-blocking connects are started one "Connection Attempt Delay" apart (or as soon as the previous attempt fails), the first established
+	//! connection is returned and every other attempt is closed.
+	class happy_eyeballs {
+		public:
+			typedef socket<FAMILY, sock_type::STREAM>	socket_type;
+			typedef typename addrinfo<FAMILY>::data		data_type;
+
+			//! @brief Construct from nw::addrinfo results
+			happy_eyeballs(
+				const addrinfo<FAMILY> &ai,						//!< nw::addrinfo
+				const msec_type &attempt_delay = msec_type(250)	//!< Connection Attempt Delay, RFC 8305 recommends 250ms (100ms minimum)
+			) : _delay(std::max(attempt_delay, msec_type(10))) {
+				std::list<data_type>	other;
+
+				for (typename addrinfo<FAMILY>::const_iterator it = ai.begin(); it != ai.end(); ++it) {
+					if (it->get_type() != sock_type::STREAM)
+						continue ;
+					if (this->_candidates.empty() || it->get_family() == this->_candidates.front().get_family())
+						this->_candidates.push_back(*it);
+					else
+						other.push_back(*it);
+				}
+				if (other.empty())
+					return ;
+				for (typename std::list<data_type>::iterator it = std::next(this->_candidates.begin()); !other.empty(); ) {
+					this->_candidates.insert(it, other.front());
+					other.pop_front();
+					if (it != this->_candidates.end())
+						++it;
+				}
+			}
+
+			//! @brief Destructor
+			virtual	~happy_eyeballs(void) {}
+
+			//! @brief Race connection attempts, -1 timeout wait indefinitely
+			//! @return first connected nw::socket, in blocking mode
+			//! @throw nw::logic_error if there is no nw::sock_type::STREAM candidate
+			//! @throw nw::system_error with ETIMEDOUT if timeout expire, with last attempt error if every attempt fail's
+			socket_type	connect(
+				const msec_type &timeout = msec_type(-1)	//!< overall timeout
+			) {
+				if (this->_candidates.empty())
+					throw logic_error("happy_eyeballs: no stream address");
+
+				const time_point	deadline = (timeout.count() < 0) ? time_point::max() : clock_type::now() + timeout;
+				poller				p(this->_candidates.size());
+				std::list<attempt_type>	attempts;
+				typename std::list<data_type>::const_iterator	next = this->_candidates.begin();
+				time_point			next_start = clock_type::now();
+				int32_t				last_error = ECONNREFUSED;
+
+				while (true) {
+					time_point	now = clock_type::now();
+
+					while (next != this->_candidates.end() && (attempts.empty() || now >= next_start)) {
+						int32_t	error = this->_start(*next++, attempts, p);
+
+						if (!error)
+							return this->_win(attempts.back());
+						if (error == EINPROGRESS) {
+							next_start = now + this->_delay;
+							break ;
+						}
+						last_error = error;
+					}
+					if (attempts.empty())
+						throw system_error(last_error, std::generic_category(), "connect");
+					if (now >= deadline)
+						throw system_error(ETIMEDOUT, std::generic_category(), "connect");
+
+					p.wait((next != this->_candidates.end()) ? std::min(deadline, next_start) : deadline);
+					for (poller::const_iterator ev = p.begin(); ev != p.end(); ++ev) {
+						typename std::list<attempt_type>::iterator	it = attempts.begin();
+
+						while (it != attempts.end() && it->get_fd() != ev->data.fd)
+							++it;
+						if (it == attempts.end())
+							continue ;
+
+						int32_t	error = it->get_error();
+
+						if (!error)
+							return this->_win(*it);
+						last_error = error;
+						p.remove(it->get_fd());
+						attempts.erase(it);
+						next_start = now;
+					}
+				}
+			}
+
+			//! @brief Return a json formated std::string containing ordered candidates
+			//! @return json formated std::string
+			const std::string	to_string(void) const {
+				return format_string([this](formatter &f){ this->format(f); }, 128 * (this->_candidates.size() + 1));
+			}
+
+			//! @brief Write ordered candidates to a nw::formatter, without allocation
+			void				format(formatter &f) const {
+				f.begin_object();
+				f.key("attempt_delay").value(static_cast<int64_t>(this->_delay.count()));
+				f.key("candidates").begin_array();
+				for (typename std::list<data_type>::const_iterator it = this->_candidates.begin(); it != this->_candidates.end(); ++it)
+					it->get_addr().format(f);
+				f.end_array();
+				f.end_object();
+			}
+
+		protected:
+			typedef socket<sa_family::UNSPEC, sock_type::STREAM>	attempt_type;
+
+			const msec_type			_delay;
+			std::list<data_type>	_candidates;
+
+			//! @return 0 if connected, EINPROGRESS if pending, errno value otherwise
+			int32_t	_start(const data_type &data, std::list<attempt_type> &attempts, poller &p) {
+				switch (data.get_family()) {
+					case sa_family::INET:
+						return this->template _start_family<sa_family::INET>(data, attempts, p);
+					case sa_family::INET6:
+						return this->template _start_family<sa_family::INET6>(data, attempts, p);
+					default:
+						return EAFNOSUPPORT;
+				}
+			}
+
+			template <sa_family F>
+			int32_t	_start_family(const data_type &data, std::list<attempt_type> &attempts, poller &p) {
+				try {
+					socket<F, sock_type::STREAM>	s(data.get_proto());
+
+					s.set_nonblocking(true);
+					int32_t	error = s.connect(addr<F>(addr<sa_family::UNSPEC>(data.get_addr())), std::nothrow);
+					if (error == EINPROGRESS)
+						p.add(s.get_fd(), poller::OUT);
+					if (!error || error == EINPROGRESS)
+						attempts.emplace_back(std::move(s));
+					return error;
+				} catch (const system_error &e) {
+					return e.code().value();
+				}
+			}
+
+			socket_type	_win(attempt_type &attempt) {
+				attempt.set_nonblocking(false);
+				return socket_type(std::move(attempt));
+			}
+
+		private:
+			happy_eyeballs(void) = delete;
+			happy_eyeballs(const happy_eyeballs &src) = delete;
+			happy_eyeballs(happy_eyeballs &&src) = delete;
+
+			happy_eyeballs &	operator=(const happy_eyeballs &src) = delete;
+			happy_eyeballs &	operator=(happy_eyeballs &&src) = delete;
+	};
+};
+
+template <nw::sa_family FAMILY>
+std::ostream &	operator<<(std::ostream &o, const nw::happy_eyeballs<FAMILY> &C) {
+	o << C.to_string();
+	return o;
+}
+
+#endif
@@ -0,0 +1,210 @@
+
+/*!
+@file nw_histogram.cpp
+@brief ...
+*/
+
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cmath>
+
+#include "nw_histogram.hpp"
+
+const uint8_t		nw::latency_histogram::SUB_BITS;
+const uint8_t		nw::latency_histogram::MAX_BITS;
+const nw::size_type	nw::latency_histogram::BUCKETS;
+
+nw::latency_histogram::latency_histogram(void) {
+	this->reset();
+}
+
+nw::latency_histogram::~latency_histogram(void) {
+}
+
+nw::latency_histogram::value_type	nw::latency_histogram::_upper(const size_type &index) {
+	if (index + 1 == BUCKETS)
+		return std::numeric_limits<value_type>::max();
+	if (index < (size_type(2) << SUB_BITS))
+		return index;
+
+	const uint8_t	shift = static_cast<uint8_t>((index >> SUB_BITS) - 1);
+	const value_type	base = static_cast<value_type>((index & ((size_type(1) << SUB_BITS) - 1)) | (size_type(1) << SUB_BITS));
+
+	return ((base + 1) << shift) - 1;
+}
+
+void			nw::latency_histogram::record_corrected(const value_type &ns, const value_type &expected_interval) {
+	this->record(ns);
+	if (expected_interval && ns >= 2 * expected_interval)
+		this->_backfill(ns, expected_interval, 1);
+}
+
+void			nw::latency_histogram::merge_corrected(const latency_histogram &src, const value_type &expected_interval) {
+	this->merge(src);
+	if (!expected_interval)
+		return ;
+	for (size_type i = 0; i != BUCKETS; ++i) {
+		const value_type	ns = std::min(_upper(i), src._max);
+
+		if (src._counts[i] && ns >= 2 * expected_interval)
+			this->_backfill(ns, expected_interval, src._counts[i]);
+	}
+}
+
+//! @details Missed values are an arithmetic sequence: they are counted a bucket at a time, a long stall with a short
+//! interval costs a few iterations per bucket crossed, not one per missed request.
+void			nw::latency_histogram::_backfill(const value_type &ns, const value_type &expected_interval, const uint64_t &times) {
+	for (value_type missed = ns - expected_interval; missed >= expected_interval; ) {
+		const size_type		index = _index(missed);
+		const value_type	lower = std::max((index) ? _upper(index - 1) + 1 : 0, expected_interval);
+		const uint64_t		n = (missed - lower) / expected_interval + 1;
+		const value_type	last = missed - (n - 1) * expected_interval;
+
+		this->_counts[index] += n * times;
+		this->_count += n * times;
+		this->_sum += n * (missed + last) / 2 * times;
+		this->_min = std::min(this->_min, last);
+		missed = last - expected_interval;
+	}
+}
+
+void			nw::latency_histogram::merge(const latency_histogram &src) {
+	for (size_type i = 0; i != BUCKETS; ++i)
+		this->_counts[i] += src._counts[i];
+	this->_count += src._count;
+	this->_sum += src._sum;
+	this->_min = std::min(this->_min, src._min);
+	this->_max = std::max(this->_max, src._max);
+}
+
+void			nw::latency_histogram::reset(void) {
+	std::fill(this->_counts, this->_counts + BUCKETS, 0);
+	this->_count = 0;
+	this->_sum = 0;
+	this->_min = std::numeric_limits<value_type>::max();
+	this->_max = 0;
+}
+
+nw::latency_histogram::value_type	nw::latency_histogram::min(void) const {
+	return (this->_count) ? this->_min : 0;
+}
+
+nw::latency_histogram::value_type	nw::latency_histogram::max(void) const {
+	return this->_max;
+}
+
+double			nw::latency_histogram::mean(void) const {
+	return (this->_count) ? static_cast<double>(this->_sum) / static_cast<double>(this->_count) : 0;
+}
+
+nw::latency_histogram::value_type	nw::latency_histogram::percentile(const double &p) const {
+	if (!this->_count)
+		return 0;
+
+	const double	clamped = std::min(std::max(p, 0.), 100.);
+	const uint64_t	rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100. * static_cast<double>(this->_count) + 0.5));
+	uint64_t		seen = 0;
+
+	for (size_type i = 0; i != BUCKETS; ++i) {
+		seen += this->_counts[i];
+		if (seen >= rank)
+			return std::min(_upper(i), this->_max);
+	}
+	return this->_max;
+}
+
+const std::string	nw::latency_histogram::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 256);
+}
+
+void			nw::latency_histogram::format(formatter &f) const {
+	char	mean[32];
+	int		len = std::snprintf(mean, sizeof(mean), "%.1f", this->mean());
+
+	f.begin_object();
+	f.key("count").value(this->_count);
+	f.key("min").value(this->min());
+	f.key("mean").raw(mean, static_cast<size_type>(std::max(len, 0)));
+	f.key("p50").value(this->percentile(50));
+	f.key("p90").value(this->percentile(90));
+	f.key("p99").value(this->percentile(99));
+	f.key("p999").value(this->percentile(99.9));
+	f.key("max").value(this->max());
+	f.end_object();
+}
+
+const std::string	nw::latency_histogram::to_hgrm(const double &unit) const {
+	char		line[128];
+	std::string	str;
+	uint64_t	seen = 0;
+	double		variance = 0;
+
+	str = "       Value     Percentile TotalCount 1/(1-Percentile)\n\n";
+	for (size_type i = 0; i != BUCKETS; ++i) {
+		if (!this->_counts[i])
+			continue ;
+		seen += this->_counts[i];
+
+		const double	value = static_cast<double>(std::min(_upper(i), this->_max));
+		const double	p = static_cast<double>(seen) / static_cast<double>(this->_count);
+
+		variance += static_cast<double>(this->_counts[i]) * (value - this->mean()) * (value - this->mean());
+		if (seen == this->_count)
+			std::snprintf(line, sizeof(line), "%12.3f %2.12f %10llu\n", value / unit, p, static_cast<unsigned long long>(seen));
+		else
+			std::snprintf(line, sizeof(line), "%12.3f %2.12f %10llu %14.2f\n", value / unit, p, static_cast<unsigned long long>(seen), 1. / (1. - p));
+		str += line;
+	}
+	std::snprintf(line, sizeof(line), "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", this->mean() / unit,
+		(this->_count) ? std::sqrt(variance / static_cast<double>(this->_count)) / unit : 0.);
+	str += line;
+	std::snprintf(line, sizeof(line), "#[Max     = %12.3f, Total count    = %12llu]\n", static_cast<double>(this->max()) / unit,
+		static_cast<unsigned long long>(this->_count));
+	str += line;
+	std::snprintf(line, sizeof(line), "#[Buckets = %12llu, SubBuckets     = %12llu]\n", static_cast<unsigned long long>(MAX_BITS - SUB_BITS + 1),
+		static_cast<unsigned long long>(size_type(1) << SUB_BITS));
+	str += line;
+	return str;
+}
+
+void			nw::socket_latency::merge(const socket_latency &src) {
+	this->send.merge(src.send);
+	this->recv.merge(src.recv);
+	this->accept.merge(src.accept);
+	this->connect.merge(src.connect);
+}
+
+void			nw::socket_latency::reset(void) {
+	this->send.reset();
+	this->recv.reset();
+	this->accept.reset();
+	this->connect.reset();
+}
+
+const std::string	nw::socket_latency::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 1024);
+}
+
+void			nw::socket_latency::format(formatter &f) const {
+	f.begin_object();
+	f.key("send");
+	this->send.format(f);
+	f.key("recv");
+	this->recv.format(f);
+	f.key("accept");
+	this->accept.format(f);
+	f.key("connect");
+	this->connect.format(f);
+	f.end_object();
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::latency_histogram &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::socket_latency &C) {
+	o << C.to_string();
+	return (o);
+}
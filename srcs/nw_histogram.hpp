@@ -0,0 +1,167 @@
+#ifndef __NW_HISTOGRAM_HPP__
+# define __NW_HISTOGRAM_HPP__
+
+/*!
+@file nw_histogram.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+
+# include "nw_typedef.hpp"
+# include "nw_format.hpp"
+
+# ifdef NW_LATENCY_HISTOGRAMS
+#  define NW_LATENCY_SCOPE(histogram)	const nw::latency_histogram::scope	_nw_latency_scope(histogram)
+# else
+#  define NW_LATENCY_SCOPE(histogram)
+# endif
+
+namespace nw {
+	//! @brief Fixed memory log-linear histogram of durations in nanoseconds
+	//! @details
+	//! Values below 64ns are counted exactly, above each power of two range is split in 32 linear buckets, so that
+	//! any recorded value is known within 1/32 (about 3%). Values from 2^36ns (about 68s) share the last bucket.
+	//!
+	//! Recording is a few arithmetic instructions and never allocates. A histogram is meant to be recorded by a single
+	//! thread, histograms of several threads or sockets are combined with nw::latency_histogram::merge.
+	class latency_histogram {
+		public:
+			typedef uint64_t	value_type;
+
+			//! @brief Record the lifetime of the scope into a histogram
+			class scope {
+				public:
+					explicit scope(latency_histogram &h) : _h(h), _start(clock_type::now()) {}
+					~scope(void) {
+						this->_h.record(clock_type::now() - this->_start);
+					}
+
+				private:
+					latency_histogram	&_h;
+					const time_point	_start;
+
+					scope(const scope &src) = delete;
+					scope &	operator=(const scope &src) = delete;
+			};
+
+			latency_histogram(void);
+			virtual	~latency_histogram(void);
+
+			latency_histogram(const latency_histogram &src) = default;
+			latency_histogram &	operator=(const latency_histogram &src) = default;
+
+			//! @brief Record a value in nanoseconds
+			inline void	record(const value_type &ns) {
+				++this->_counts[_index(ns)];
+				++this->_count;
+				this->_sum += ns;
+				if (ns < this->_min)
+					this->_min = ns;
+				if (ns > this->_max)
+					this->_max = ns;
+			}
+
+			//! @brief Record a duration
+			inline void	record(const clock_type::duration &d) {
+				this->record(static_cast<value_type>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+			}
+
+			//! @brief Record a value in nanoseconds, corrected for coordinated omission
+			//! @details
+			//! A closed loop client waiting ns for a response did not send the requests it was expected to send every
+			//! expected_interval meanwhile: their latencies, ns - expected_interval, ns - 2 * expected_interval, ... down
+			//! to expected_interval, are recorded too (HdrHistogram recordValueWithExpectedInterval).
+			void		record_corrected(
+				const value_type &ns,					//!< measured latency
+				const value_type &expected_interval		//!< expected time between requests, 0 to record ns alone
+			);
+
+			//! @brief Add every value recorded by src
+			void		merge(const latency_histogram &src);
+
+			//! @brief Add every value recorded by src, corrected for coordinated omission after the run
+			//! @details
+			//! As nw::latency_histogram::record_corrected of each value of src, with values taken at the upper bound of
+			//! their bucket (HdrHistogram copyCorrectedForCoordinatedOmission): the interval can be derived from the whole
+			//! run, once it is over.
+			void		merge_corrected(
+				const latency_histogram &src,			//!< uncorrected values, not *this
+				const value_type &expected_interval		//!< expected time between requests, 0 to merge src alone
+			);
+
+			void		reset(void);
+
+			inline uint64_t		count(void) const {
+				return this->_count;
+			}
+
+			//! @brief Smallest recorded value, 0 if empty
+			value_type	min(void) const;
+
+			//! @brief Largest recorded value, 0 if empty
+			value_type	max(void) const;
+
+			double		mean(void) const;
+
+			//! @brief Upper bound of the bucket holding the value at percentile (0 to 100), 0 if empty
+			value_type	percentile(const double &p) const;
+
+			const std::string	to_string(void) const;
+
+			//! @brief Write count, min, mean, percentiles and max to a nw::formatter, without allocation
+			void				format(formatter &f) const;
+
+			//! @brief Return the percentile distribution in HdrHistogram text format (.hgrm), one line per non empty bucket
+			//! @details Values are divided by unit, 1000 for microseconds, the output can be plotted by HdrHistogram tools.
+			const std::string	to_hgrm(const double &unit = 1000.) const;
+
+		protected:
+			static const uint8_t	SUB_BITS	= 5;
+			static const uint8_t	MAX_BITS	= 36;
+			static const size_type	BUCKETS		= (MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+
+			uint64_t	_counts[BUCKETS];
+			uint64_t	_count;
+			uint64_t	_sum;
+			value_type	_min;
+			value_type	_max;
+
+			static inline size_type	_index(value_type ns) {
+				if (ns >> MAX_BITS)
+					return BUCKETS - 1;
+				if (ns < (value_type(2) << SUB_BITS))
+					return static_cast<size_type>(ns);
+
+				const uint8_t	shift = static_cast<uint8_t>(63 - __builtin_clzll(ns) - SUB_BITS);
+
+				return (static_cast<size_type>(shift) << SUB_BITS) + static_cast<size_type>(ns >> shift);
+			}
+
+			//! @return highest value counted in bucket index
+			static value_type		_upper(const size_type &index);
+
+			//! @brief Count times the values missed while waiting ns
+			void					_backfill(const value_type &ns, const value_type &expected_interval, const uint64_t &times);
+	};
+
+	//! @brief nw::socket per operation latency histograms, see NW_LATENCY_HISTOGRAMS
+	struct	socket_latency {
+		latency_histogram	send;
+		latency_histogram	recv;
+		latency_histogram	accept;
+		latency_histogram	connect;
+
+		void	merge(const socket_latency &src);
+		void	reset(void);
+
+		const std::string	to_string(void) const;
+		void				format(formatter &f) const;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::latency_histogram &C);
+std::ostream &	operator<<(std::ostream &o, const nw::socket_latency &C);
+
+#endif
@@ -0,0 +1,220 @@
+
+/*!
+@file nw_io_ring.cpp
+@brief ...
+*/
+
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include "nw_io_ring.hpp"
+#include "nw_format.hpp"
+#include "nw_transport.hpp"
+
+static int	io_uring_setup(unsigned entries, struct io_uring_params *params) {
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int	io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void *arg, size_t argsz) {
+	return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz));
+}
+
+static const std::function<int(unsigned, struct io_uring_params *)>				_s_io_uring_setup = &io_uring_setup;
+static const std::function<int(int, unsigned, unsigned, unsigned, \
+		const void *, size_t)>													_s_io_uring_enter = &io_uring_enter;
+static const std::function<void *(void *, size_t, int, int, int, off_t)>		_s_mmap = &mmap;
+static const std::function<int(void *, size_t)>									_s_munmap = &munmap;
+static const std::function<int(int)> &										_s_close = nw::transport::current.close;
+
+nw::io_ring::io_ring(const uint32_t &entries) \
+	: _fd(-1), _sq_map(nullptr), _sq_map_size(0), _cq_map(nullptr), _cq_map_size(0), _sqes(nullptr), _sqes_size(0), \
+	_sq_head(nullptr), _sq_tail(nullptr), _sq_mask(nullptr), _sq_array(nullptr), _sq_entries(0), _tail(0), \
+	_cq_head(nullptr), _cq_tail(nullptr), _cq_mask(nullptr), _cqes(nullptr), _stats() {
+	struct io_uring_params	params = {};
+
+	if ((this->_fd = _s_io_uring_setup(entries, &params)) == -1)
+		throw system_error(errno, std::generic_category(), "io_uring_setup");
+	try {
+		void	*map;
+
+		this->_sq_map_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		this->_cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+			this->_sq_map_size = this->_cq_map_size = std::max(this->_sq_map_size, this->_cq_map_size);
+		if ((map = _s_mmap(nullptr, this->_sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->_fd, IORING_OFF_SQ_RING)) == MAP_FAILED)
+			throw system_error(errno, std::generic_category(), "mmap");
+		this->_sq_map = static_cast<uint8_t *>(map);
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+			this->_cq_map = this->_sq_map;
+		else if ((map = _s_mmap(nullptr, this->_cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->_fd, IORING_OFF_CQ_RING)) == MAP_FAILED)
+			throw system_error(errno, std::generic_category(), "mmap");
+		else
+			this->_cq_map = static_cast<uint8_t *>(map);
+		this->_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+		if ((map = _s_mmap(nullptr, this->_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->_fd, IORING_OFF_SQES)) == MAP_FAILED)
+			throw system_error(errno, std::generic_category(), "mmap");
+		this->_sqes = static_cast<struct io_uring_sqe *>(map);
+	} catch (...) {
+		this->_unmap();
+		_s_close(this->_fd);
+		throw ;
+	}
+	this->_sq_head = reinterpret_cast<uint32_t *>(this->_sq_map + params.sq_off.head);
+	this->_sq_tail = reinterpret_cast<uint32_t *>(this->_sq_map + params.sq_off.tail);
+	this->_sq_mask = reinterpret_cast<uint32_t *>(this->_sq_map + params.sq_off.ring_mask);
+	this->_sq_array = reinterpret_cast<uint32_t *>(this->_sq_map + params.sq_off.array);
+	this->_sq_entries = params.sq_entries;
+	this->_tail = *this->_sq_tail;
+	this->_cq_head = reinterpret_cast<uint32_t *>(this->_cq_map + params.cq_off.head);
+	this->_cq_tail = reinterpret_cast<uint32_t *>(this->_cq_map + params.cq_off.tail);
+	this->_cq_mask = reinterpret_cast<uint32_t *>(this->_cq_map + params.cq_off.ring_mask);
+	this->_cqes = reinterpret_cast<struct io_uring_cqe *>(this->_cq_map + params.cq_off.cqes);
+}
+
+nw::io_ring::~io_ring(void) {
+	this->_unmap();
+	_s_close(this->_fd);
+}
+
+void						nw::io_ring::_unmap(void) {
+	if (this->_sqes)
+		_s_munmap(this->_sqes, this->_sqes_size);
+	if (this->_cq_map && this->_cq_map != this->_sq_map)
+		_s_munmap(this->_cq_map, this->_cq_map_size);
+	if (this->_sq_map)
+		_s_munmap(this->_sq_map, this->_sq_map_size);
+}
+
+//! @details
+//! Entries are used in ring order, the array maps ring slot i to entry i. The shared tail is published by
+//! nw::io_ring::submit, once entries are filled.
+struct io_uring_sqe *		nw::io_ring::_next(void) {
+	if (this->pending() == this->_sq_entries)
+		return nullptr;
+
+	const uint32_t		index = this->_tail & *this->_sq_mask;
+	struct io_uring_sqe	*sqe = &this->_sqes[index];
+
+	std::memset(sqe, 0, sizeof(*sqe));
+	this->_sq_array[index] = index;
+	++this->_tail;
+	++this->_stats.queued;
+	return sqe;
+}
+
+bool						nw::io_ring::recv(const sockfd_type &fd, void *buf, const size_type &len, const uint64_t &user_data, const int32_t &flags) {
+	struct io_uring_sqe	*sqe = this->_next();
+
+	if (!sqe)
+		return false;
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uint64_t>(buf);
+	sqe->len = static_cast<uint32_t>(len);
+	sqe->msg_flags = static_cast<uint32_t>(flags);
+	sqe->user_data = user_data;
+	return true;
+}
+
+bool						nw::io_ring::send(const sockfd_type &fd, const void *buf, const size_type &len, const uint64_t &user_data, const int32_t &flags) {
+	struct io_uring_sqe	*sqe = this->_next();
+
+	if (!sqe)
+		return false;
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uint64_t>(buf);
+	sqe->len = static_cast<uint32_t>(len);
+	sqe->msg_flags = static_cast<uint32_t>(flags);
+	sqe->user_data = user_data;
+	return true;
+}
+
+bool						nw::io_ring::poll(const sockfd_type &fd, const uint32_t &events, const uint64_t &user_data) {
+	struct io_uring_sqe	*sqe = this->_next();
+
+	if (!sqe)
+		return false;
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = events;
+	sqe->user_data = user_data;
+	return true;
+}
+
+nw::size_type				nw::io_ring::submit(const uint32_t &wait) {
+	return this->_enter(wait, (wait) ? IORING_ENTER_GETEVENTS : 0, nullptr, _NSIG / 8);
+}
+
+nw::size_type				nw::io_ring::submit(const uint32_t &wait, const msec_type &timeout) {
+	struct __kernel_timespec		ts = {};
+	struct io_uring_getevents_arg	arg = {};
+
+	ts.tv_sec = timeout.count() / 1000;
+	ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+	arg.ts = reinterpret_cast<uint64_t>(&ts);
+	return this->_enter(wait, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+nw::size_type				nw::io_ring::_enter(const uint32_t &wait, const uint32_t &flags, const void *arg, const size_type &argsz) {
+	const size_type	queued = this->pending();
+
+	if (!queued && !wait)
+		return 0;
+	__atomic_store_n(this->_sq_tail, this->_tail, __ATOMIC_RELEASE);
+	++this->_stats.enters;
+	if (_s_io_uring_enter(this->_fd, static_cast<unsigned>(queued), wait, flags, arg, argsz) == -1 && errno != EINTR && errno != ETIME)
+		throw system_error(errno, std::generic_category(), "io_uring_enter");
+	return queued - this->pending();
+}
+
+nw::size_type				nw::io_ring::pending(void) const {
+	return this->_tail - __atomic_load_n(this->_sq_head, __ATOMIC_ACQUIRE);
+}
+
+const nw::sockfd_type &		nw::io_ring::get_fd(void) const {
+	return this->_fd;
+}
+
+const nw::io_ring_stats &	nw::io_ring::get_stats(void) const {
+	return this->_stats;
+}
+
+const std::string			nw::io_ring_stats::to_string(void) const {
+	return format_string([this](formatter &f){
+		f.begin_object();
+		f.key("queued").value(this->queued);
+		f.key("completed").value(this->completed);
+		f.key("enters").value(this->enters);
+		f.end_object();
+	});
+}
+
+const std::string			nw::io_ring::to_string(void) const {
+	return format_string([this](formatter &f){
+		f.begin_object();
+		f.key("fd").value(this->_fd);
+		f.key("entries").value(this->_sq_entries);
+		f.key("pending").value(static_cast<uint64_t>(this->pending()));
+		f.key("queued").value(this->_stats.queued);
+		f.key("completed").value(this->_stats.completed);
+		f.key("enters").value(this->_stats.enters);
+		f.end_object();
+	});
+}
+
+std::ostream &				operator<<(std::ostream &o, const nw::io_ring_stats &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &				operator<<(std::ostream &o, const nw::io_ring &C) {
+	o << C.to_string();
+	return (o);
+}
@@ -0,0 +1,147 @@
+#ifndef __NW_IO_RING_HPP__
+# define __NW_IO_RING_HPP__
+
+/*!
+@file nw_io_ring.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+
+# include <linux/io_uring.h>
+
+# include "nw_typedef.hpp"
+
+namespace nw {
+	//! @brief Completion of an operation queued on a nw::io_ring
+	struct	io_completion {
+		uint64_t	user_data;	//!< value given when the operation was queued
+		int32_t		res;		//!< result of the matching system call, -errno on failure
+		uint32_t	flags;		//!< IORING_CQE_F_* flags
+	};
+
+	//! @brief nw::io_ring counters, accumulated since construction
+	struct	io_ring_stats {
+		uint64_t	queued;		//!< operations queued
+		uint64_t	completed;	//!< completions read
+		uint64_t	enters;		//!< io_uring_enter(2) system calls
+
+		const std::string	to_string(void) const;
+	};
+
+	//! @brief Completion based I/O (io_uring(7) instance)
+	//! @details
+	//! Operations are queued in the submission ring shared with the kernel, handed over in batches by nw::io_ring::submit
+	//! which also waits for completions, read in place from the completion ring by nw::io_ring::complete: a single system
+	//! call submits and reaps any number of operations. Buffers given to an operation must stay valid until its
+	//! completion is read.
+	//!
+	//! The ring is used by a single thread.
+	class io_ring {
+		public:
+			//! @brief Create and map the rings
+			//! @throw nw::system_error if io_uring_setup(2) or mmap(2) function fail's
+			explicit io_ring(
+				const uint32_t &entries = 256	//!< submission ring size, rounded up to a power of 2 by the kernel
+			);
+
+			//! @brief Destructor, unmap the rings and close the instance, operations in flight are cancelled
+			virtual	~io_ring(void);
+
+			//! @brief Queue a recv(2) of at most len bytes into buf
+			//! @return false if the submission ring is full, nw::io_ring::submit makes room
+			bool		recv(const sockfd_type &fd, void *buf, const size_type &len, const uint64_t &user_data, const int32_t &flags = 0);
+
+			//! @brief Queue a send(2) of len bytes from buf
+			//! @return false if the submission ring is full, nw::io_ring::submit makes room
+			bool		send(const sockfd_type &fd, const void *buf, const size_type &len, const uint64_t &user_data, const int32_t &flags = 0);
+
+			//! @brief Queue a one shot wait for nw::poller events on fd, completed with the ready events
+			//! @return false if the submission ring is full, nw::io_ring::submit makes room
+			bool		poll(const sockfd_type &fd, const uint32_t &events, const uint64_t &user_data);
+
+			//! @brief Hand queued operations to the kernel and wait until wait completions are ready
+			//! @return number of operations handed over
+			//! @throw nw::system_error if io_uring_enter(2) function fail's (EINTR excepted)
+			size_type	submit(const uint32_t &wait = 0);
+
+			//! @brief Hand queued operations to the kernel and wait until wait completions are ready or timeout expire
+			//! @details Requires IORING_FEAT_EXT_ARG (Linux 5.11).
+			//! @return number of operations handed over
+			//! @throw nw::system_error if io_uring_enter(2) function fail's (EINTR and ETIME excepted)
+			size_type	submit(const uint32_t &wait, const msec_type &timeout);
+
+			//! @tparam F void(const nw::io_completion &) callable
+			template <typename F>
+			//! @brief Call fct on every ready completion, without waiting
+			//! @details fct may queue operations.
+			//! @return number of completions read
+			size_type	complete(const F &fct) {
+				size_type	count = 0;
+
+				while (true) {
+					const uint32_t	head = *this->_cq_head;
+
+					if (head == __atomic_load_n(this->_cq_tail, __ATOMIC_ACQUIRE))
+						break ;
+
+					const struct io_uring_cqe	&cqe = this->_cqes[head & *this->_cq_mask];
+					const io_completion			c = {cqe.user_data, cqe.res, cqe.flags};
+
+					__atomic_store_n(this->_cq_head, head + 1, __ATOMIC_RELEASE);
+					++this->_stats.completed;
+					++count;
+					fct(c);
+				}
+				return count;
+			}
+
+			//! @brief Number of operations queued and not handed over yet
+			size_type	pending(void) const;
+
+			//! @brief Return the io_uring instance file descriptor
+			const sockfd_type &	get_fd(void) const;
+
+			const io_ring_stats &	get_stats(void) const;
+
+			const std::string	to_string(void) const;
+
+		protected:
+			sockfd_type				_fd;
+			uint8_t					*_sq_map;
+			size_type				_sq_map_size;
+			uint8_t					*_cq_map;		//!< same as _sq_map with IORING_FEAT_SINGLE_MMAP
+			size_type				_cq_map_size;
+			struct io_uring_sqe		*_sqes;
+			size_type				_sqes_size;
+			uint32_t				*_sq_head;
+			uint32_t				*_sq_tail;
+			uint32_t				*_sq_mask;
+			uint32_t				*_sq_array;
+			uint32_t				_sq_entries;
+			uint32_t				_tail;			//!< submission tail, ahead of the shared one until nw::io_ring::submit
+			uint32_t				*_cq_head;
+			uint32_t				*_cq_tail;
+			uint32_t				*_cq_mask;
+			struct io_uring_cqe		*_cqes;
+			io_ring_stats			_stats;
+
+			//! @return next free submission entry, zeroed, nullptr if the ring is full
+			struct io_uring_sqe *	_next(void);
+			size_type				_enter(const uint32_t &wait, const uint32_t &flags, const void *arg, const size_type &argsz);
+			void					_unmap(void);
+
+		private:
+			io_ring(const io_ring &src) = delete;
+			io_ring(io_ring &&src) = delete;
+
+			io_ring &	operator=(const io_ring &src) = delete;
+			io_ring &	operator=(io_ring &&src) = delete;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::io_ring_stats &C);
+std::ostream &	operator<<(std::ostream &o, const nw::io_ring &C);
+
+#endif
@@ -0,0 +1,181 @@
+
+/*!
+@file nw_io_stats.cpp
+@brief ...
+*/
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+
+#include "nw_io_stats.hpp"
+
+const nw::size_type	nw::global_io_stats::ERRNOS;
+
+static const uint8_t	_COUNTERS = static_cast<uint8_t>(nw::io_counter::COUNT);
+
+//! @brief Live thread counters and counts of exited threads
+struct	_registry {
+	std::mutex								lock;
+	std::set<const nw::global_io_counters *>	threads;
+	nw::global_io_stats						exited;
+};
+
+static _registry &	_get_registry(void) {
+	static _registry	registry;
+
+	return registry;
+}
+
+static void			_set(nw::io_stats &stats, const uint8_t &i, const uint64_t &value) {
+	uint64_t	*fields[_COUNTERS] = {
+		&stats.bytes_in, &stats.bytes_out, &stats.syscalls, &stats.short_reads,
+		&stats.short_writes, &stats.would_block, &stats.buffer_full, &stats.errors
+	};
+
+	*fields[i] = value;
+}
+
+static uint64_t		_get(const nw::io_stats &stats, const uint8_t &i) {
+	const uint64_t	*fields[_COUNTERS] = {
+		&stats.bytes_in, &stats.bytes_out, &stats.syscalls, &stats.short_reads,
+		&stats.short_writes, &stats.would_block, &stats.buffer_full, &stats.errors
+	};
+
+	return *fields[i];
+}
+
+static void			_fields(const nw::io_stats &stats, nw::formatter &f) {
+	f.key("bytes_in").value(stats.bytes_in);
+	f.key("bytes_out").value(stats.bytes_out);
+	f.key("syscalls").value(stats.syscalls);
+	f.key("short_reads").value(stats.short_reads);
+	f.key("short_writes").value(stats.short_writes);
+	f.key("would_block").value(stats.would_block);
+	f.key("buffer_full").value(stats.buffer_full);
+	f.key("errors").value(stats.errors);
+	f.key("last_error").value(stats.last_error);
+}
+
+const std::string	nw::io_stats::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); });
+}
+
+void				nw::io_stats::format(formatter &f) const {
+	f.begin_object();
+	_fields(*this, f);
+	f.end_object();
+}
+
+const std::string	nw::global_io_stats::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 512);
+}
+
+void				nw::global_io_stats::format(formatter &f) const {
+	char	name[4];
+
+	f.begin_object();
+	_fields(*this, f);
+	f.key("errnos").begin_object();
+	for (size_type i = 0; i != ERRNOS; ++i) {
+		if (!this->errnos[i])
+			continue ;
+		formatter(name, sizeof(name)).value(static_cast<uint64_t>(i));
+		f.key(name).value(this->errnos[i]);
+	}
+	f.end_object();
+	f.end_object();
+}
+
+nw::io_counters::io_counters(void) {
+	this->reset();
+}
+
+nw::io_counters::io_counters(const io_counters &src) {
+	for (uint8_t i = 0; i != _COUNTERS; ++i)
+		this->_values[i].store(src._values[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	this->_last_error.store(src._last_error.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+nw::io_counters::~io_counters(void) {
+}
+
+nw::io_stats		nw::io_counters::snapshot(void) const {
+	io_stats	stats = {};
+
+	for (uint8_t i = 0; i != _COUNTERS; ++i)
+		_set(stats, i, this->_values[i].load(std::memory_order_relaxed));
+	stats.last_error = this->_last_error.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void				nw::io_counters::reset(void) {
+	for (uint8_t i = 0; i != _COUNTERS; ++i)
+		this->_values[i].store(0, std::memory_order_relaxed);
+	this->_last_error.store(0, std::memory_order_relaxed);
+}
+
+nw::global_io_counters::global_io_counters(void) {
+	for (uint8_t i = 0; i != _COUNTERS; ++i)
+		this->_values[i].store(0, std::memory_order_relaxed);
+	this->_last_error.store(0, std::memory_order_relaxed);
+	for (size_type i = 0; i != global_io_stats::ERRNOS; ++i)
+		this->_errnos[i].store(0, std::memory_order_relaxed);
+
+	_registry						&registry = _get_registry();
+	const std::lock_guard<std::mutex>	guard(registry.lock);
+
+	registry.threads.insert(this);
+}
+
+nw::global_io_counters::~global_io_counters(void) {
+	_registry						&registry = _get_registry();
+	const std::lock_guard<std::mutex>	guard(registry.lock);
+
+	this->_add_to(registry.exited);
+	registry.threads.erase(this);
+}
+
+nw::global_io_counters &	nw::global_io_counters::_local(void) {
+	static thread_local global_io_counters	counters;
+
+	return counters;
+}
+
+void				nw::global_io_counters::error(const int32_t &error) {
+	global_io_counters		&counters = _local();
+	std::atomic<uint64_t>	&value = counters._errnos[(error > 0 && static_cast<size_type>(error) < global_io_stats::ERRNOS) ? error : 0];
+
+	add(io_counter::ERRORS);
+	value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	counters._last_error.store(error, std::memory_order_relaxed);
+}
+
+void				nw::global_io_counters::_add_to(global_io_stats &stats) const {
+	for (uint8_t i = 0; i != _COUNTERS; ++i)
+		_set(stats, i, _get(stats, i) + this->_values[i].load(std::memory_order_relaxed));
+	for (size_type i = 0; i != global_io_stats::ERRNOS; ++i)
+		stats.errnos[i] += this->_errnos[i].load(std::memory_order_relaxed);
+	if (this->_last_error.load(std::memory_order_relaxed))
+		stats.last_error = this->_last_error.load(std::memory_order_relaxed);
+}
+
+nw::global_io_stats	nw::global_io_counters::snapshot(void) {
+	_registry						&registry = _get_registry();
+	const std::lock_guard<std::mutex>	guard(registry.lock);
+	global_io_stats					stats = registry.exited;
+
+	for (std::set<const global_io_counters *>::const_iterator it = registry.threads.begin(); it != registry.threads.end(); ++it)
+		(*it)->_add_to(stats);
+	return stats;
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::io_stats &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::global_io_stats &C) {
+	o << C.to_string();
+	return (o);
+}
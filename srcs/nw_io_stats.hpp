@@ -0,0 +1,128 @@
+#ifndef __NW_IO_STATS_HPP__
+# define __NW_IO_STATS_HPP__
+
+/*!
+@file nw_io_stats.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <atomic>
+
+# include "nw_typedef.hpp"
+# include "nw_format.hpp"
+
+namespace nw {
+	//! @enum io_counter
+	enum class	io_counter : uint8_t {
+		BYTES_IN,		//!< bytes received
+		BYTES_OUT,		//!< bytes sent
+		SYSCALLS,		//!< system calls issued
+		SHORT_READS,	//!< receive system calls returning less than the space offered
+		SHORT_WRITES,	//!< send system calls accepting less than the data offered
+		WOULD_BLOCK,	//!< system calls failed with EAGAIN, EWOULDBLOCK or EINPROGRESS
+		BUFFER_FULL,	//!< receive attempts on a full nw::ibuffer
+		ERRORS,			//!< system calls failed otherwise
+		COUNT
+	};
+
+	//! @brief I/O counters snapshot
+	struct	io_stats {
+		uint64_t	bytes_in;
+		uint64_t	bytes_out;
+		uint64_t	syscalls;
+		uint64_t	short_reads;
+		uint64_t	short_writes;
+		uint64_t	would_block;
+		uint64_t	buffer_full;
+		uint64_t	errors;
+		int32_t		last_error;		//!< errno of the last error, 0 if none
+
+		const std::string	to_string(void) const;
+		void				format(formatter &f) const;
+	};
+
+	//! @brief Process wide I/O counters snapshot, with errors by errno
+	struct	global_io_stats : public io_stats {
+		static const size_type	ERRNOS = 134;	//!< errno values counted one by one, errnos[0] counts any other value
+
+		uint64_t	errnos[ERRNOS];
+
+		const std::string	to_string(void) const;
+		void				format(formatter &f) const;
+	};
+
+	//! @brief Relaxed atomic I/O counters of a single socket
+	//! @details
+	//! Counters are written by the thread driving the socket, as a relaxed load and store without locked instruction,
+	//! and read at any time, they are not ordered with each other. Counts of a socket used by several threads at once
+	//! (a listener shared by event loops) may be lost.
+	class io_counters {
+		public:
+			io_counters(void);
+			io_counters(const io_counters &src);
+			virtual	~io_counters(void);
+
+			inline void	add(const io_counter &counter, const uint64_t &n = 1) {
+				std::atomic<uint64_t>	&value = this->_values[static_cast<uint8_t>(counter)];
+
+				value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+			}
+
+			inline void	error(const int32_t &error) {
+				this->add(io_counter::ERRORS);
+				this->_last_error.store(error, std::memory_order_relaxed);
+			}
+
+			io_stats	snapshot(void) const;
+			void		reset(void);
+
+		protected:
+			std::atomic<uint64_t>	_values[static_cast<uint8_t>(io_counter::COUNT)];
+			std::atomic<int32_t>	_last_error;
+
+		private:
+			io_counters &	operator=(const io_counters &src) = delete;
+	};
+
+	//! @brief Process wide I/O counters
+	//! @details
+	//! Every thread counts into its own block of relaxed atomics, written by that thread only: counting never takes a lock
+	//! nor a locked instruction. snapshot sums the blocks of live threads and the counts of exited ones, the registry
+	//! lock is taken only there and at thread start and exit.
+	class global_io_counters {
+		public:
+			static inline void	add(const io_counter &counter, const uint64_t &n = 1) {
+				std::atomic<uint64_t>	&value = _local()._values[static_cast<uint8_t>(counter)];
+
+				value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+			}
+
+			static void			error(const int32_t &error);
+
+			//! @brief Sum of every thread counters
+			static global_io_stats	snapshot(void);
+
+		protected:
+			std::atomic<uint64_t>	_values[static_cast<uint8_t>(io_counter::COUNT)];
+			std::atomic<int32_t>	_last_error;
+			std::atomic<uint64_t>	_errnos[global_io_stats::ERRNOS];
+
+			global_io_counters(void);
+			virtual	~global_io_counters(void);
+
+			static global_io_counters &	_local(void);
+
+			void	_add_to(global_io_stats &stats) const;
+
+		private:
+			global_io_counters(const global_io_counters &src) = delete;
+			global_io_counters &	operator=(const global_io_counters &src) = delete;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::io_stats &C);
+std::ostream &	operator<<(std::ostream &o, const nw::global_io_stats &C);
+
+#endif
@@ -0,0 +1,104 @@
+
+/*!
+@file nw_load_generator.cpp
+@brief ...
+*/
+
+#include <algorithm>
+
+#include "nw_load_generator.hpp"
+
+const nw::size_type	nw::load_config::MAX_CONNECTIONS;
+
+const char *		nw::load_mode_name(const load_mode &mode) {
+	switch (mode) {
+		case load_mode::CLOSED:	return "closed";
+		case load_mode::OPEN:	return "open";
+	}
+	return "unknown";
+}
+
+nw::load_config::load_config(void) \
+	: mode(load_mode::CLOSED), connections(1), threads(1), request_size(64), response_size(64), pipeline(1), rate(0), \
+	expected_interval(0), warmup(1000), duration(10000), connect_timeout(5000) {
+}
+
+void				nw::load_config::validate(void) const {
+	if (!this->connections || this->connections > MAX_CONNECTIONS)
+		throw logic_error("load_config: connections out of range");
+	if (!this->request_size)
+		throw logic_error("load_config: empty requests");
+	if (this->mode == load_mode::CLOSED && !this->pipeline)
+		throw logic_error("load_config: closed loop requires a pipeline depth");
+	if (this->mode == load_mode::OPEN && !this->rate)
+		throw logic_error("load_config: open loop requires a rate");
+	if (this->expected_interval && !this->response_size)
+		throw logic_error("load_config: coordinated omission correction requires responses");
+	if (this->duration.count() <= 0 || this->warmup.count() < 0)
+		throw logic_error("load_config: invalid duration");
+}
+
+nw::load_report::load_report(void) \
+	: connections(0), connect_errors(0), errors(0), requests(0), responses(0), outstanding(0), bytes_out(0), bytes_in(0), \
+	elapsed(0), latency(), service_time() {
+}
+
+void				nw::load_report::merge(const load_report &src) {
+	this->connections += src.connections;
+	this->connect_errors += src.connect_errors;
+	this->errors += src.errors;
+	this->requests += src.requests;
+	this->responses += src.responses;
+	this->outstanding += src.outstanding;
+	this->bytes_out += src.bytes_out;
+	this->bytes_in += src.bytes_in;
+	this->elapsed = std::max(this->elapsed, src.elapsed);
+	this->latency.merge(src.latency);
+	this->service_time.merge(src.service_time);
+}
+
+double				nw::load_report::throughput(void) const {
+	return (this->elapsed.count() > 0) ? static_cast<double>(this->responses) * 1e9 / static_cast<double>(this->elapsed.count()) : 0;
+}
+
+const std::string	nw::load_report::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 1024);
+}
+
+static void			_format_latency(nw::formatter &f, const nw::latency_histogram &h) {
+	f.begin_object();
+	f.key("count").value(h.count());
+	f.key("min").value(h.min());
+	f.key("mean").value(static_cast<uint64_t>(h.mean()));
+	f.key("p50").value(h.percentile(50));
+	f.key("p90").value(h.percentile(90));
+	f.key("p99").value(h.percentile(99));
+	f.key("p999").value(h.percentile(99.9));
+	f.key("p9999").value(h.percentile(99.99));
+	f.key("max").value(h.max());
+	f.end_object();
+}
+
+void				nw::load_report::format(formatter &f) const {
+	f.begin_object();
+	f.key("connections").value(this->connections);
+	f.key("connect_errors").value(this->connect_errors);
+	f.key("errors").value(this->errors);
+	f.key("requests").value(this->requests);
+	f.key("responses").value(this->responses);
+	f.key("outstanding").value(this->outstanding);
+	f.key("bytes_out").value(this->bytes_out);
+	f.key("bytes_in").value(this->bytes_in);
+	f.key("elapsed_ns").value(static_cast<int64_t>(this->elapsed.count()));
+	f.key("throughput").value(static_cast<uint64_t>(this->throughput()));
+	f.key("latency");
+	_format_latency(f, this->latency);
+	f.key("service_time");
+	_format_latency(f, this->service_time);
+	f.end_object();
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::load_report &C) {
+	o << C.to_string();
+	return (o);
+}
@@ -0,0 +1,470 @@
+#ifndef __NW_LOAD_GENERATOR_HPP__
+# define __NW_LOAD_GENERATOR_HPP__
+
+/*!
+@file nw_load_generator.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <vector>
+# include <deque>
+# include <memory>
+# include <thread>
+# include <atomic>
+# include <exception>
+# include <algorithm>
+
+# include "nw_typedef.hpp"
+# include "nw_format.hpp"
+# include "nw_histogram.hpp"
+# include "nw_poller.hpp"
+# include "nw_socket.hpp"
+# include "buffer/nw_ibuffer.hpp"
+# include "buffer/nw_obuffer.hpp"
+
+namespace nw {
+	//! @enum load_mode
+	enum class	load_mode : uint8_t {
+		CLOSED,	//!< Every connection sends its next request when a response arrives, keeping nw::load_config::pipeline in flight
+		OPEN	//!< Requests are sent at nw::load_config::rate whatever the response times, round robin over connections
+	};
+
+	const char *	load_mode_name(const load_mode &mode);
+
+	//! @brief nw::load_generator parameters
+	struct	load_config {
+		static const size_type	MAX_CONNECTIONS = 100000;
+
+		load_mode	mode;
+		size_type	connections;		//!< 1 to nw::load_config::MAX_CONNECTIONS
+		size_type	threads;			//!< client threads, connections are split between them
+		size_type	request_size;		//!< bytes sent per request
+		size_type	response_size;		//!< bytes expected per response, 0 for a sink: a request completes once written
+		size_type	pipeline;			//!< nw::load_mode::CLOSED requests in flight per connection
+		uint64_t	rate;				//!< nw::load_mode::OPEN requests per second, over every connection
+		uint64_t	expected_interval;	//!< nw::load_mode::CLOSED coordinated omission correction interval in ns, 0 for the run mean
+		msec_type	warmup;				//!< run time before recording
+		msec_type	duration;			//!< recorded run time
+		msec_type	connect_timeout;
+
+		load_config(void);
+
+		//! @throw nw::logic_error if a parameter is out of range
+		void	validate(void) const;
+	};
+
+	//! @brief nw::load_generator results, recorded after warmup
+	struct	load_report {
+		uint64_t					connections;		//!< established connections
+		uint64_t					connect_errors;
+		uint64_t					errors;				//!< connections reset or closed by the peer during the run
+		uint64_t					requests;			//!< requests started
+		uint64_t					responses;			//!< requests completed
+		uint64_t					outstanding;		//!< requests queued or in flight at the end of the run
+		uint64_t					bytes_out;
+		uint64_t					bytes_in;
+		std::chrono::nanoseconds	elapsed;			//!< recorded run time
+		latency_histogram			latency;			//!< from the time each request should have been sent, corrected for coordinated omission
+		latency_histogram			service_time;		//!< from the first byte of each request sent to its response, uncorrected
+
+		load_report(void);
+
+		//! @brief Add counters and histograms of the report of another thread, elapsed is the longest
+		void	merge(const load_report &src);
+
+		//! @brief Return completed requests per second
+		double	throughput(void) const;
+
+		const std::string	to_string(void) const;
+
+		//! @brief Write report to a nw::formatter, without allocation
+		void				format(formatter &f) const;
+	};
+
+	//! @tparam FAMILY nw::sa_family of the target
+	//! @tparam SIZE send and receive buffers size, one of each per thread
+	template <sa_family FAMILY, size_type SIZE = 16384>
+	//! @brief Connection based load generator measuring request latencies against a nw::sock_type::STREAM server
+	//! @details
+	//! Every thread owns a nw::poller and its share of non blocking connections: per connection state is a few counters
+	//! and the queue of request times, buffers are shared, so that 100k connections fit in memory. The file descriptor
+	//! limit (RLIMIT_NOFILE) must allow them, and a single target address and port are limited by the ephemeral port range.
+	//!
+	//! A request is nw::load_config::request_size bytes, its response the next nw::load_config::response_size bytes
+	//! received, contents are not checked: an echo server answers requests and responses of the same size.
+	//!
+	//! Coordinated omission: a client waiting for a slow response does not send the requests it was meant to send
+	//! meanwhile, the stall is measured once instead of once per delayed request. In nw::load_mode::OPEN the schedule
+	//! is kept whatever the responses and the latency runs from the time the request was due, in nw::load_mode::CLOSED
+	//! missed requests are backfilled once the run is over (nw::latency_histogram::merge_corrected), one per
+	//! nw::load_config::expected_interval, by default the mean time between requests of a connection pipeline slot over
+	//! the run (wrk). nw::load_report::service_time keeps the uncorrected times, from the actual sends.
+	//!
+	//! In sink mode (nw::load_config::response_size 0) a request completes once written: nothing paces the connection but
+	//! the socket buffer, there is no omission to correct and nw::load_report::latency is the uncorrected
+	//! nw::load_report::service_time in nw::load_mode::CLOSED.
+	class load_generator {
+		public:
+			typedef socket<FAMILY, sock_type::STREAM>	socket_type;
+
+			//! @throw nw::logic_error if config is invalid
+			load_generator(
+				const addr<FAMILY> &target,		//!< server address
+				const load_config &config		//!< nw::load_config
+			) : _target(target), _config(config) {
+				config.validate();
+			}
+
+			virtual	~load_generator(void) {}
+
+			//! @brief Connect, run for warmup and duration, then close every connection
+			//! @return nw::load_report of every thread
+			//! @throw nw::system_error if a thread can not be started or poller function fail's
+			load_report	run(void) {
+				const size_type						threads = std::min(std::max<size_type>(this->_config.threads, 1), this->_config.connections);
+				std::vector<load_report>			reports(threads);
+				std::vector<std::exception_ptr>		errors(threads);
+				std::vector<std::thread>			workers;
+				std::atomic<size_type>				ready(0);
+				load_report							total;
+
+				for (size_type t = 0; t != threads; ++t) {
+					const size_type	count = this->_config.connections / threads + (t < this->_config.connections % threads);
+
+					workers.push_back(std::thread([this, t, count, threads, &reports, &errors, &ready](){
+						bool	started = false;
+
+						try {
+							this->_run(count, threads, ready, started, reports[t]);
+						} catch (...) {
+							errors[t] = std::current_exception();
+							if (!started)
+								ready.fetch_add(1);
+						}
+					}));
+				}
+				for (std::thread &w : workers)
+					w.join();
+				for (size_type t = 0; t != threads; ++t) {
+					if (errors[t])
+						std::rethrow_exception(errors[t]);
+					total.merge(reports[t]);
+				}
+				if (this->_config.mode == load_mode::CLOSED)
+					total.latency.merge_corrected(total.service_time, this->_expected_interval(total));
+				return total;
+			}
+
+			const load_config &	get_config(void) const {
+				return this->_config;
+			}
+
+		protected:
+			struct	request {
+				time_point	intended;	//!< time the request was due
+				time_point	sent;		//!< time its first byte was sent
+			};
+
+			struct	connection {
+				socket_type				sock;
+				std::deque<request>		requests;		//!< in flight first, then queued
+				size_type				started;		//!< requests of which sending began
+				size_type				out_pending;	//!< bytes left to send of the last started request
+				size_type				in_bytes;		//!< bytes received toward the first response
+				size_type				index;			//!< position in the live connections
+				bool					connected;
+				bool					dropped;
+				bool					want_out;		//!< registered for nw::poller::OUT
+
+				connection(void) : sock(0), requests(), started(0), out_pending(0), in_bytes(0), index(0), connected(false), dropped(false), want_out(false) {}
+			};
+
+			//! @brief Thread state of a run
+			struct	context {
+				poller						events;
+				std::vector<connection *>	by_fd;
+				std::vector<connection *>	live;			//!< established connections, in any order
+				ibuffer<SIZE>				in;
+				obuffer<SIZE>				out;
+				uint8_t						payload[SIZE];
+				time_point					record_from;
+				time_point					end;
+				load_report					&report;
+
+				explicit context(load_report &r) : events(256), by_fd(), live(), in(), out(), payload(), record_from(), end(), report(r) {}
+			};
+
+			const addr<FAMILY>	_target;
+			const load_config	_config;
+
+			//! @brief Run a thread share of the connections, started is set once counted in ready
+			void	_run(const size_type &count, const size_type &threads, std::atomic<size_type> &ready, bool &started, load_report &report) {
+				std::unique_ptr<context>					ctx(new context(report));
+				std::vector<std::unique_ptr<connection> >	conns;
+
+				std::fill(ctx->payload, ctx->payload + SIZE, 'x');
+				this->_connect(*ctx, conns, count);
+				ready.fetch_add(1);
+				started = true;
+				while (ready.load() < threads)
+					std::this_thread::yield();
+
+				const time_point	start = clock_type::now();
+
+				ctx->record_from = start + this->_config.warmup;
+				ctx->end = ctx->record_from + this->_config.duration;
+				if (this->_config.mode == load_mode::CLOSED)
+					this->_closed(*ctx, start);
+				else
+					this->_open(*ctx, start, static_cast<double>(this->_config.rate) * static_cast<double>(count) / static_cast<double>(this->_config.connections));
+				report.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - ctx->record_from);
+				for (connection *c : ctx->live)
+					report.outstanding += c->requests.size();
+			}
+
+			//! @brief Start count connections non blocking and wait for them until nw::load_config::connect_timeout
+			void	_connect(context &ctx, std::vector<std::unique_ptr<connection> > &conns, const size_type &count) {
+				const time_point	deadline = clock_type::now() + this->_config.connect_timeout;
+				size_type			pending = 0;
+
+				for (size_type i = 0; i != count; ++i) {
+					std::unique_ptr<connection>	c(new connection());
+
+					c->sock.set_nonblocking(true);
+
+					const int32_t	error = c->sock.connect(this->_target, std::nothrow);
+
+					if (error && error != EINPROGRESS) {
+						++ctx.report.connect_errors;
+						continue ;
+					}
+					c->connected = !error;
+					pending += !c->connected;
+					ctx.events.add(c->sock.get_fd(), (c->connected) ? poller::IN : poller::OUT);
+					if (ctx.by_fd.size() <= static_cast<size_type>(c->sock.get_fd()))
+						ctx.by_fd.resize(c->sock.get_fd() + 1, nullptr);
+					ctx.by_fd[c->sock.get_fd()] = c.get();
+					conns.push_back(std::move(c));
+				}
+				while (pending && clock_type::now() < deadline) {
+					ctx.events.wait(deadline);
+					for (poller::const_iterator ev = ctx.events.begin(); ev != ctx.events.end(); ++ev) {
+						connection	*c = ctx.by_fd[ev->data.fd];
+
+						if (!c || c->connected)
+							continue ;
+						--pending;
+						if (c->sock.get_error()) {
+							++ctx.report.connect_errors;
+							this->_drop(ctx, c);
+							continue ;
+						}
+						c->connected = true;
+						ctx.events.modify(c->sock.get_fd(), poller::IN);
+					}
+				}
+				for (std::unique_ptr<connection> &c : conns) {
+					if (c->dropped)
+						continue ;
+					if (!c->connected) {
+						++ctx.report.connect_errors;
+						this->_drop(ctx, c.get());
+						continue ;
+					}
+					if (FAMILY != sa_family::LOCAL)
+						c->sock.set_nodelay(true);
+					c->index = ctx.live.size();
+					ctx.live.push_back(c.get());
+				}
+				ctx.report.connections = ctx.live.size();
+			}
+
+			void	_closed(context &ctx, const time_point &start) {
+				const std::vector<connection *>	initial(ctx.live);
+
+				for (connection *c : initial) {
+					for (size_type i = 0; i != this->_config.pipeline; ++i)
+						c->requests.push_back({start, start});
+					this->_write(ctx, c);
+				}
+				while (!ctx.live.empty() && clock_type::now() < ctx.end) {
+					ctx.events.wait(ctx.end);
+					this->_dispatch(ctx);
+				}
+			}
+
+			//! @brief Queue requests on schedule, the i-th due at start + i / rate, whatever the responses
+			//! @details The last millisecond before a request is due is busy polled, nw::poller timeouts are rounded up to it.
+			void	_open(context &ctx, const time_point &start, const double &rate) {
+				uint64_t	sent = 0;
+				time_point	next = start;
+
+				while (!ctx.live.empty()) {
+					const time_point	now = clock_type::now();
+
+					if (now >= ctx.end)
+						break ;
+					while (next <= now && !ctx.live.empty()) {
+						connection	*c = ctx.live[sent % ctx.live.size()];
+
+						c->requests.push_back({next, time_point()});
+						this->_write(ctx, c);
+						++sent;
+						next = start + std::chrono::nanoseconds(static_cast<uint64_t>(static_cast<double>(sent) * 1e9 / rate));
+					}
+					ctx.events.wait(std::min(next - msec_type(1), ctx.end));
+					this->_dispatch(ctx);
+				}
+			}
+
+			//! @return nw::load_config::expected_interval, or the mean time between requests of a connection pipeline slot
+			//! over the run
+			latency_histogram::value_type	_expected_interval(const load_report &total) const {
+				if (!this->_config.response_size)
+					return 0;
+				if (this->_config.expected_interval || !total.responses)
+					return this->_config.expected_interval;
+				return static_cast<latency_histogram::value_type>(total.elapsed.count()) * total.connections * this->_config.pipeline / total.responses;
+			}
+
+			void	_dispatch(context &ctx) {
+				for (poller::const_iterator ev = ctx.events.begin(); ev != ctx.events.end(); ++ev) {
+					connection	*c = ctx.by_fd[ev->data.fd];
+
+					if (!c || !c->connected)
+						continue ;
+					if (ev->events & (poller::IN | poller::ERR | poller::HUP))
+						this->_read(ctx, c);
+					if (c->connected && (ev->events & poller::OUT))
+						this->_write(ctx, c);
+				}
+			}
+
+			//! @brief Send started then queued requests until the socket would block
+			//! @details The clock is read as each request starts, and as it completes in sink mode.
+			void	_write(context &ctx, connection *c) {
+				bool	recording = c->started && c->requests[c->started - 1].sent >= ctx.record_from;
+
+				while (c->connected) {
+					if (!c->out_pending) {
+						if (c->started == c->requests.size())
+							break ;
+
+						const time_point	now = clock_type::now();
+
+						c->requests[c->started++].sent = now;
+						c->out_pending = this->_config.request_size;
+						recording = now >= ctx.record_from;
+						ctx.report.requests += recording;
+					}
+
+					const size_type	chunk = std::min(c->out_pending, SIZE);
+
+					ctx.out.clear();
+					ctx.out.putn(ctx.payload, chunk);
+
+					const size_type	ret = c->sock.send(ctx.out, MSG_NOSIGNAL, std::nothrow);
+
+					if (ret == npos) {
+						if (errno == EAGAIN || errno == EWOULDBLOCK)
+							return this->_want_out(ctx, c, true);
+						return this->_fail(ctx, c);
+					}
+					c->out_pending -= ret;
+					if (recording)
+						ctx.report.bytes_out += ret;
+					if (!c->out_pending && !this->_config.response_size)
+						this->_complete(ctx, c, clock_type::now());
+					if (ret < chunk)
+						return this->_want_out(ctx, c, true);
+				}
+				if (c->connected)
+					this->_want_out(ctx, c, false);
+			}
+
+			//! @brief Count received bytes as responses of the started requests, in order
+			//! @details The clock is read as each receive returns: the responses it completes arrived together.
+			void	_read(context &ctx, connection *c) {
+				while (c->connected) {
+					ctx.in.clear();
+
+					const size_type		ret = c->sock.recv(ctx.in, 0, std::nothrow);
+
+					if (ret == npos && (errno == EAGAIN || errno == EWOULDBLOCK))
+						break ;
+					if (ret == npos || !ret)
+						return this->_fail(ctx, c);
+
+					const time_point	now = clock_type::now();
+
+					if (now >= ctx.record_from)
+						ctx.report.bytes_in += ret;
+					c->in_bytes += ret;
+					while (this->_config.response_size && c->started && c->in_bytes >= this->_config.response_size) {
+						c->in_bytes -= this->_config.response_size;
+						this->_complete(ctx, c, now);
+					}
+					if (ret < SIZE)
+						break ;
+				}
+				if (c->connected)
+					this->_write(ctx, c);
+			}
+
+			void	_complete(context &ctx, connection *c, const time_point &now) {
+				const request	r = c->requests.front();
+
+				c->requests.pop_front();
+				--c->started;
+				if (now >= ctx.record_from) {
+					const latency_histogram::value_type	service = static_cast<latency_histogram::value_type>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - r.sent).count());
+
+					++ctx.report.responses;
+					ctx.report.service_time.record(service);
+					if (this->_config.mode == load_mode::OPEN)
+						ctx.report.latency.record(now - r.intended);
+				}
+				if (this->_config.mode == load_mode::CLOSED && now < ctx.end)
+					c->requests.push_back({now, now});
+			}
+
+			void	_want_out(context &ctx, connection *c, const bool &want) {
+				if (c->want_out == want)
+					return ;
+				ctx.events.modify(c->sock.get_fd(), (want) ? poller::IN | poller::OUT : poller::IN);
+				c->want_out = want;
+			}
+
+			//! @brief Drop a connection reset or closed by the peer, its requests are left outstanding
+			void	_fail(context &ctx, connection *c) {
+				++ctx.report.errors;
+				ctx.report.outstanding += c->requests.size();
+				this->_drop(ctx, c);
+			}
+
+			void	_drop(context &ctx, connection *c) {
+				const sockfd_type	fd = c->sock.get_fd();
+
+				ctx.events.remove(fd, std::nothrow);
+				ctx.by_fd[fd] = nullptr;
+				c->sock.close(std::nothrow);
+				if (c->connected && c->index < ctx.live.size() && ctx.live[c->index] == c) {
+					ctx.live[c->index] = ctx.live.back();
+					ctx.live[c->index]->index = c->index;
+					ctx.live.pop_back();
+				}
+				c->connected = false;
+				c->dropped = true;
+			}
+
+		private:
+			load_generator(const load_generator &src) = delete;
+			load_generator &	operator=(const load_generator &src) = delete;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::load_report &C);
+
+#endif
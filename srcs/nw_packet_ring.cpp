@@ -0,0 +1,180 @@
+
+/*!
+@file nw_packet_ring.cpp
+@brief ...
+*/
+
+#include <functional>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include "nw_packet_ring.hpp"
+#include "nw_format.hpp"
+#include "nw_transport.hpp"
+
+static const std::function<int(int, int, int)> &								_s_socket = nw::transport::current.socket;
+static const std::function<int(int, int, int, const void *, socklen_t)> &		_s_setsockopt = nw::transport::current.setsockopt;
+static const std::function<int(int, int, int, void *, socklen_t *)> &			_s_getsockopt = nw::transport::current.getsockopt;
+static const std::function<int(int, const struct sockaddr *, socklen_t)> &	_s_bind = nw::transport::current.bind;
+static const std::function<void *(void *, size_t, int, int, int, off_t)>		_s_mmap = &mmap;
+static const std::function<int(void *, size_t)>								_s_munmap = &munmap;
+static const std::function<int(struct pollfd *, nfds_t, int)> &				_s_poll = nw::transport::current.poll;
+static const std::function<ssize_t(int, void *, size_t, int)> &				_s_send = nw::transport::current.send;
+static const std::function<int(int)> &										_s_close = nw::transport::current.close;
+
+nw::packet_ring::packet_ring(const std::string &ifname, const packet_ring_config &config, const uint16_t &protocol) \
+	: _fd(_s_socket(AF_PACKET, SOCK_RAW, htons(protocol))), _config(config), _map(nullptr), _map_size(0), _tx(nullptr), \
+	_rx_next(0), _tx_next(0), _tx_frames(0), _stats() {
+	if (this->_fd == -1)
+		throw system_error(errno, std::generic_category(), "socket");
+	try {
+		const int32_t		version = TPACKET_V3;
+		struct sockaddr_ll	sll = {};
+
+		if (_s_setsockopt(this->_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) == -1)
+			throw system_error(errno, std::generic_category(), "setsockopt");
+		this->_ring(PACKET_RX_RING, config.block_count, true);
+		if (config.tx_block_count)
+			this->_ring(PACKET_TX_RING, config.tx_block_count, false);
+		this->_map_size = static_cast<size_type>(config.block_size) * (config.block_count + config.tx_block_count);
+
+		void	*map = _s_mmap(nullptr, this->_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, this->_fd, 0);
+
+		if (map == MAP_FAILED)
+			throw system_error(errno, std::generic_category(), "mmap");
+		this->_map = static_cast<uint8_t *>(map);
+		if (config.tx_block_count) {
+			this->_tx = this->_map + static_cast<size_type>(config.block_size) * config.block_count;
+			this->_tx_frames = config.tx_block_count * (config.block_size / config.frame_size);
+		}
+		sll.sll_family = AF_PACKET;
+		sll.sll_protocol = htons(protocol);
+		if (!ifname.empty() && !(sll.sll_ifindex = static_cast<int32_t>(if_nametoindex(ifname.c_str()))))
+			throw logic_error("if_nametoindex: unknown interface");
+		if (_s_bind(this->_fd, reinterpret_cast<const struct sockaddr *>(&sll), sizeof(sll)) == -1)
+			throw system_error(errno, std::generic_category(), "bind");
+	} catch (...) {
+		if (this->_map)
+			_s_munmap(this->_map, this->_map_size);
+		_s_close(this->_fd);
+		throw ;
+	}
+}
+
+nw::packet_ring::~packet_ring(void) {
+	_s_munmap(this->_map, this->_map_size);
+	_s_close(this->_fd);
+}
+
+void						nw::packet_ring::_ring(const int32_t &option, const uint32_t &block_count, const bool &rx) {
+	struct tpacket_req3	req = {};
+
+	req.tp_block_size = this->_config.block_size;
+	req.tp_block_nr = block_count;
+	req.tp_frame_size = this->_config.frame_size;
+	req.tp_frame_nr = (this->_config.frame_size) ? block_count * (this->_config.block_size / this->_config.frame_size) : 0;
+	if (rx)
+		req.tp_retire_blk_tov = static_cast<uint32_t>(this->_config.retire_timeout.count());
+	if (_s_setsockopt(this->_fd, SOL_PACKET, option, &req, sizeof(req)) == -1)
+		throw system_error(errno, std::generic_category(), "setsockopt");
+}
+
+void						nw::packet_ring::_poll(const msec_type &timeout) {
+	struct pollfd	pfd = {this->_fd, POLLIN | POLLERR, 0};
+
+	if (_s_poll(&pfd, 1, static_cast<int32_t>(timeout.count())) == -1 && errno != EINTR)
+		throw system_error(errno, std::generic_category(), "poll");
+}
+
+bool						nw::packet_ring::send(const void *data, const size_type &len) {
+	if (!this->_tx)
+		throw logic_error("packet_ring: no transmit ring");
+	if (len > this->get_tx_capacity())
+		throw logic_error("packet_ring: frame too large");
+
+	struct tpacket3_hdr	*hdr = reinterpret_cast<struct tpacket3_hdr *>(this->_tx + static_cast<size_type>(this->_tx_next) * this->_config.frame_size);
+
+	if (__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) != TP_STATUS_AVAILABLE)
+		return false;
+	std::memcpy(reinterpret_cast<uint8_t *>(hdr) + TPACKET3_HDRLEN - sizeof(struct sockaddr_ll), data, len);
+	hdr->tp_len = static_cast<uint32_t>(len);
+	hdr->tp_snaplen = static_cast<uint32_t>(len);
+	hdr->tp_next_offset = 0;
+	__atomic_store_n(&hdr->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+	this->_tx_next = (this->_tx_next + 1) % this->_tx_frames;
+	++this->_stats.sent;
+	return true;
+}
+
+nw::size_type				nw::packet_ring::flush(void) {
+	ssize_t	ret = _s_send(this->_fd, nullptr, 0, MSG_DONTWAIT);
+
+	if (ret == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return 0;
+		throw system_error(errno, std::generic_category(), "send");
+	}
+	return static_cast<size_type>(ret);
+}
+
+const nw::packet_ring_stats &	nw::packet_ring::get_stats(void) {
+	struct tpacket_stats_v3	st = {};
+	socklen_type			len = sizeof(st);
+
+	if (_s_getsockopt(this->_fd, SOL_PACKET, PACKET_STATISTICS, &st, &len) == -1)
+		throw system_error(errno, std::generic_category(), "getsockopt");
+	this->_stats.packets += st.tp_packets;
+	this->_stats.drops += st.tp_drops;
+	this->_stats.freezes += st.tp_freeze_q_cnt;
+	return this->_stats;
+}
+
+const nw::sockfd_type &		nw::packet_ring::get_fd(void) const {
+	return this->_fd;
+}
+
+nw::size_type				nw::packet_ring::get_tx_capacity(void) const {
+	return (this->_tx) ? this->_config.frame_size - (TPACKET3_HDRLEN - sizeof(struct sockaddr_ll)) : 0;
+}
+
+const std::string			nw::packet_ring_stats::to_string(void) const {
+	return format_string([this](formatter &f){
+		f.begin_object();
+		f.key("packets").value(this->packets);
+		f.key("drops").value(this->drops);
+		f.key("freezes").value(this->freezes);
+		f.key("blocks").value(this->blocks);
+		f.key("sent").value(this->sent);
+		f.end_object();
+	});
+}
+
+const std::string			nw::packet_ring::to_string(void) const {
+	return format_string([this](formatter &f){
+		f.begin_object();
+		f.key("fd").value(this->_fd);
+		f.key("block_size").value(this->_config.block_size);
+		f.key("block_count").value(this->_config.block_count);
+		f.key("frame_size").value(this->_config.frame_size);
+		f.key("tx_block_count").value(this->_config.tx_block_count);
+		f.key("rx_next").value(this->_rx_next);
+		f.key("tx_next").value(this->_tx_next);
+		f.end_object();
+	});
+}
+
+std::ostream &				operator<<(std::ostream &o, const nw::packet_ring_stats &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &				operator<<(std::ostream &o, const nw::packet_ring &C) {
+	o << C.to_string();
+	return (o);
+}
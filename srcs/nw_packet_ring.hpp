@@ -0,0 +1,184 @@
+#ifndef __NW_PACKET_RING_HPP__
+# define __NW_PACKET_RING_HPP__
+
+/*!
+@file nw_packet_ring.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <atomic>
+# include <ctime>
+
+# include <linux/if_packet.h>
+# include <linux/if_ether.h>
+
+# include "nw_typedef.hpp"
+
+namespace nw {
+	//! @brief nw::packet_ring geometry
+	//! @details
+	//! block_size must be a multiple of the page size and of frame_size, frame_size a multiple of 16 (TPACKET_ALIGNMENT).
+	//! On receive, frames are packed in blocks regardless of frame_size, a block is handed to user space when it is full
+	//! or after retire_timeout. On transmit, every block is cut in fixed frame_size frames.
+	struct	packet_ring_config {
+		uint32_t	block_size;		//!< ring block size in bytes
+		uint32_t	block_count;	//!< receive ring blocks
+		uint32_t	frame_size;		//!< maximum frame size in bytes, headers included
+		msec_type	retire_timeout;	//!< delay after which a partially filled receive block is handed to user space
+		uint32_t	tx_block_count;	//!< transmit ring blocks, 0 for no transmit ring
+
+		packet_ring_config(void) \
+			: block_size(1 << 20), block_count(16), frame_size(2048), retire_timeout(10), tx_block_count(0) {}
+	};
+
+	//! @brief Frame read in place from a nw::packet_ring receive block
+	struct	packet_frame {
+		const uint8_t	*data;		//!< link layer header and payload, valid until the callback returns
+		uint32_t		len;		//!< length on the wire
+		uint32_t		snaplen;	//!< captured length, at most len
+		struct timespec	ts;			//!< kernel receive timestamp
+		uint32_t		status;		//!< TP_STATUS_* flags
+		uint16_t		vlan_tci;	//!< VLAN tag, valid if status has TP_STATUS_VLAN_VALID
+	};
+
+	//! @brief Kernel counters of a nw::packet_ring, accumulated since construction
+	struct	packet_ring_stats {
+		uint64_t	packets;	//!< frames received
+		uint64_t	drops;		//!< frames dropped for lack of ring space
+		uint64_t	freezes;	//!< times the receive ring was found full
+		uint64_t	blocks;		//!< receive blocks read
+		uint64_t	sent;		//!< frames queued on the transmit ring
+
+		const std::string	to_string(void) const;
+	};
+
+	//! @brief AF_PACKET raw socket with memory mapped TPACKET_V3 rings (PACKET_MMAP)
+	//! @details
+	//! Frames are read in place from receive blocks shared with the kernel: a whole block is processed per readiness
+	//! notification, without a system call nor a copy per frame. Frames to transmit are written in place in the
+	//! transmit ring and handed to the kernel in batches by nw::packet_ring::flush.
+	//!
+	//! Requires CAP_NET_RAW.
+	class packet_ring {
+		public:
+			//! @brief Open, map and bind the rings
+			//! @throw nw::system_error if socket(2), setsockopt(2), mmap(2) or bind(2) function fail's
+			//! @throw nw::logic_error if ifname is not an interface name
+			packet_ring(
+				const std::string &ifname = "",							//!< interface name, empty for every interface
+				const packet_ring_config &config = packet_ring_config(),	//!< ring geometry
+				const uint16_t &protocol = ETH_P_ALL					//!< ethertype captured
+			);
+
+			//! @brief Destructor, unmap the rings and close the socket
+			virtual	~packet_ring(void);
+
+			//! @tparam F void(const nw::packet_frame &) callable
+			template <typename F>
+			//! @brief Call fct on every frame of the receive blocks ready, without waiting
+			//! @return number of frames read
+			size_type	read(const F &fct) {
+				size_type	frames = 0;
+
+				for (struct tpacket_block_desc *block = this->_ready(); block; block = this->_ready()) {
+					const struct tpacket_hdr_v1	&bh = block->hdr.bh1;
+					const uint8_t				*p = reinterpret_cast<const uint8_t *>(block) + bh.offset_to_first_pkt;
+
+					for (uint32_t i = 0; i != bh.num_pkts; ++i) {
+						const struct tpacket3_hdr	*hdr = reinterpret_cast<const struct tpacket3_hdr *>(p);
+						packet_frame				frame;
+
+						frame.data = p + hdr->tp_mac;
+						frame.len = hdr->tp_len;
+						frame.snaplen = hdr->tp_snaplen;
+						frame.ts.tv_sec = hdr->tp_sec;
+						frame.ts.tv_nsec = hdr->tp_nsec;
+						frame.status = hdr->tp_status;
+						frame.vlan_tci = static_cast<uint16_t>(hdr->hv1.tp_vlan_tci);
+						fct(frame);
+						p += hdr->tp_next_offset;
+					}
+					frames += bh.num_pkts;
+					this->_release(block);
+				}
+				return frames;
+			}
+
+			//! @tparam F void(const nw::packet_frame &) callable
+			template <typename F>
+			//! @brief Wait until a receive block is ready or timeout, then read every ready block
+			//! @return number of frames read
+			//! @throw nw::system_error if poll(2) function fail's (EINTR excepted)
+			size_type	wait(const F &fct, const msec_type &timeout = msec_type(-1)) {
+				if (!this->_ready())
+					this->_poll(timeout);
+				return this->read(fct);
+			}
+
+			//! @brief Copy a frame in the next free transmit slot
+			//! @return false if the transmit ring is full
+			//! @throw nw::logic_error if there is no transmit ring or len does not fit in a frame
+			bool		send(const void *data, const size_type &len);
+
+			//! @brief Hand frames queued by nw::packet_ring::send to the kernel
+			//! @return number of bytes sent
+			//! @throw nw::system_error if send(2) function fail's (EAGAIN excepted)
+			size_type	flush(void);
+
+			//! @brief Read and accumulate kernel counters (PACKET_STATISTICS)
+			//! @throw nw::system_error if getsockopt(2) function fail's
+			const packet_ring_stats &	get_stats(void);
+
+			//! @brief Return the socket file descriptor, readable when a receive block is ready
+			const sockfd_type &	get_fd(void) const;
+
+			//! @brief Largest frame accepted by nw::packet_ring::send
+			size_type	get_tx_capacity(void) const;
+
+			const std::string	to_string(void) const;
+
+		protected:
+			const sockfd_type			_fd;
+			const packet_ring_config	_config;
+			uint8_t						*_map;
+			size_type					_map_size;
+			uint8_t						*_tx;
+			uint32_t					_rx_next;		//!< next receive block
+			uint32_t					_tx_next;		//!< next transmit frame
+			uint32_t					_tx_frames;
+			packet_ring_stats			_stats;
+
+			//! @return next receive block if handed to user space, nullptr otherwise
+			inline struct tpacket_block_desc *	_ready(void) {
+				struct tpacket_block_desc	*block = reinterpret_cast<struct tpacket_block_desc *>(this->_map + static_cast<size_type>(this->_rx_next) * this->_config.block_size);
+
+				if (!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+					return nullptr;
+				return block;
+			}
+
+			//! @brief Give block back to the kernel and move to the next one
+			inline void	_release(struct tpacket_block_desc *block) {
+				__atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+				this->_rx_next = (this->_rx_next + 1) % this->_config.block_count;
+				++this->_stats.blocks;
+			}
+
+			void	_poll(const msec_type &timeout);
+			void	_ring(const int32_t &option, const uint32_t &block_count, const bool &rx);
+
+		private:
+			packet_ring(const packet_ring &src) = delete;
+			packet_ring(packet_ring &&src) = delete;
+
+			packet_ring &	operator=(const packet_ring &src) = delete;
+			packet_ring &	operator=(packet_ring &&src) = delete;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::packet_ring_stats &C);
+std::ostream &	operator<<(std::ostream &o, const nw::packet_ring &C);
+
+#endif
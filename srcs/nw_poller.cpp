@@ -0,0 +1,173 @@
+
+/*!
+@file nw_poller.cpp
+@brief ...
+*/
+
+#include <functional>
+#include <algorithm>
+#include <limits>
+
+#include <unistd.h>
+#include <poll.h>
+
+#include "nw_poller.hpp"
+#include "nw_transport.hpp"
+
+static const std::function<int(int)>										_s_epoll_create1 = &epoll_create1;
+static const std::function<int(int, int, int, struct epoll_event *)>		_s_epoll_ctl = &epoll_ctl;
+static const std::function<int(int, struct epoll_event *, int, int)>		_s_epoll_wait = &epoll_wait;
+static const std::function<int(struct pollfd *, nfds_t, int)> &			_s_poll = nw::transport::current.poll;
+static const std::function<int(int, int, int, void *, socklen_t *)> &	_s_getsockopt = nw::transport::current.getsockopt;
+
+//! @return milliseconds left until deadline rounded up, -1 for time_point::max()
+static int32_t				_timeout(const nw::time_point &deadline) {
+	if (deadline == nw::time_point::max())
+		return -1;
+
+	const nw::time_point	now = nw::clock_type::now();
+
+	if (deadline <= now)
+		return 0;
+	return static_cast<int32_t>(std::min<nw::msec_type::rep>(
+		std::chrono::duration_cast<nw::msec_type>(deadline - now + nw::msec_type(1) - std::chrono::nanoseconds(1)).count(),
+		std::numeric_limits<int32_t>::max()
+	));
+}
+
+const uint32_t				nw::poller::IN;
+const uint32_t				nw::poller::OUT;
+const uint32_t				nw::poller::ERR;
+const uint32_t				nw::poller::HUP;
+const uint32_t				nw::poller::RDHUP;
+const uint32_t				nw::poller::ET;
+const uint32_t				nw::poller::ONESHOT;
+
+nw::poller::poller(const size_type &max_events) : _fd(_s_epoll_create1(EPOLL_CLOEXEC)), _count(0), _ready(0), _events(std::max<size_type>(max_events, 1)) {
+	if (this->_fd == -1)
+		throw system_error(errno, std::generic_category(), "epoll_create1");
+}
+
+nw::poller::~poller(void) {
+	close(this->_fd);
+}
+
+void						nw::poller::_ctl(const int32_t &op, const sockfd_type &fd, const uint32_t &events, const char *what) {
+	type	ev = {};
+
+	ev.events = events;
+	ev.data.fd = fd;
+	if (_s_epoll_ctl(this->_fd, op, fd, &ev) == -1)
+		throw system_error(errno, std::generic_category(), what);
+}
+
+void						nw::poller::add(const sockfd_type &fd, const uint32_t &events) {
+	this->_ctl(EPOLL_CTL_ADD, fd, events, "epoll_ctl: add");
+	++this->_count;
+}
+
+void						nw::poller::modify(const sockfd_type &fd, const uint32_t &events) {
+	this->_ctl(EPOLL_CTL_MOD, fd, events, "epoll_ctl: mod");
+}
+
+void						nw::poller::remove(const sockfd_type &fd) {
+	this->_ctl(EPOLL_CTL_DEL, fd, 0, "epoll_ctl: del");
+	--this->_count;
+}
+
+void						nw::poller::remove(const sockfd_type &fd, std::nothrow_t) {
+	type	ev = {};
+
+	if (_s_epoll_ctl(this->_fd, EPOLL_CTL_DEL, fd, &ev) != -1)
+		--this->_count;
+}
+
+nw::size_type				nw::poller::wait(const msec_type &timeout) {
+	int32_t	ret = _s_epoll_wait(this->_fd, this->_events.data(), static_cast<int32_t>(this->_events.size()), static_cast<int32_t>(timeout.count()));
+
+	if (ret == -1) {
+		this->_ready = 0;
+		if (errno == EINTR)
+			return 0;
+		throw system_error(errno, std::generic_category(), "epoll_wait");
+	}
+	this->_ready = static_cast<size_type>(ret);
+	return this->_ready;
+}
+
+nw::size_type				nw::poller::wait(const time_point &deadline) {
+	return this->wait(msec_type(_timeout(deadline)));
+}
+
+nw::size_type				nw::poller::wait(timer_wheel &timers, const timer_wheel::expire_fct_t &fct) {
+	size_type	ret = this->wait(timers.next_expiry());
+
+	timers.expire(clock_type::now(), fct);
+	return ret;
+}
+
+nw::poller::const_iterator	nw::poller::begin(void) const {
+	return this->_events.begin();
+}
+
+nw::poller::const_iterator	nw::poller::end(void) const {
+	return this->_events.begin() + this->_ready;
+}
+
+nw::size_type				nw::poller::size(void) const {
+	return this->_count;
+}
+
+const nw::sockfd_type &		nw::poller::get_fd(void) const {
+	return this->_fd;
+}
+
+const std::string			nw::poller::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 64 * (this->_ready + 1));
+}
+
+void						nw::poller::format(formatter &f) const {
+	f.begin_object();
+	f.key("fd").value(this->_fd);
+	f.key("registered").value(this->_count);
+	f.key("ready").begin_array();
+	for (const_iterator it = this->begin(); it != this->end(); ++it) {
+		f.begin_object();
+		f.key("fd").value(it->data.fd);
+		f.key("events").value(it->events);
+		f.end_object();
+	}
+	f.end_array();
+	f.end_object();
+}
+
+//! @details POLLERR is an error unless requested: the pending socket error is thrown, EIO if there is none and no
+//! requested event is ready (error queue readable).
+uint32_t					nw::wait(const sockfd_type &fd, const uint32_t &events, const time_point &deadline, const char *what) {
+	struct pollfd	pfd = {fd, static_cast<int16_t>(events), 0};
+	int32_t			ret;
+
+	while ((ret = _s_poll(&pfd, 1, _timeout(deadline))) == -1 && errno == EINTR)
+		;
+	if (ret == -1)
+		throw system_error(errno, std::generic_category(), what);
+	if (!ret)
+		return 0;
+	if (pfd.revents & POLLNVAL)
+		throw system_error(EBADF, std::generic_category(), what);
+	if ((pfd.revents & POLLERR) && !(events & POLLERR)) {
+		int32_t		error = 0;
+		socklen_t	len = sizeof(error);
+
+		if (_s_getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1)
+			throw system_error(errno, std::generic_category(), "getsockopt");
+		if (error || !(pfd.revents & events))
+			throw system_error((error) ? error : EIO, std::generic_category(), what);
+	}
+	return static_cast<uint16_t>(pfd.revents);
+}
+
+std::ostream &				operator<<(std::ostream &o, const nw::poller &C) {
+	o << C.to_string();
+	return (o);
+}
@@ -0,0 +1,108 @@
+#ifndef __NW_POLLER_HPP__
+# define __NW_POLLER_HPP__
+
+/*!
+@file nw_poller.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <vector>
+
+# include <sys/epoll.h>
+
+# include "nw_typedef.hpp"
+# include "nw_timer_wheel.hpp"
+# include "nw_format.hpp"
+
+namespace nw {
+	//! @brief Socket readiness notifier (epoll(7) instance)
+	class poller {
+		public:
+			//! @brief type is struct epoll_event
+			typedef struct epoll_event					type;
+			typedef std::vector<type>::const_iterator	const_iterator;
+
+			static const uint32_t	IN		= EPOLLIN;		//!< Readable
+			static const uint32_t	OUT		= EPOLLOUT;		//!< Writable
+			static const uint32_t	ERR		= EPOLLERR;		//!< Error condition
+			static const uint32_t	HUP		= EPOLLHUP;		//!< Hang up
+			static const uint32_t	RDHUP	= EPOLLRDHUP;	//!< Peer closed its writing half
+			static const uint32_t	ET		= EPOLLET;		//!< Edge triggered notification
+			static const uint32_t	ONESHOT	= EPOLLONESHOT;	//!< Disarm after one notification
+
+			//! @brief Construct with the maximum number of events returned by one nw::poller::wait
+			//! @throw nw::system_error if epoll_create1(2) function fail's
+			poller(const size_type &max_events = 64);
+
+			//! @brief Destructor
+			virtual	~poller(void);
+
+			//! @brief Register fd for events
+			//! @throw nw::system_error if epoll_ctl(2) function fail's
+			void		add(const sockfd_type &fd, const uint32_t &events);
+
+			//! @brief Change events registered for fd
+			//! @throw nw::system_error if epoll_ctl(2) function fail's
+			void		modify(const sockfd_type &fd, const uint32_t &events);
+
+			//! @brief Unregister fd
+			//! @throw nw::system_error if epoll_ctl(2) function fail's
+			void		remove(const sockfd_type &fd);
+
+			//! @brief Unregister fd with no throw behavior
+			void		remove(const sockfd_type &fd, std::nothrow_t);
+
+			//! @brief Wait for events, -1 timeout block indefinitely
+			//! @return number of ready fds, iterable with nw::poller::begin and nw::poller::end
+			//! @throw nw::system_error if epoll_wait(2) function fail's (EINTR excepted)
+			size_type	wait(const msec_type &timeout = msec_type(-1));
+
+			//! @brief Wait for events until deadline
+			//! @return number of ready fds
+			//! @throw nw::system_error if epoll_wait(2) function fail's (EINTR excepted)
+			size_type	wait(const time_point &deadline);
+
+			//! @brief Wait for events until the nearest timer expiry, then fire expired timers
+			//! @return number of ready fds
+			//! @throw nw::system_error if epoll_wait(2) function fail's (EINTR excepted)
+			size_type	wait(timer_wheel &timers, const timer_wheel::expire_fct_t &fct);
+
+			const_iterator	begin(void) const;
+			const_iterator	end(void) const;
+
+			//! @brief Number of registered fds
+			size_type	size(void) const;
+
+			//! @brief epoll instance file descriptor
+			const sockfd_type &	get_fd(void) const;
+
+			const std::string	to_string(void) const;
+			void				format(formatter &f) const;
+
+		protected:
+			const sockfd_type	_fd;
+			size_type			_count;
+			size_type			_ready;
+			std::vector<type>	_events;
+
+			void	_ctl(const int32_t &op, const sockfd_type &fd, const uint32_t &events, const char *what);
+
+		private:
+			poller(const poller &src) = delete;
+			poller(poller &&src) = delete;
+
+			poller &	operator=(const poller &src) = delete;
+			poller &	operator=(poller &&src) = delete;
+	};
+
+	//! @brief Wait for nw::poller events on a single fd until deadline
+	//! @return ready events, 0 if deadline expired
+	//! @throw nw::system_error with what if poll(2) function fail's, fd is invalid or the socket is in error
+	uint32_t	wait(const sockfd_type &fd, const uint32_t &events, const time_point &deadline, const char *what = "poll");
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::poller &C);
+
+#endif
@@ -68,22 +68,18 @@ nw::protoent::~protoent(void) {
 }
 
 const std::string			nw::protoent::to_string(void) const {
-	std::string	str;
-
-	str = "{ \"name\": \"" + std::string(this->_struct->p_name) + "\", ";
-	str += "\"number\": " + std::to_string(this->_struct->p_proto) + ", ";
-	str += "\"aliases\": [ ";
-
-	char *alias = *this->_struct->p_aliases;
-	for (size_type i = 0; alias; alias = this->_struct->p_aliases[++i]) {
-		str += "\"" + std::string(alias) + "\"";
-		if (this->_struct->p_aliases[i + 1])
-			str += ", ";
-	}
-
-	str += " ] }";
+	return format_string([this](formatter &f){ this->format(f); });
+}
 
-	return str;
+void						nw::protoent::format(formatter &f) const {
+	f.begin_object();
+	f.key("name").value(this->_struct->p_name);
+	f.key("number").value(this->_struct->p_proto);
+	f.key("aliases").begin_array();
+	for (char **alias = this->_struct->p_aliases; *alias; ++alias)
+		f.value(*alias);
+	f.end_array();
+	f.end_object();
 }
 
 std::ostream &				operator<<(std::ostream &o, const nw::protoent &C) {
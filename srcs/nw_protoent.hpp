@@ -14,6 +14,7 @@
 # include <netdb.h>
 
 # include "nw_typedef.hpp"
+# include "nw_format.hpp"
 
 typedef struct protoent		protoent_struct;
 
@@ -33,6 +34,7 @@ namespace nw {
 			virtual	~protoent(void);
 
 			const std::string	to_string(void) const;
+			void				format(formatter &f) const;
 
 		protected:
 			std::shared_ptr<const type>	_struct;
@@ -0,0 +1,209 @@
+#ifndef __NW_RECORD_BATCH_HPP__
+# define __NW_RECORD_BATCH_HPP__
+
+/*!
+@file nw_record_batch.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <cstring>
+# include <algorithm>
+
+# include <sys/socket.h>
+
+# include "nw_typedef.hpp"
+# include "nw_format.hpp"
+
+namespace nw {
+	//! @brief Record of a nw::record_batch, valid until the batch is modified
+	struct	record {
+		const uint8_t	*data;		//!< record bytes
+		size_type		len;		//!< record length, at most the slot size
+		bool			truncated;	//!< the received record did not fit in its slot and was cut (MSG_TRUNC)
+	};
+
+	//! @tparam COUNT maximum number of records per call
+	//! @tparam SIZE slot size, largest record
+	template <size_type COUNT, size_type SIZE>
+	//! @brief Preallocated record slots, one message per slot, exchanged with a single recvmmsg(2) or sendmmsg(2)
+	//! @details
+	//! Unlike nw::ibuffer and nw::obuffer byte rings, record boundaries of nw::sock_type::SEQPACKET and nw::sock_type::DGRAM
+	//! sockets are preserved: no framing is needed. Records are received by nw::socket::recv_records, or queued with
+	//! nw::record_batch::push and sent by nw::socket::send_records. A batch is used to receive or to send, not both.
+	//!
+	//! Addresses are not kept: use connected sockets, or nw::datagram_batch to know the sender.
+	class record_batch {
+		static_assert(COUNT && SIZE, "nw::record_batch requires slots");
+
+		public:
+			record_batch(void) : _first(0), _count(0), _truncated(0) {}
+
+			virtual	~record_batch(void) {}
+
+			//! @brief Return the number of records received or queued
+			inline size_type	size(void) const {
+				return this->_count;
+			}
+
+			inline bool			empty(void) const {
+				return !this->_count;
+			}
+
+			inline bool			full(void) const {
+				return this->_count == COUNT;
+			}
+
+			//! @brief Return the maximum number of records
+			static constexpr size_type	capacity(void) {
+				return COUNT;
+			}
+
+			//! @brief Return the slot size
+			static constexpr size_type	slot_size(void) {
+				return SIZE;
+			}
+
+			//! @brief Return the number of records truncated by the last receive
+			inline size_type	truncated(void) const {
+				return this->_truncated;
+			}
+
+			//! @brief Return record i
+			record				operator[](const size_type &i) const {
+				record	r;
+
+				r.data = this->_data[this->_first + i];
+				r.len = this->_lens[this->_first + i];
+				r.truncated = this->_msgs[this->_first + i].msg_hdr.msg_flags & MSG_TRUNC;
+				return r;
+			}
+
+			//! @tparam F void(const nw::record &) callable
+			template <typename F>
+			//! @brief Call fct on every record, in order
+			void				for_each(const F &fct) const {
+				for (size_type i = 0; i != this->_count; ++i)
+					fct((*this)[i]);
+			}
+
+			//! @brief Queue a copy of a record for nw::socket::send_records
+			//! @return false if every slot is used
+			//! @throw nw::logic_error if len is larger than the slot size
+			bool				push(
+				const void *data,		//!< record bytes
+				const size_type &len	//!< record length
+			) {
+				if (len > SIZE)
+					throw logic_error("record_batch: record larger than slot");
+				if (this->_count == COUNT)
+					return false;
+				if (this->_first + this->_count == COUNT)
+					this->_compact();
+
+				const size_type	i = this->_first + this->_count;
+
+				std::memcpy(this->_data[i], data, len);
+				this->_lens[i] = len;
+				this->_msgs[i].msg_hdr.msg_flags = 0;
+				++this->_count;
+				return true;
+			}
+
+			//! @brief Forget every record
+			void				clear(void) {
+				this->_first = 0;
+				this->_count = 0;
+				this->_truncated = 0;
+			}
+
+			const std::string	to_string(void) const {
+				return format_string([this](formatter &f){ this->format(f); }, 64);
+			}
+
+			void				format(formatter &f) const {
+				f.begin_object();
+				f.key("records").value(static_cast<uint64_t>(this->_count));
+				f.key("capacity").value(static_cast<uint64_t>(COUNT));
+				f.key("slot_size").value(static_cast<uint64_t>(SIZE));
+				f.key("truncated").value(static_cast<uint64_t>(this->_truncated));
+				f.end_object();
+			}
+
+		protected:
+			uint8_t				_data[COUNT][SIZE];
+			struct mmsghdr		_msgs[COUNT];
+			struct iovec		_iov[COUNT];
+			size_type			_lens[COUNT];
+			size_type			_first;		//!< first queued record
+			size_type			_count;
+			size_type			_truncated;
+
+			//! @brief Move queued records to the first slots
+			void				_compact(void) {
+				for (size_type i = 0; i != this->_count; ++i) {
+					std::memcpy(this->_data[i], this->_data[this->_first + i], this->_lens[this->_first + i]);
+					this->_lens[i] = this->_lens[this->_first + i];
+				}
+				this->_first = 0;
+			}
+
+			//! @brief Reset message headers of the slots before recvmmsg(2)
+			struct mmsghdr *	_prepare_recv(void) {
+				this->clear();
+				std::memset(this->_msgs, 0, sizeof(this->_msgs));
+				for (size_type i = 0; i != COUNT; ++i) {
+					this->_iov[i].iov_base = this->_data[i];
+					this->_iov[i].iov_len = SIZE;
+					this->_msgs[i].msg_hdr.msg_iov = &this->_iov[i];
+					this->_msgs[i].msg_hdr.msg_iovlen = 1;
+				}
+				return this->_msgs;
+			}
+
+			void				_complete_recv(const size_type &count) {
+				this->_count = count;
+				for (size_type i = 0; i != count; ++i) {
+					this->_lens[i] = std::min<size_type>(this->_msgs[i].msg_len, SIZE);
+					if (this->_msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+						++this->_truncated;
+				}
+			}
+
+			//! @brief Set message headers of the queued records before sendmmsg(2)
+			struct mmsghdr *	_prepare_send(void) {
+				for (size_type i = this->_first; i != this->_first + this->_count; ++i) {
+					this->_iov[i].iov_base = this->_data[i];
+					this->_iov[i].iov_len = this->_lens[i];
+					std::memset(&this->_msgs[i], 0, sizeof(this->_msgs[i]));
+					this->_msgs[i].msg_hdr.msg_iov = &this->_iov[i];
+					this->_msgs[i].msg_hdr.msg_iovlen = 1;
+				}
+				return this->_msgs + this->_first;
+			}
+
+			//! @brief Drop count sent records
+			void				_complete_send(const size_type &count) {
+				this->_first += count;
+				this->_count -= count;
+				if (!this->_count)
+					this->_first = 0;
+			}
+
+			template <sa_family, sock_type>
+			friend class socket;
+
+		private:
+			record_batch(const record_batch &src) = delete;
+			record_batch &	operator=(const record_batch &src) = delete;
+	};
+};
+
+template <nw::size_type COUNT, nw::size_type SIZE>
+std::ostream &	operator<<(std::ostream &o, const nw::record_batch<COUNT, SIZE> &C) {
+	o << C.to_string();
+	return o;
+}
+
+#endif
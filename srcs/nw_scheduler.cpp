@@ -0,0 +1,297 @@
+
+/*!
+@file nw_scheduler.cpp
+@brief ...
+*/
+
+#include <functional>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "nw_scheduler.hpp"
+#include "nw_transport.hpp"
+
+static const std::function<int(unsigned int, int)>	_s_eventfd = &eventfd;
+static const std::function<int(int, eventfd_t *)>	_s_eventfd_read = &eventfd_read;
+static const std::function<int(int, eventfd_t)>		_s_eventfd_write = &eventfd_write;
+static const std::function<int(int)> &			_s_close = nw::transport::current.close;
+
+namespace {
+	//! @brief Scheduler and worker index of the calling thread
+	thread_local const nw::scheduler	*_current = nullptr;
+	thread_local nw::size_type			_current_index = nw::npos;
+
+	inline uint64_t	_xorshift(uint64_t &seed) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		return seed;
+	}
+};
+
+nw::scheduler::worker::worker(const size_type &capacity) \
+	: deque(capacity), thread(), executed(0), local(0), injected(0), stolen(0), parks(0) {
+}
+
+nw::scheduler::scheduler(const size_type &workers, const size_type &deque_capacity) \
+	: _workers(), _mutex(), _wakeup(), _idle(), _injection(), _pending(0), _sleepers(0), _stop(false) {
+	const size_type	count = (workers) ? workers : 1;
+
+	for (size_type i = 0; i != count; ++i)
+		this->_workers.push_back(std::unique_ptr<worker>(new worker(deque_capacity)));
+	try {
+		for (size_type i = 0; i != count; ++i)
+			this->_workers[i]->thread = std::thread(&scheduler::_run, this, i);
+	} catch (...) {
+		this->_stop.store(true);
+		this->_notify();
+		for (std::unique_ptr<worker> &w : this->_workers)
+			if (w->thread.joinable())
+				w->thread.join();
+		throw ;
+	}
+}
+
+nw::scheduler::~scheduler(void) {
+	this->wait_idle();
+	{
+		std::lock_guard<std::mutex>	lock(this->_mutex);
+
+		this->_stop.store(true);
+	}
+	this->_wakeup.notify_all();
+	for (std::unique_ptr<worker> &w : this->_workers)
+		w->thread.join();
+}
+
+void					nw::scheduler::submit(task_type task) {
+	task_type	*t = new task_type(std::move(task));
+
+	this->_pending.fetch_add(1, std::memory_order_seq_cst);
+	{
+		std::lock_guard<std::mutex>	lock(this->_mutex);
+
+		this->_injection.push_back(t);
+	}
+	this->_notify();
+}
+
+void					nw::scheduler::spawn(task_type task) {
+	if (_current != this)
+		return this->submit(std::move(task));
+
+	task_type	*t = new task_type(std::move(task));
+
+	this->_pending.fetch_add(1, std::memory_order_seq_cst);
+	if (!this->_workers[_current_index]->deque.push(t)) {
+		std::lock_guard<std::mutex>	lock(this->_mutex);
+
+		this->_injection.push_back(t);
+	}
+	this->_notify();
+}
+
+void					nw::scheduler::wait_idle(void) {
+	std::unique_lock<std::mutex>	lock(this->_mutex);
+
+	while (this->_pending.load(std::memory_order_acquire))
+		this->_idle.wait(lock);
+}
+
+nw::size_type			nw::scheduler::size(void) const {
+	return this->_workers.size();
+}
+
+nw::size_type			nw::scheduler::current_worker(void) const {
+	return (_current == this) ? _current_index : npos;
+}
+
+nw::scheduler_stats		nw::scheduler::get_stats(void) const {
+	scheduler_stats	stats = {};
+
+	for (const std::unique_ptr<worker> &w : this->_workers) {
+		stats.executed += w->executed.load(std::memory_order_relaxed);
+		stats.local += w->local.load(std::memory_order_relaxed);
+		stats.injected += w->injected.load(std::memory_order_relaxed);
+		stats.stolen += w->stolen.load(std::memory_order_relaxed);
+		stats.parks += w->parks.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+//! @details
+//! A waker queues its task before loading _sleepers, a sleeper increments _sleepers before looking at the queues, both
+//! separated by a sequentially consistent fence: at least one of them sees the other. The sleeper holds the mutex from
+//! its check to its wait, the waker takes it before notifying, the wakeup can not be lost.
+void					nw::scheduler::_notify(void) {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!this->_sleepers.load(std::memory_order_seq_cst))
+		return ;
+	std::lock_guard<std::mutex>	lock(this->_mutex);
+
+	this->_wakeup.notify_one();
+}
+
+void					nw::scheduler::_done(void) {
+	if (this->_pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return ;
+	std::lock_guard<std::mutex>	lock(this->_mutex);
+
+	this->_idle.notify_all();
+}
+
+nw::scheduler::task_type	*nw::scheduler::_next(const size_type &index, uint64_t &seed) {
+	worker		&self = *this->_workers[index];
+	task_type	*task = nullptr;
+
+	if (self.deque.take(task)) {
+		self.local.fetch_add(1, std::memory_order_relaxed);
+		return task;
+	}
+	{
+		std::lock_guard<std::mutex>	lock(this->_mutex);
+
+		if (!this->_injection.empty()) {
+			task = this->_injection.front();
+			this->_injection.pop_front();
+		}
+	}
+	if (task) {
+		self.injected.fetch_add(1, std::memory_order_relaxed);
+		return task;
+	}
+
+	const size_type	count = this->_workers.size();
+	const size_type	first = static_cast<size_type>(_xorshift(seed) % count);
+
+	for (size_type i = 0; i != count; ++i) {
+		const size_type	victim = (first + i) % count;
+
+		if (victim != index && this->_workers[victim]->deque.steal(task)) {
+			self.stolen.fetch_add(1, std::memory_order_relaxed);
+			return task;
+		}
+	}
+	return nullptr;
+}
+
+void					nw::scheduler::_run(const size_type &index) {
+	worker		&self = *this->_workers[index];
+	uint64_t	seed = 0x9e3779b97f4a7c15ULL * (index + 1);
+
+	_current = this;
+	_current_index = index;
+	while (true) {
+		task_type	*task = this->_next(index, seed);
+
+		if (task) {
+			(*task)();
+			delete task;
+			self.executed.fetch_add(1, std::memory_order_relaxed);
+			this->_done();
+			continue ;
+		}
+
+		std::unique_lock<std::mutex>	lock(this->_mutex);
+
+		this->_sleepers.fetch_add(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (this->_stop.load() && !this->_pending.load(std::memory_order_seq_cst)) {
+			this->_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+			break ;
+		}
+		if (this->_injection.empty() && !this->_stop.load()) {
+			bool	queued = false;
+
+			for (const std::unique_ptr<worker> &w : this->_workers)
+				queued = queued || w->deque.size();
+			if (!queued) {
+				self.parks.fetch_add(1, std::memory_order_relaxed);
+				this->_wakeup.wait(lock);
+			}
+		}
+		this->_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+	}
+	_current = nullptr;
+	_current_index = npos;
+}
+
+const std::string		nw::scheduler::to_string(void) const {
+	return format_string([this](formatter &f){
+		f.begin_object();
+		f.key("workers").value(static_cast<uint64_t>(this->_workers.size()));
+		f.key("pending").value(this->_pending.load(std::memory_order_relaxed));
+		f.key("stats");
+		this->get_stats().format(f);
+		f.end_object();
+	}, 256);
+}
+
+const std::string		nw::scheduler_stats::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 128);
+}
+
+void					nw::scheduler_stats::format(formatter &f) const {
+	f.begin_object();
+	f.key("executed").value(this->executed);
+	f.key("local").value(this->local);
+	f.key("injected").value(this->injected);
+	f.key("stolen").value(this->stolen);
+	f.key("parks").value(this->parks);
+	f.end_object();
+}
+
+nw::mailbox::mailbox(void) : _fd(_s_eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), _mutex(), _queue(), _running() {
+	if (this->_fd == -1)
+		throw system_error(errno, std::generic_category(), "eventfd");
+}
+
+nw::mailbox::~mailbox(void) {
+	_s_close(this->_fd);
+}
+
+void					nw::mailbox::post(message_type fct) {
+	bool	was_empty;
+
+	{
+		std::lock_guard<std::mutex>	lock(this->_mutex);
+
+		was_empty = this->_queue.empty();
+		this->_queue.push_back(std::move(fct));
+	}
+	if (was_empty && _s_eventfd_write(this->_fd, 1) == -1)
+		throw system_error(errno, std::generic_category(), "eventfd_write");
+}
+
+nw::size_type			nw::mailbox::drain(void) {
+	eventfd_t	value;
+
+	_s_eventfd_read(this->_fd, &value);
+	{
+		std::lock_guard<std::mutex>	lock(this->_mutex);
+
+		this->_running.swap(this->_queue);
+	}
+
+	const size_type	count = this->_running.size();
+
+	for (message_type &fct : this->_running)
+		fct();
+	this->_running.clear();
+	return count;
+}
+
+const nw::sockfd_type &	nw::mailbox::get_fd(void) const {
+	return this->_fd;
+}
+
+std::ostream &			operator<<(std::ostream &o, const nw::scheduler_stats &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &			operator<<(std::ostream &o, const nw::scheduler &C) {
+	o << C.to_string();
+	return (o);
+}
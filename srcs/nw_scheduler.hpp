@@ -0,0 +1,258 @@
+#ifndef __NW_SCHEDULER_HPP__
+# define __NW_SCHEDULER_HPP__
+
+/*!
+@file nw_scheduler.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <functional>
+# include <atomic>
+# include <mutex>
+# include <condition_variable>
+# include <thread>
+# include <deque>
+# include <vector>
+# include <memory>
+
+# include "nw_typedef.hpp"
+# include "nw_format.hpp"
+
+namespace nw {
+	//! @tparam T element type, trivially copyable, a pointer in practice
+	template <typename T>
+	//! @brief Fixed capacity Chase-Lev work-stealing deque
+	//! @details
+	//! The owner thread pushes and takes at the bottom, any thread steals at the top, without lock. C11 memory orders
+	//! of "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+	class work_deque {
+		public:
+			//! @brief Construct a deque of capacity rounded up to a power of 2
+			explicit work_deque(
+				const size_type &capacity = 1024	//!< maximum number of elements
+			) : _top(0), _pad(), _bottom(0), _mask(_round(capacity) - 1), _slots(new std::atomic<T>[_mask + 1]) {}
+
+			~work_deque(void) {}
+
+			//! @brief Push at the bottom, owner only
+			//! @return false if the deque is full
+			bool	push(const T &value) {
+				const int64_t	b = this->_bottom.load(std::memory_order_relaxed);
+				const int64_t	t = this->_top.load(std::memory_order_acquire);
+
+				if (b - t > static_cast<int64_t>(this->_mask))
+					return false;
+				this->_slots[b & this->_mask].store(value, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				this->_bottom.store(b + 1, std::memory_order_relaxed);
+				return true;
+			}
+
+			//! @brief Take the last pushed element, owner only
+			//! @return false if the deque is empty
+			bool	take(T &value) {
+				const int64_t	b = this->_bottom.load(std::memory_order_relaxed) - 1;
+				int64_t			t;
+
+				this->_bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				t = this->_top.load(std::memory_order_relaxed);
+				if (t > b) {
+					this->_bottom.store(b + 1, std::memory_order_relaxed);
+					return false;
+				}
+				value = this->_slots[b & this->_mask].load(std::memory_order_relaxed);
+				if (t != b)
+					return true;
+
+				const bool	won = this->_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+				this->_bottom.store(b + 1, std::memory_order_relaxed);
+				return won;
+			}
+
+			//! @brief Steal the first pushed element, any thread
+			//! @return false if the deque is empty or another thief won the race
+			bool	steal(T &value) {
+				int64_t	t = this->_top.load(std::memory_order_acquire);
+
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				const int64_t	b = this->_bottom.load(std::memory_order_acquire);
+
+				if (t >= b)
+					return false;
+				value = this->_slots[t & this->_mask].load(std::memory_order_relaxed);
+				return this->_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			}
+
+			//! @brief Return an estimate of the number of elements
+			size_type	size(void) const {
+				const int64_t	b = this->_bottom.load(std::memory_order_relaxed);
+				const int64_t	t = this->_top.load(std::memory_order_relaxed);
+
+				return (b > t) ? static_cast<size_type>(b - t) : 0;
+			}
+
+			size_type	capacity(void) const {
+				return this->_mask + 1;
+			}
+
+		protected:
+			std::atomic<int64_t>				_top;
+			char								_pad[64 - sizeof(std::atomic<int64_t>)];	//!< keep thieves and owner on separate cache lines
+			std::atomic<int64_t>				_bottom;
+			const size_type						_mask;
+			std::unique_ptr<std::atomic<T>[]>	_slots;
+
+			static size_type	_round(const size_type &n) {
+				size_type	p = 2;
+
+				while (p < n)
+					p <<= 1;
+				return p;
+			}
+
+		private:
+			work_deque(const work_deque &src) = delete;
+			work_deque &	operator=(const work_deque &src) = delete;
+	};
+
+	//! @brief nw::scheduler counters, summed over workers
+	struct	scheduler_stats {
+		uint64_t	executed;	//!< tasks run
+		uint64_t	local;		//!< tasks taken from the worker own deque
+		uint64_t	injected;	//!< tasks taken from the injection queue
+		uint64_t	stolen;		//!< tasks stolen from another worker
+		uint64_t	parks;		//!< times a worker went to sleep for lack of task
+
+		const std::string	to_string(void) const;
+
+		//! @brief Write counters to a nw::formatter, without allocation
+		void				format(formatter &f) const;
+	};
+
+	//! @brief Work-stealing task scheduler
+	//! @details
+	//! Each worker thread runs tasks from its own deque, newest first, then from the shared injection queue, then steals
+	//! the oldest task of a random other worker. Tasks spawned from a worker go to its deque, tasks submitted by other
+	//! threads, I/O threads handing over a request, go to the injection queue. Idle workers sleep until a task is queued.
+	//!
+	//! Request processing is offloaded from an I/O thread with nw::scheduler::submit, its result is handed back to the
+	//! thread owning the socket through a nw::mailbox, to be sent from there.
+	//!
+	//! An exception escaping a task terminates the program, like from a std::thread.
+	class scheduler {
+		public:
+			typedef std::function<void(void)>	task_type;
+
+			//! @brief Start workers threads
+			//! @throw std::system_error if a thread can not be started
+			explicit scheduler(
+				const size_type &workers = std::thread::hardware_concurrency(),	//!< number of worker threads, at least 1
+				const size_type &deque_capacity = 4096							//!< tasks per worker deque, overflow goes to the injection queue
+			);
+
+			//! @brief Run every queued task then join workers
+			virtual	~scheduler(void);
+
+			//! @brief Queue a task from any thread, see nw::scheduler::spawn from a worker
+			void		submit(task_type task);
+
+			//! @brief Queue a task on the current worker deque, or on the injection queue when not called from a worker
+			void		spawn(task_type task);
+
+			//! @brief Wait until every queued task has run, from a thread other than a worker
+			void		wait_idle(void);
+
+			//! @brief Return the number of worker threads
+			size_type	size(void) const;
+
+			//! @brief Return the index of the calling worker of this scheduler, nw::npos from another thread
+			size_type	current_worker(void) const;
+
+			scheduler_stats		get_stats(void) const;
+
+			const std::string	to_string(void) const;
+
+		protected:
+			struct	worker {
+				work_deque<task_type *>	deque;
+				std::thread				thread;
+				std::atomic<uint64_t>	executed;
+				std::atomic<uint64_t>	local;
+				std::atomic<uint64_t>	injected;
+				std::atomic<uint64_t>	stolen;
+				std::atomic<uint64_t>	parks;
+
+				explicit worker(const size_type &capacity);
+			};
+
+			std::vector<std::unique_ptr<worker> >	_workers;
+			std::mutex								_mutex;			//!< protects _injection and sleeping
+			std::condition_variable					_wakeup;		//!< signaled when a task is queued or on stop
+			std::condition_variable					_idle;			//!< signaled when _pending drops to 0
+			std::deque<task_type *>					_injection;
+			std::atomic<uint64_t>					_pending;		//!< queued or running tasks
+			std::atomic<uint32_t>					_sleepers;
+			std::atomic<bool>						_stop;
+
+			void		_run(const size_type &index);
+			task_type	*_next(const size_type &index, uint64_t &seed);
+			void		_notify(void);
+			void		_done(void);
+
+		private:
+			scheduler(const scheduler &src) = delete;
+			scheduler(scheduler &&src) = delete;
+
+			scheduler &	operator=(const scheduler &src) = delete;
+			scheduler &	operator=(scheduler &&src) = delete;
+	};
+
+	//! @brief Multi producer queue of functions run by a single owner thread, woken through an eventfd
+	//! @details
+	//! The owner registers nw::mailbox::get_fd for nw::poller::IN in its poller and calls nw::mailbox::drain when it is
+	//! readable: a worker thread posts the send of a response and the owner thread, which owns the socket, runs it.
+	//! The eventfd is written only when the mailbox goes from empty to non empty.
+	class mailbox {
+		public:
+			typedef std::function<void(void)>	message_type;
+
+			//! @throw nw::system_error if eventfd(2) function fail's
+			mailbox(void);
+
+			virtual	~mailbox(void);
+
+			//! @brief Queue fct to be run by the owner thread, from any thread
+			//! @throw nw::system_error if eventfd_write(3) function fail's
+			void		post(message_type fct);
+
+			//! @brief Run every queued function, owner thread only
+			//! @return number of functions run
+			size_type	drain(void);
+
+			//! @brief Return the eventfd, readable while functions are queued
+			const sockfd_type &	get_fd(void) const;
+
+		protected:
+			const sockfd_type			_fd;
+			std::mutex					_mutex;
+			std::vector<message_type>	_queue;
+			std::vector<message_type>	_running;
+
+		private:
+			mailbox(const mailbox &src) = delete;
+			mailbox(mailbox &&src) = delete;
+
+			mailbox &	operator=(const mailbox &src) = delete;
+			mailbox &	operator=(mailbox &&src) = delete;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::scheduler_stats &C);
+std::ostream &	operator<<(std::ostream &o, const nw::scheduler &C);
+
+#endif
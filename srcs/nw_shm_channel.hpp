@@ -0,0 +1,496 @@
+#ifndef __NW_SHM_CHANNEL_HPP__
+# define __NW_SHM_CHANNEL_HPP__
+
+/*!
+@file nw_shm_channel.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <functional>
+# include <atomic>
+# include <new>
+# include <thread>
+
+# include <algorithm>
+# include <cstring>
+
+# include <sys/mman.h>
+# include <sys/eventfd.h>
+# include <sys/stat.h>
+# include <unistd.h>
+
+static const std::function<int(const char *, unsigned int)>						_s_memfd_create = &memfd_create;
+static const std::function<int(int, off_t)>										_s_ftruncate = &ftruncate;
+static const std::function<int(int, struct stat *)>								_s_fstat = &fstat;
+static const std::function<void *(void *, size_t, int, int, int, off_t)>		_s_mmap = &mmap;
+static const std::function<int(void *, size_t)>									_s_munmap = &munmap;
+static const std::function<int(unsigned int, int)>								_s_eventfd = &eventfd;
+static const std::function<int(int, eventfd_t *)>								_s_eventfd_read = &eventfd_read;
+static const std::function<int(int, eventfd_t)>									_s_eventfd_write = &eventfd_write;
+
+# include "nw_typedef.hpp"
+# include "nw_socket.hpp"
+
+# include "buffer/nw_ibuffer.hpp"
+# include "buffer/nw_obuffer.hpp"
+
+namespace nw {
+	//! @brief nw::shm_channel blocked peer wakeup mode
+	enum class shm_wakeup : uint8_t {
+		EVENTFD,	//!< a blocked side sleeps on an eventfd, written by the other side only while it is asleep
+		SPIN		//!< a blocked side busy polls the ring, yielding the cpu between polls after a while, no wakeup system call
+	};
+
+	//! @tparam SIZE ring size in bytes, per direction
+	template <size_type SIZE>
+	//! @brief Bidirectional byte stream between two co-located processes over a pair of SPSC rings in shared memory
+	//! @details
+	//! The creating side allocates the rings in a memfd and hands it, with the wakeup eventfds, to the other side through
+	//! an AF_LOCAL control socket (SCM_RIGHTS). Once set up, send and recv copy straight between nw::obuffer / nw::ibuffer
+	//! and the ring: in nw::shm_wakeup::SPIN mode no system call is issued, in nw::shm_wakeup::EVENTFD mode an eventfd
+	//! is written only when the other side is blocked on an empty (or full) ring.
+	//!
+	//! send and recv block like their nw::socket counterparts. recv return 0 once the other side is closed or destroyed
+	//! and every byte has been read, send then throw EPIPE. A peer process dying without running its destructor is not
+	//! detected through the ring, the control socket can be watched for that.
+	class shm_channel {
+		public:
+			//! @tparam TYPE nw::sock_type of control socket
+			template <sock_type TYPE>
+			//! @brief Create the shared rings and hand them to the peer over control
+			//!
+			//! @throw nw::system_error if memfd_create(2), ftruncate(2), mmap(2), eventfd(2) or sendmsg(2) function fail's
+			shm_channel(
+				socket<sa_family::LOCAL, TYPE> &control,	//!< connected nw::sa_family::LOCAL socket
+				const shm_wakeup &wakeup					//!< nw::shm_wakeup
+			) : _seg(nullptr), _memfd(-1), _efd{{-1, -1}, {-1, -1}}, _tx(0) {
+				try {
+					const sockfd_type	fds[FDS] = {
+						this->_memfd = _s_memfd_create("nw_shm_channel", MFD_CLOEXEC),
+						(wakeup == shm_wakeup::EVENTFD) ? this->_efd[0][DATA] = _s_eventfd(0, EFD_CLOEXEC) : 0,
+						(wakeup == shm_wakeup::EVENTFD) ? this->_efd[0][SPACE] = _s_eventfd(0, EFD_CLOEXEC) : 0,
+						(wakeup == shm_wakeup::EVENTFD) ? this->_efd[1][DATA] = _s_eventfd(0, EFD_CLOEXEC) : 0,
+						(wakeup == shm_wakeup::EVENTFD) ? this->_efd[1][SPACE] = _s_eventfd(0, EFD_CLOEXEC) : 0
+					};
+
+					if (this->_memfd == -1)
+						throw system_error(errno, std::generic_category(), "memfd_create");
+					for (size_type i = 1; i != FDS; ++i)
+						if (fds[i] == -1)
+							throw system_error(errno, std::generic_category(), "eventfd");
+					if (_s_ftruncate(this->_memfd, sizeof(segment)) == -1)
+						throw system_error(errno, std::generic_category(), "ftruncate");
+					this->_map();
+					new (this->_seg) segment();
+					this->_seg->magic = MAGIC;
+					this->_seg->size = SIZE;
+					this->_seg->wakeup = wakeup;
+
+					const size_type	nfds = (wakeup == shm_wakeup::EVENTFD) ? FDS : 1;
+					uint8_t			mode = static_cast<uint8_t>(wakeup);
+					struct iovec	iov = {&mode, sizeof(mode)};
+					union {
+						struct cmsghdr	align;
+						char			buf[CMSG_SPACE(sizeof(fds))];
+					}				control_buf = {};
+					struct msghdr	msg = {};
+
+					msg.msg_iov = &iov;
+					msg.msg_iovlen = 1;
+					msg.msg_control = control_buf.buf;
+					msg.msg_controllen = CMSG_SPACE(nfds * sizeof(sockfd_type));
+
+					struct cmsghdr	*cmsg = CMSG_FIRSTHDR(&msg);
+
+					cmsg->cmsg_level = SOL_SOCKET;
+					cmsg->cmsg_type = SCM_RIGHTS;
+					cmsg->cmsg_len = CMSG_LEN(nfds * sizeof(sockfd_type));
+					std::memcpy(CMSG_DATA(cmsg), fds, nfds * sizeof(sockfd_type));
+					control.send(msg);
+				} catch (...) {
+					this->_release();
+					throw ;
+				}
+			}
+
+			//! @tparam TYPE nw::sock_type of control socket
+			template <sock_type TYPE>
+			//! @brief Map the shared rings handed over control by the creating peer
+			//!
+			//! @throw nw::system_error if recvmsg(2), fstat(2) or mmap(2) function fail's
+			//! @throw nw::logic_error if control is closed or do not carry a nw::shm_channel<SIZE>
+			explicit shm_channel(
+				socket<sa_family::LOCAL, TYPE> &control		//!< connected nw::sa_family::LOCAL socket
+			) : _seg(nullptr), _memfd(-1), _efd{{-1, -1}, {-1, -1}}, _tx(1) {
+				try {
+					sockfd_type		fds[FDS] = {-1, -1, -1, -1, -1};
+					uint8_t			mode = 0;
+					struct iovec	iov = {&mode, sizeof(mode)};
+					union {
+						struct cmsghdr	align;
+						char			buf[CMSG_SPACE(sizeof(fds))];
+					}				control_buf = {};
+					struct msghdr	msg = {};
+
+					msg.msg_iov = &iov;
+					msg.msg_iovlen = 1;
+					msg.msg_control = control_buf.buf;
+					msg.msg_controllen = sizeof(control_buf.buf);
+					if (!control.recv(msg, MSG_CMSG_CLOEXEC))
+						throw logic_error("shm_channel: control socket closed");
+					for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+						if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+							std::memcpy(fds, CMSG_DATA(cmsg), std::min<size_type>(cmsg->cmsg_len - CMSG_LEN(0), sizeof(fds)));
+					}
+					this->_memfd = fds[0];
+					if (static_cast<shm_wakeup>(mode) == shm_wakeup::EVENTFD) {
+						this->_efd[0][DATA] = fds[1];
+						this->_efd[0][SPACE] = fds[2];
+						this->_efd[1][DATA] = fds[3];
+						this->_efd[1][SPACE] = fds[4];
+					}
+					if (msg.msg_flags & MSG_CTRUNC || this->_memfd == -1)
+						throw logic_error("shm_channel: missing file descriptors");
+
+					struct stat	st = {};
+
+					if (_s_fstat(this->_memfd, &st) == -1)
+						throw system_error(errno, std::generic_category(), "fstat");
+					if (static_cast<size_type>(st.st_size) != sizeof(segment))
+						throw logic_error("shm_channel: segment size mismatch");
+					this->_map();
+					if (this->_seg->magic != MAGIC || this->_seg->size != SIZE || this->_seg->wakeup != static_cast<shm_wakeup>(mode))
+						throw logic_error("shm_channel: segment mismatch");
+				} catch (...) {
+					this->_release();
+					throw ;
+				}
+			}
+
+			//! @brief Move constructor
+			shm_channel(
+				shm_channel &&src	//!< nw::shm_channel
+			) : _seg(src._seg), _memfd(src._memfd), _efd{{src._efd[0][0], src._efd[0][1]}, {src._efd[1][0], src._efd[1][1]}}, _tx(src._tx) {
+				src._seg = nullptr;
+				src._memfd = -1;
+				src._efd[0][0] = src._efd[0][1] = src._efd[1][0] = src._efd[1][1] = -1;
+			}
+
+			//! @brief Close both directions and unmap the rings
+			virtual	~shm_channel(void) {
+				this->close(std::nothrow);
+				this->_release();
+			}
+
+			//! @brief Close the transmit direction: peer recv return 0 once the ring is drained
+			void	shutdown(void) {
+				this->_close(this->_tx);
+			}
+
+			//! @brief Close both directions: peer recv return 0 once the ring is drained, peer send throw EPIPE
+			//! @throw nw::system_error if eventfd_write(3) function fail's
+			void	close(void) {
+				this->_close(0);
+				this->_close(1);
+			}
+
+			//! @brief Close both directions with no throw behavior, a failed wake-up of a waiting peer is ignored
+			void	close(std::nothrow_t) {
+				this->_close(0, std::nothrow);
+				this->_close(1, std::nothrow);
+			}
+
+			//! @tparam N nw::size_type
+			template <size_type N>
+			//! @brief Copy pending data of buf into the transmit ring, block while the ring is full
+			//!
+			//! @return number of bytes sent
+			//! @throw nw::system_error with EPIPE if the channel is closed or moved from
+			size_type	send(
+				obuffer<N> &buf		//!< nw::obuffer<N>
+			) {
+				return buf.syncv([this](struct iovec *iov, size_type iovcnt){
+					return static_cast<ssize_t>(this->_write(iov, iovcnt));
+				});
+			}
+
+			//! @tparam N nw::size_type
+			template <size_type N>
+			//! @brief Copy available data of the receive ring into buf, block while the ring is empty
+			//!
+			//! @return number of bytes received, 0 if the channel is closed and drained or moved from
+			size_type	recv(
+				ibuffer<N> &buf		//!< nw::ibuffer<N>
+			) {
+				return buf.syncv([this](struct iovec *iov, size_type iovcnt){
+					return static_cast<ssize_t>(this->_read(iov, iovcnt));
+				});
+			}
+
+			//! @tparam N nw::size_type
+			template <size_type N>
+			//! @brief Call to nw::shm_channel<SIZE>::send(obuffer<N> &buf)
+			shm_channel &	operator<<(
+				obuffer<N> &buf		//!< nw::obuffer<N>
+			) {
+				this->send(buf);
+				return *this;
+			}
+
+			//! @tparam N nw::size_type
+			template <size_type N>
+			//! @brief Call to nw::shm_channel<SIZE>::recv(ibuffer<N> &buf)
+			shm_channel &	operator>>(
+				ibuffer<N> &buf		//!< nw::ibuffer<N>
+			) {
+				this->recv(buf);
+				return *this;
+			}
+
+			//! @brief Number of bytes readable without blocking, 0 once closed or moved from
+			size_type	in_avail(void) const {
+				if (!this->_seg)
+					return 0;
+
+				const ring	&r = this->_seg->rings[this->_tx ^ 1];
+
+				return r.put.load(std::memory_order_acquire) - r.get.load(std::memory_order_relaxed);
+			}
+
+			inline size_type	size(void) const {
+				return SIZE;
+			}
+
+			const std::string	to_string(void) const {
+				return format_string([this](formatter &f){ this->format(f); }, 256);
+			}
+
+			//! @brief Write ring positions to a nw::formatter, without allocation
+			void				format(formatter &f) const {
+				f.begin_object();
+				f.key("size").value(static_cast<uint64_t>(SIZE));
+				if (!this->_seg) {
+					f.key("mapped").value(false);
+					f.end_object();
+					return ;
+				}
+				f.key("wakeup").value((this->_seg->wakeup == shm_wakeup::SPIN) ? "spin" : "eventfd");
+				for (uint8_t r = 0; r != 2; ++r) {
+					const ring	&ring = this->_seg->rings[r];
+
+					f.key((r == this->_tx) ? "tx" : "rx").begin_object();
+					f.key("put").value(static_cast<uint64_t>(ring.put.load(std::memory_order_relaxed)));
+					f.key("get").value(static_cast<uint64_t>(ring.get.load(std::memory_order_relaxed)));
+					f.key("closed").value(static_cast<bool>(ring.closed.load(std::memory_order_relaxed)));
+					f.end_object();
+				}
+				f.end_object();
+			}
+
+		protected:
+			static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shm_channel: atomics must be lock free to be shared between processes");
+
+			static const uint64_t	MAGIC = 0x6e77736863686e31;	//!< "nwshchn1"
+			static const size_type	FDS = 5;					//!< memfd, then data and space eventfd of both rings
+			static const size_type	SPINS = 1024;				//!< busy polls before yielding the cpu in nw::shm_wakeup::SPIN mode
+			static const uint8_t	DATA = 0;
+			static const uint8_t	SPACE = 1;
+
+			//! @brief SPSC byte ring, put and get count every byte ever written and read
+			struct	ring {
+				alignas(64) std::atomic<uint64_t>	put;			//!< written by producer only
+				alignas(64) std::atomic<uint64_t>	get;			//!< written by consumer only
+				alignas(64) std::atomic<uint32_t>	get_waiting;	//!< consumer is asleep on the data eventfd
+				std::atomic<uint32_t>				put_waiting;	//!< producer is asleep on the space eventfd
+				std::atomic<uint32_t>				closed;
+				alignas(64) int8_t					buf[SIZE];
+			};
+
+			//! @brief memfd layout, rings[0] is written by the creating side
+			struct	segment {
+				uint64_t	magic;
+				uint64_t	size;
+				shm_wakeup	wakeup;
+				ring		rings[2];
+			};
+
+			segment		*_seg;
+			sockfd_type	_memfd;
+			sockfd_type	_efd[2][2];
+			uint8_t		_tx;		//!< index of the transmit ring
+
+			void	_map(void) {
+				void	*seg = _s_mmap(nullptr, sizeof(segment), PROT_READ | PROT_WRITE, MAP_SHARED, this->_memfd, 0);
+
+				if (seg == MAP_FAILED)
+					throw system_error(errno, std::generic_category(), "mmap");
+				this->_seg = static_cast<segment *>(seg);
+			}
+
+			void	_release(void) {
+				if (this->_seg)
+					_s_munmap(this->_seg, sizeof(segment));
+				this->_seg = nullptr;
+				if (this->_memfd != -1)
+					_s_close(this->_memfd);
+				this->_memfd = -1;
+				for (uint8_t r = 0; r != 2; ++r) {
+					for (uint8_t e = 0; e != 2; ++e) {
+						if (this->_efd[r][e] != -1)
+							_s_close(this->_efd[r][e]);
+						this->_efd[r][e] = -1;
+					}
+				}
+			}
+
+			void	_close(const uint8_t &r) {
+				if (!this->_seg)
+					return ;
+				this->_seg->rings[r].closed.store(1, std::memory_order_seq_cst);
+				this->_wake(this->_seg->rings[r].get_waiting, this->_efd[r][DATA]);
+				this->_wake(this->_seg->rings[r].put_waiting, this->_efd[r][SPACE]);
+			}
+
+			void	_close(const uint8_t &r, std::nothrow_t) {
+				if (!this->_seg)
+					return ;
+				this->_seg->rings[r].closed.store(1, std::memory_order_seq_cst);
+				this->_wake(this->_seg->rings[r].get_waiting, this->_efd[r][DATA], std::nothrow);
+				this->_wake(this->_seg->rings[r].put_waiting, this->_efd[r][SPACE], std::nothrow);
+			}
+
+			static inline void	_relax(void) {
+# if defined(__x86_64__) || defined(__i386__)
+				__builtin_ia32_pause();
+# elif defined(__aarch64__)
+				asm volatile("yield" ::: "memory");
+# endif
+			}
+
+			//! @brief Block until ready return true, announcing it through waiting when an eventfd is available
+			template <typename F>
+			void	_wait(std::atomic<uint32_t> &waiting, const sockfd_type &efd, F ready) {
+				for (size_type spins = 0; !ready(); ++spins) {
+					if (efd == -1) {
+						// yield once the peer had a fair chance to run on another cpu, it may share ours
+						if (spins < SPINS)
+							_relax();
+						else
+							std::this_thread::yield();
+						continue ;
+					}
+					waiting.store(1, std::memory_order_seq_cst);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					if (ready()) {
+						waiting.store(0, std::memory_order_relaxed);
+						return ;
+					}
+
+					eventfd_t	value;
+
+					if (_s_eventfd_read(efd, &value) == -1 && errno != EINTR)
+						throw system_error(errno, std::generic_category(), "eventfd_read");
+				}
+			}
+
+			//! @brief Wake the other side if it announced sleeping through waiting
+			void	_wake(std::atomic<uint32_t> &waiting, const sockfd_type &efd) {
+				const int32_t	error = this->_wake(waiting, efd, std::nothrow);
+
+				if (error)
+					throw system_error(error, std::generic_category(), "eventfd_write");
+			}
+
+			//! @return 0 on success, errno value of eventfd_write(3) otherwise
+			int32_t	_wake(std::atomic<uint32_t> &waiting, const sockfd_type &efd, std::nothrow_t) {
+				if (efd == -1)
+					return 0;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (waiting.load(std::memory_order_relaxed) && waiting.exchange(0, std::memory_order_acq_rel)) {
+					if (_s_eventfd_write(efd, 1) == -1)
+						return errno;
+				}
+				return 0;
+			}
+
+			size_type	_write(const struct iovec *iov, const size_type &iovcnt) {
+				if (!this->_seg)
+					throw system_error(EPIPE, std::generic_category(), "shm_channel: send");
+
+				ring			&r = this->_seg->rings[this->_tx];
+				const uint64_t	put = r.put.load(std::memory_order_relaxed);
+
+				this->_wait(r.put_waiting, this->_efd[this->_tx][SPACE], [&r, put](){
+					return put - r.get.load(std::memory_order_acquire) != SIZE || r.closed.load(std::memory_order_acquire);
+				});
+				if (r.closed.load(std::memory_order_acquire))
+					throw system_error(EPIPE, std::generic_category(), "shm_channel: send");
+
+				size_type	left = SIZE - (put - r.get.load(std::memory_order_acquire));
+				size_type	total = 0;
+
+				for (size_type i = 0; i != iovcnt && left; ++i) {
+					const size_type	n = std::min<size_type>(iov[i].iov_len, left);
+					const size_type	off = (put + total) % SIZE;
+					const size_type	back = std::min(n, SIZE - off);
+
+					std::memcpy(r.buf + off, iov[i].iov_base, back);
+					std::memcpy(r.buf, static_cast<const int8_t *>(iov[i].iov_base) + back, n - back);
+					total += n;
+					left -= n;
+				}
+				r.put.store(put + total, std::memory_order_release);
+				this->_wake(r.get_waiting, this->_efd[this->_tx][DATA]);
+				return total;
+			}
+
+			size_type	_read(const struct iovec *iov, const size_type &iovcnt) {
+				if (!this->_seg)
+					return 0;
+
+				const uint8_t	rx = this->_tx ^ 1;
+				ring			&r = this->_seg->rings[rx];
+				const uint64_t	get = r.get.load(std::memory_order_relaxed);
+
+				this->_wait(r.get_waiting, this->_efd[rx][DATA], [&r, get](){
+					return r.put.load(std::memory_order_acquire) != get || r.closed.load(std::memory_order_acquire);
+				});
+
+				// closed is set after the last put, so put read after it is final
+				size_type	left = r.put.load(std::memory_order_acquire) - get;
+				size_type	total = 0;
+
+				for (size_type i = 0; i != iovcnt && left; ++i) {
+					const size_type	n = std::min<size_type>(iov[i].iov_len, left);
+					const size_type	off = (get + total) % SIZE;
+					const size_type	back = std::min(n, SIZE - off);
+
+					std::memcpy(iov[i].iov_base, r.buf + off, back);
+					std::memcpy(static_cast<int8_t *>(iov[i].iov_base) + back, r.buf, n - back);
+					total += n;
+					left -= n;
+				}
+				if (!total)
+					return 0;
+				r.get.store(get + total, std::memory_order_release);
+				this->_wake(r.put_waiting, this->_efd[rx][SPACE]);
+				return total;
+			}
+
+		private:
+			shm_channel(const shm_channel &src) = delete;
+
+			shm_channel &	operator=(const shm_channel &src) = delete;
+			shm_channel &	operator=(shm_channel &&src) = delete;
+	};
+};
+
+template <nw::size_type SIZE>
+std::ostream &	operator<<(std::ostream &o, const nw::shm_channel<SIZE> &C) {
+	o << C.to_string();
+	return o;
+}
+
+#endif
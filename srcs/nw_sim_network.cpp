@@ -0,0 +1,554 @@
+
+/*!
+@file nw_sim_network.cpp
+@brief ...
+*/
+
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+
+#include "nw_sim_network.hpp"
+#include "nw_format.hpp"
+
+nw::sim_network	*nw::sim_network::_s_installed = nullptr;
+
+nw::sim_network::sim_network(const size_type &capacity) \
+	: _capacity(capacity), _endpoints(), _free(), _bound(), _saved(), _installed(false), _stats() {
+}
+
+nw::sim_network::~sim_network(void) {
+	this->uninstall();
+}
+
+void						nw::sim_network::install(void) {
+	if (_s_installed)
+		throw logic_error("sim_network: a backend is already installed");
+
+	transport	&t = transport::current;
+
+	this->_saved = t;
+	t.socket = [this](int domain, int type, int protocol){
+		++this->_stats.calls;
+		return this->_socket(domain, type, protocol);
+	};
+	t.socketpair = [this](int domain, int type, int protocol, int *fds){
+		++this->_stats.calls;
+		return this->_socketpair(domain, type, protocol, fds);
+	};
+	t.bind = [this](int fd, const struct sockaddr *addr, socklen_t len){
+		return (this->_owns(fd)) ? this->_bind(fd, addr, len) : this->_saved.bind(fd, addr, len);
+	};
+	t.listen = [this](int fd, int backlog){
+		return (this->_owns(fd)) ? this->_listen(fd, backlog) : this->_saved.listen(fd, backlog);
+	};
+	t.connect = [this](int fd, const struct sockaddr *addr, socklen_t len){
+		return (this->_owns(fd)) ? this->_connect(fd, addr, len) : this->_saved.connect(fd, addr, len);
+	};
+	t.accept = [this](int fd, struct sockaddr *addr, socklen_t *len){
+		return (this->_owns(fd)) ? this->_accept(fd, addr, len) : this->_saved.accept(fd, addr, len);
+	};
+	t.close = [this](int fd){
+		return (this->_owns(fd)) ? this->_close(fd) : this->_saved.close(fd);
+	};
+	t.shutdown = [this](int fd, int how){
+		return (this->_owns(fd)) ? this->_shutdown(fd, how) : this->_saved.shutdown(fd, how);
+	};
+	t.fcntl = [this](int fd, int cmd, int arg){
+		return (this->_owns(fd)) ? this->_fcntl(fd, cmd, arg) : this->_saved.fcntl(fd, cmd, arg);
+	};
+	t.getsockopt = [this](int fd, int level, int name, void *value, socklen_t *len){
+		return (this->_owns(fd)) ? this->_getsockopt(fd, level, name, value, len) : this->_saved.getsockopt(fd, level, name, value, len);
+	};
+	t.setsockopt = [this](int fd, int level, int name, const void *value, socklen_t len){
+		return (this->_owns(fd)) ? 0 : this->_saved.setsockopt(fd, level, name, value, len);
+	};
+	t.send = [this](int fd, void *buf, size_t len, int flags) -> ssize_t {
+		if (!this->_owns(fd))
+			return this->_saved.send(fd, buf, len, flags);
+
+		const struct iovec	iov = {buf, len};
+
+		return this->_send(fd, &iov, 1);
+	};
+	t.sendto = [this](int fd, void *buf, size_t len, int flags, const struct sockaddr *addr, socklen_t addrlen) -> ssize_t {
+		if (!this->_owns(fd))
+			return this->_saved.sendto(fd, buf, len, flags, addr, addrlen);
+
+		const struct iovec	iov = {buf, len};
+
+		return this->_send(fd, &iov, 1);
+	};
+	t.sendmsg = [this](int fd, const struct msghdr *msg, int flags) -> ssize_t {
+		return (this->_owns(fd)) ? this->_send(fd, msg->msg_iov, msg->msg_iovlen) : this->_saved.sendmsg(fd, msg, flags);
+	};
+	t.recv = [this](int fd, void *buf, size_t len, int flags) -> ssize_t {
+		if (!this->_owns(fd))
+			return this->_saved.recv(fd, buf, len, flags);
+
+		const struct iovec	iov = {buf, len};
+
+		return this->_recv(fd, &iov, 1, flags);
+	};
+	t.recvfrom = [this](int fd, void *buf, size_t len, int flags, struct sockaddr *addr, socklen_t *addrlen) -> ssize_t {
+		if (!this->_owns(fd))
+			return this->_saved.recvfrom(fd, buf, len, flags, addr, addrlen);
+
+		const struct iovec	iov = {buf, len};
+
+		if (addrlen)
+			*addrlen = 0;
+		return this->_recv(fd, &iov, 1, flags);
+	};
+	t.recvmsg = [this](int fd, struct msghdr *msg, int flags) -> ssize_t {
+		if (!this->_owns(fd))
+			return this->_saved.recvmsg(fd, msg, flags);
+		msg->msg_namelen = 0;
+		msg->msg_controllen = 0;
+		msg->msg_flags = 0;
+		return this->_recv(fd, msg->msg_iov, msg->msg_iovlen, flags);
+	};
+	t.recvmmsg = [this](int fd, struct mmsghdr *msgs, unsigned int count, int flags, struct timespec *timeout){
+		return (this->_owns(fd)) ? this->_fail(EOPNOTSUPP) : this->_saved.recvmmsg(fd, msgs, count, flags, timeout);
+	};
+	t.sendmmsg = [this](int fd, struct mmsghdr *msgs, unsigned int count, int flags){
+		return (this->_owns(fd)) ? this->_fail(EOPNOTSUPP) : this->_saved.sendmmsg(fd, msgs, count, flags);
+	};
+	t.poll = [this](struct pollfd *fds, nfds_t nfds, int timeout){
+		return this->_poll(fds, nfds, timeout);
+	};
+	this->_installed = true;
+	_s_installed = this;
+}
+
+void						nw::sim_network::uninstall(void) {
+	if (!this->_installed)
+		return ;
+	transport::current = this->_saved;
+	this->_installed = false;
+	_s_installed = nullptr;
+}
+
+void						nw::sim_network::set_faults(const sockfd_type &fd, const sim_faults &faults) {
+	endpoint	*e = this->_get(fd);
+
+	if (!e)
+		throw logic_error("sim_network: not a simulated socket");
+	e->faults = faults;
+}
+
+nw::size_type				nw::sim_network::readable(const sockfd_type &fd) const {
+	const endpoint	*e = this->_get(fd);
+
+	if (!e)
+		throw logic_error("sim_network: not a simulated socket");
+	return e->len;
+}
+
+const nw::sim_stats &		nw::sim_network::get_stats(void) const {
+	return this->_stats;
+}
+
+//! @return true if fd is simulated, counting the call
+bool						nw::sim_network::_owns(const sockfd_type &fd) {
+	if (!this->_get(fd))
+		return false;
+	++this->_stats.calls;
+	return true;
+}
+
+nw::sim_network::endpoint *	nw::sim_network::_get(const sockfd_type &fd) const {
+	if (fd < FD_BASE || static_cast<size_type>(fd - FD_BASE) >= this->_endpoints.size())
+		return nullptr;
+	return this->_endpoints[fd - FD_BASE].get();
+}
+
+nw::sockfd_type				nw::sim_network::_open(const int32_t &flags) {
+	std::unique_ptr<endpoint>	e(new endpoint());
+	sockfd_type					fd;
+
+	e->flags = flags;
+	e->peer = -1;
+	if (this->_free.empty()) {
+		fd = FD_BASE + static_cast<sockfd_type>(this->_endpoints.size());
+		this->_endpoints.push_back(std::move(e));
+	} else {
+		fd = this->_free.back();
+		this->_free.pop_back();
+		this->_endpoints[fd - FD_BASE] = std::move(e);
+	}
+	return fd;
+}
+
+//! @brief Connect two endpoints, allocating their receive queues
+void						nw::sim_network::_link(const sockfd_type &a, const sockfd_type &b) {
+	endpoint	*ea = this->_get(a);
+	endpoint	*eb = this->_get(b);
+
+	ea->peer = b;
+	eb->peer = a;
+	ea->rx.resize(this->_capacity);
+	eb->rx.resize(this->_capacity);
+}
+
+int							nw::sim_network::_fail(const int32_t &error) {
+	if (error == EAGAIN)
+		++this->_stats.would_block;
+	errno = error;
+	return -1;
+}
+
+//! @return true if the call fails with an injected EAGAIN
+bool						nw::sim_network::_inject(endpoint &e) {
+	++e.calls;
+	return e.faults.eagain_every && !(e.calls % e.faults.eagain_every);
+}
+
+void						nw::sim_network::_reset(endpoint &e) {
+	endpoint	*peer = this->_get(e.peer);
+
+	e.reset = true;
+	e.len = 0;
+	if (peer) {
+		peer->reset = true;
+		peer->len = 0;
+	}
+	++this->_stats.resets;
+}
+
+//! @return poll(2) events of e, as the kernel reports them for a TCP socket
+int16_t						nw::sim_network::_revents(const endpoint &e) const {
+	const endpoint	*peer = this->_get(e.peer);
+	int16_t			revents = 0;
+
+	if (e.listening)
+		return (e.pending.empty()) ? 0 : POLLIN;
+	if (e.reset)
+		return POLLIN | POLLOUT | POLLERR | POLLHUP;
+	if (!peer && !e.eof)
+		return POLLHUP;
+	if (e.len || e.eof || e.shut_rd)
+		revents |= POLLIN;
+	if (!peer || e.shut_wr || peer->len != this->_capacity)
+		revents |= POLLOUT;
+	if (e.shut_wr && (e.eof || e.shut_rd))
+		revents |= POLLHUP;
+	return revents;
+}
+
+int							nw::sim_network::_socket(int, int type, int) {
+	if ((type & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)) != SOCK_STREAM)
+		return this->_fail(ESOCKTNOSUPPORT);
+	return this->_open((type & SOCK_NONBLOCK) ? O_NONBLOCK : 0);
+}
+
+int							nw::sim_network::_socketpair(int, int type, int, int *fds) {
+	if ((type & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)) != SOCK_STREAM)
+		return this->_fail(ESOCKTNOSUPPORT);
+	fds[0] = this->_open((type & SOCK_NONBLOCK) ? O_NONBLOCK : 0);
+	fds[1] = this->_open((type & SOCK_NONBLOCK) ? O_NONBLOCK : 0);
+	this->_link(fds[0], fds[1]);
+	return 0;
+}
+
+int							nw::sim_network::_bind(int fd, const struct sockaddr *addr, socklen_t len) {
+	endpoint			*e = this->_get(fd);
+	const std::string	name(reinterpret_cast<const char *>(addr), len);
+
+	if (!e->name.empty())
+		return this->_fail(EINVAL);
+	if (this->_bound.count(name))
+		return this->_fail(EADDRINUSE);
+	e->name = name;
+	this->_bound[name] = fd;
+	return 0;
+}
+
+int							nw::sim_network::_listen(int fd, int backlog) {
+	endpoint	*e = this->_get(fd);
+
+	if (e->name.empty() || e->peer != -1)
+		return this->_fail(EINVAL);
+	e->listening = true;
+	e->backlog = std::max(backlog, 1);
+	return 0;
+}
+
+int							nw::sim_network::_connect(int fd, const struct sockaddr *addr, socklen_t len) {
+	endpoint	*e = this->_get(fd);
+
+	if (e->peer != -1 || e->listening)
+		return this->_fail(EISCONN);
+
+	const std::map<std::string, sockfd_type>::const_iterator	it = this->_bound.find(std::string(reinterpret_cast<const char *>(addr), len));
+	endpoint													*listener = (it != this->_bound.end()) ? this->_get(it->second) : nullptr;
+
+	if (!listener || !listener->listening)
+		return this->_fail(ECONNREFUSED);
+	if (listener->pending.size() >= listener->backlog)
+		return this->_fail(EAGAIN);
+
+	const sockfd_type	peer = this->_open(0);
+
+	this->_get(peer)->name = listener->name;
+	this->_link(fd, peer);
+	listener->pending.push_back(peer);
+	return 0;
+}
+
+//! @details The address reported is the listener one: connecting sockets are not bound.
+int							nw::sim_network::_accept(int fd, struct sockaddr *addr, socklen_t *len) {
+	endpoint	*e = this->_get(fd);
+
+	if (!e->listening)
+		return this->_fail(EINVAL);
+	if (e->pending.empty())
+		return this->_fail(EAGAIN);
+
+	const sockfd_type	peer = e->pending.front();
+
+	e->pending.pop_front();
+	if (addr && len) {
+		std::memcpy(addr, e->name.data(), std::min<size_type>(*len, e->name.size()));
+		*len = static_cast<socklen_t>(e->name.size());
+	}
+	return peer;
+}
+
+int							nw::sim_network::_close(int fd) {
+	endpoint	*e = this->_get(fd);
+	endpoint	*peer = this->_get(e->peer);
+
+	if (peer) {
+		peer->peer = -1;
+		peer->eof = true;
+	}
+	while (!e->pending.empty()) {
+		this->_close(e->pending.front());
+		e->pending.pop_front();
+	}
+
+	const std::map<std::string, sockfd_type>::iterator	it = this->_bound.find(e->name);
+
+	if (it != this->_bound.end() && it->second == fd)
+		this->_bound.erase(it);
+	this->_endpoints[fd - FD_BASE].reset();
+	this->_free.push_back(fd);
+	return 0;
+}
+
+int							nw::sim_network::_shutdown(int fd, int how) {
+	endpoint	*e = this->_get(fd);
+	endpoint	*peer = this->_get(e->peer);
+
+	if (how != SHUT_RD && how != SHUT_WR && how != SHUT_RDWR)
+		return this->_fail(EINVAL);
+	if (!peer && !e->eof)
+		return this->_fail(ENOTCONN);
+	if (how != SHUT_WR)
+		e->shut_rd = true;
+	if (how != SHUT_RD) {
+		e->shut_wr = true;
+		if (peer)
+			peer->eof = true;
+	}
+	return 0;
+}
+
+int							nw::sim_network::_fcntl(int fd, int cmd, int arg) {
+	endpoint	*e = this->_get(fd);
+
+	if (cmd == F_GETFL)
+		return O_RDWR | e->flags;
+	if (cmd != F_SETFL)
+		return this->_fail(EINVAL);
+	e->flags = arg & O_NONBLOCK;
+	return 0;
+}
+
+//! @details Only SO_ERROR and SO_TYPE are known, other options are set without effect.
+int							nw::sim_network::_getsockopt(int fd, int level, int name, void *value, socklen_t *len) {
+	int32_t	v;
+
+	if (level != SOL_SOCKET || (name != SO_ERROR && name != SO_TYPE) || *len < sizeof(v))
+		return this->_fail(ENOPROTOOPT);
+	if (name == SO_TYPE)
+		v = SOCK_STREAM;
+	else
+		v = (this->_get(fd)->reset) ? ECONNRESET : 0;
+	std::memcpy(value, &v, sizeof(v));
+	*len = sizeof(v);
+	return 0;
+}
+
+ssize_t						nw::sim_network::_send(int fd, const struct iovec *iov, size_t iovcnt) {
+	endpoint	*e = this->_get(fd);
+	endpoint	*peer = this->_get(e->peer);
+
+	if (e->reset)
+		return this->_fail(ECONNRESET);
+	if (e->shut_wr || (!peer && e->eof))
+		return this->_fail(EPIPE);
+	if (!peer)
+		return this->_fail(ENOTCONN);
+	if (this->_inject(*e))
+		return this->_fail(EAGAIN);
+	if (e->faults.reset_after && e->sent >= e->faults.reset_after) {
+		this->_reset(*e);
+		return this->_fail(ECONNRESET);
+	}
+
+	size_type	size = 0;
+
+	for (size_t i = 0; i != iovcnt; ++i)
+		size += iov[i].iov_len;
+	size = std::min(size, this->_capacity - peer->len);
+	if (e->faults.max_write)
+		size = std::min(size, e->faults.max_write);
+	if (e->faults.reset_after)
+		size = std::min<size_type>(size, e->faults.reset_after - e->sent);
+	if (!size && peer->len == this->_capacity)
+		return this->_fail(EAGAIN);
+
+	size_type	done = 0;
+
+	for (size_t i = 0; done != size; ++i) {
+		const uint8_t	*src = static_cast<const uint8_t *>(iov[i].iov_base);
+		size_type		n = std::min(size - done, iov[i].iov_len);
+
+		while (n) {
+			const size_type	tail = (peer->head + peer->len) % this->_capacity;
+			const size_type	chunk = std::min(n, this->_capacity - tail);
+
+			std::memcpy(&peer->rx[tail], src, chunk);
+			peer->len += chunk;
+			src += chunk;
+			done += chunk;
+			n -= chunk;
+		}
+	}
+	e->sent += size;
+	this->_stats.bytes += size;
+	return static_cast<ssize_t>(size);
+}
+
+ssize_t						nw::sim_network::_recv(int fd, const struct iovec *iov, size_t iovcnt, int flags) {
+	endpoint	*e = this->_get(fd);
+
+	if (e->reset)
+		return this->_fail(ECONNRESET);
+	if (e->listening)
+		return this->_fail(ENOTCONN);
+	if (this->_inject(*e))
+		return this->_fail(EAGAIN);
+	if (!e->len) {
+		if (e->eof || e->shut_rd)
+			return 0;
+		return this->_fail((e->peer == -1) ? ENOTCONN : EAGAIN);
+	}
+
+	size_type	size = 0;
+
+	for (size_t i = 0; i != iovcnt; ++i)
+		size += iov[i].iov_len;
+	size = std::min(size, e->len);
+	if (e->faults.max_read)
+		size = std::min(size, e->faults.max_read);
+
+	size_type	head = e->head;
+	size_type	done = 0;
+
+	for (size_t i = 0; done != size; ++i) {
+		uint8_t		*dst = static_cast<uint8_t *>(iov[i].iov_base);
+		size_type	n = std::min(size - done, iov[i].iov_len);
+
+		while (n) {
+			const size_type	chunk = std::min(n, this->_capacity - head);
+
+			std::memcpy(dst, &e->rx[head], chunk);
+			head = (head + chunk) % this->_capacity;
+			dst += chunk;
+			done += chunk;
+			n -= chunk;
+		}
+	}
+	if (!(flags & MSG_PEEK)) {
+		e->head = head;
+		e->len -= size;
+	}
+	return static_cast<ssize_t>(size);
+}
+
+//! @details Simulated sockets are polled without blocking, the others are forwarded to the saved nw::transport with
+//! timeout 0 if a simulated socket is ready. Without other file descriptors, timeout is ignored: no event can occur.
+int							nw::sim_network::_poll(struct pollfd *fds, nfds_t nfds, int timeout) {
+	bool	forward = false;
+	int		ready = 0;
+
+	for (nfds_t i = 0; i != nfds; ++i) {
+		const endpoint	*e = this->_get(fds[i].fd);
+
+		if (!e) {
+			forward |= fds[i].fd >= 0;
+			continue ;
+		}
+		++this->_stats.calls;
+		fds[i].revents = this->_revents(*e) & (fds[i].events | POLLERR | POLLHUP);
+		ready += (fds[i].revents != 0);
+	}
+	if (!forward)
+		return ready;
+
+	std::vector<struct pollfd>	others(fds, fds + nfds);
+
+	for (nfds_t i = 0; i != nfds; ++i) {
+		if (this->_get(fds[i].fd))
+			others[i].fd = -1;
+	}
+
+	const int	ret = this->_saved.poll(others.data(), nfds, (ready) ? 0 : timeout);
+
+	if (ret == -1)
+		return -1;
+	for (nfds_t i = 0; i != nfds; ++i) {
+		if (!this->_get(fds[i].fd))
+			fds[i].revents = others[i].revents;
+	}
+	return ready + ret;
+}
+
+const std::string			nw::sim_stats::to_string(void) const {
+	return format_string([this](formatter &f){
+		f.begin_object();
+		f.key("calls").value(this->calls);
+		f.key("bytes").value(this->bytes);
+		f.key("would_block").value(this->would_block);
+		f.key("resets").value(this->resets);
+		f.end_object();
+	});
+}
+
+const std::string			nw::sim_network::to_string(void) const {
+	return format_string([this](formatter &f){
+		f.begin_object();
+		f.key("installed").value(this->_installed);
+		f.key("sockets").value(static_cast<uint64_t>(this->_endpoints.size() - this->_free.size()));
+		f.key("capacity").value(static_cast<uint64_t>(this->_capacity));
+		f.key("calls").value(this->_stats.calls);
+		f.key("bytes").value(this->_stats.bytes);
+		f.key("would_block").value(this->_stats.would_block);
+		f.key("resets").value(this->_stats.resets);
+		f.end_object();
+	});
+}
+
+std::ostream &				operator<<(std::ostream &o, const nw::sim_stats &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &				operator<<(std::ostream &o, const nw::sim_network &C) {
+	o << C.to_string();
+	return (o);
+}
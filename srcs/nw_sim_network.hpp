@@ -0,0 +1,147 @@
+#ifndef __NW_SIM_NETWORK_HPP__
+# define __NW_SIM_NETWORK_HPP__
+
+/*!
+@file nw_sim_network.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <vector>
+# include <map>
+# include <deque>
+# include <memory>
+
+# include "nw_typedef.hpp"
+# include "nw_transport.hpp"
+
+namespace nw {
+	//! @brief Faults injected on the calls of one nw::sim_network socket, a zero field disables its fault
+	struct	sim_faults {
+		size_type	max_write;		//!< bytes accepted per send at most: partial writes
+		size_type	max_read;		//!< bytes returned per receive at most: short reads
+		uint32_t	eagain_every;	//!< every nth send or receive fails with EAGAIN
+		uint64_t	reset_after;	//!< bytes sent before the connection is reset, ECONNRESET on both ends
+	};
+
+	//! @brief nw::sim_network counters, accumulated since construction
+	struct	sim_stats {
+		uint64_t	calls;			//!< calls handled by the backend
+		uint64_t	bytes;			//!< bytes moved between sockets
+		uint64_t	would_block;	//!< calls failed with EAGAIN, injected or not
+		uint64_t	resets;			//!< connections reset
+
+		const std::string	to_string(void) const;
+	};
+
+	//! @brief In-process network backend for nw::socket, deterministic and without the kernel
+	//! @details
+	//! Once installed, sockets created by nw::socket are simulated: connected ones exchange bytes through in-memory
+	//! queues and nw::socket::connect queues the connection on the listener bound to the same address, accepted at
+	//! once. Calls on other file descriptors are forwarded to the previous nw::transport, simulated file descriptors
+	//! start at FD_BASE.
+	//!
+	//! Only nw::sock_type::STREAM sockets are simulated. Every call returns at once: a call that would block fails
+	//! with EAGAIN whether the socket is non-blocking or not. poll(2) reports the simulated sockets readiness without
+	//! blocking, nothing changes it while the caller waits, and polls the other file descriptors; simulated sockets can
+	//! not be registered in a nw::poller. Socket options are set without effect, only SO_ERROR and SO_TYPE can be read.
+	//! nw::io_ring submissions and nw::packet_ring mappings reach the kernel directly, they do not accept simulated
+	//! sockets. The backend is used by a single thread.
+	class sim_network {
+		public:
+			static const sockfd_type	FD_BASE = 1 << 24;
+
+			//! @brief Constructor
+			explicit sim_network(
+				const size_type &capacity = 65536	//!< receive queue size of each socket, in bytes
+			);
+
+			//! @brief Destructor, uninstall the backend if installed
+			virtual	~sim_network(void);
+
+			//! @brief Route nw::socket calls to the backend
+			//! @throw nw::logic_error if a nw::sim_network is already installed
+			void	install(void);
+
+			//! @brief Restore the nw::transport replaced by nw::sim_network::install
+			void	uninstall(void);
+
+			//! @brief Set the faults injected on the calls of fd
+			//! @throw nw::logic_error if fd is not a simulated socket
+			void	set_faults(const sockfd_type &fd, const sim_faults &faults);
+
+			//! @return bytes queued for reception on fd
+			//! @throw nw::logic_error if fd is not a simulated socket
+			size_type	readable(const sockfd_type &fd) const;
+
+			const sim_stats &	get_stats(void) const;
+
+			const std::string	to_string(void) const;
+
+		protected:
+			struct	endpoint {
+				int32_t					flags;		//!< file status flags, O_NONBLOCK only
+				sockfd_type				peer;		//!< connected socket, -1 if none
+				std::string				name;		//!< bound address, sockaddr bytes
+				bool					listening;
+				size_type				backlog;
+				std::deque<sockfd_type>	pending;	//!< connections to accept
+				bool					eof;		//!< no more bytes will be queued
+				bool					shut_rd;
+				bool					shut_wr;
+				bool					reset;
+				std::vector<uint8_t>	rx;			//!< receive queue, a ring of capacity bytes
+				size_type				head;
+				size_type				len;
+				sim_faults				faults;
+				uint64_t				sent;
+				uint64_t				calls;		//!< sends and receives, for sim_faults::eagain_every
+			};
+
+			const size_type							_capacity;
+			std::vector<std::unique_ptr<endpoint> >	_endpoints;	//!< indexed by fd - FD_BASE
+			std::vector<sockfd_type>				_free;		//!< closed file descriptors, reused first
+			std::map<std::string, sockfd_type>		_bound;
+			transport								_saved;
+			bool									_installed;
+			sim_stats								_stats;
+
+			static sim_network	*_s_installed;
+
+			bool		_owns(const sockfd_type &fd);
+			endpoint *	_get(const sockfd_type &fd) const;
+			sockfd_type	_open(const int32_t &flags);
+			void		_link(const sockfd_type &a, const sockfd_type &b);
+			int			_fail(const int32_t &error);
+			bool		_inject(endpoint &e);
+			void		_reset(endpoint &e);
+			int16_t		_revents(const endpoint &e) const;
+
+			int			_socket(int domain, int type, int protocol);
+			int			_socketpair(int domain, int type, int protocol, int *fds);
+			int			_bind(int fd, const struct sockaddr *addr, socklen_t len);
+			int			_listen(int fd, int backlog);
+			int			_connect(int fd, const struct sockaddr *addr, socklen_t len);
+			int			_accept(int fd, struct sockaddr *addr, socklen_t *len);
+			int			_close(int fd);
+			int			_shutdown(int fd, int how);
+			int			_fcntl(int fd, int cmd, int arg);
+			int			_getsockopt(int fd, int level, int name, void *value, socklen_t *len);
+			ssize_t		_send(int fd, const struct iovec *iov, size_t iovcnt);
+			ssize_t		_recv(int fd, const struct iovec *iov, size_t iovcnt, int flags);
+			int			_poll(struct pollfd *fds, nfds_t nfds, int timeout);
+
+		private:
+			sim_network(const sim_network &src) = delete;
+			sim_network(sim_network &&src) = delete;
+
+			sim_network &	operator=(const sim_network &src) = delete;
+			sim_network &	operator=(sim_network &&src) = delete;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::sim_stats &C);
+std::ostream &	operator<<(std::ostream &o, const nw::sim_network &C);
+
+#endif
@@ -0,0 +1,416 @@
+#ifndef __NW_SLIM_ADDR_HPP__
+# define __NW_SLIM_ADDR_HPP__
+
+/*!
+@file nw_slim_addr.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <cstring>
+# include <functional>
+# include <type_traits>
+
+# include "nw_typedef.hpp"
+# include "nw_addr.hpp"
+
+namespace nw {
+	//! @tparam FAMILY ::sa_family
+	template <sa_family FAMILY>
+	//! @brief Trivially copyable address value, sized to its family
+	//! @details
+	//! Unlike nw::addr, a slim_addr has no vtable nor self reference and holds the family sockaddr only: it is meant
+	//! for large peer tables and hashing. It converts from and to nw::addr for the rest of the API (bind, connect).
+	class slim_addr {
+		private:
+			slim_addr(void) = delete;
+	};
+
+	//! @brief Mix a 64 bits value into a hash (splitmix64 finalizer)
+	inline uint64_t	_slim_addr_mix(uint64_t h) {
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+		return h ^ (h >> 31);
+	}
+
+	template <>
+	//! IPv4 slim_addr specialization, 16 bytes
+	class slim_addr<sa_family::INET> {
+		public:
+			//! @brief type is struct sockaddr_in
+			typedef struct sockaddr_in	type;
+
+			//! @brief Default constructor, 0.0.0.0 port 0
+			slim_addr(void) : _struct() {
+				this->_struct.sin_family = AF_INET;
+			}
+
+			//! @brief Construct from port and address
+			//! @throw nw::logic_error if inet_aton(3) function fail's
+			slim_addr(
+				const port_type		&port,					//!< port
+				const std::string	&ipv4_addr = "0.0.0.0"	//!< IPv4 address
+			) : slim_addr() {
+				this->_struct.sin_port = htons(port);
+				if (!inet_aton(ipv4_addr.c_str(), &this->_struct.sin_addr))
+					throw logic_error("inet_aton: invalid address");
+			}
+
+			//! @brief Construct from nw::slim_addr::type
+			slim_addr(
+				const type &sa_in	//!< struct sockaddr_in
+			) : _struct(sa_in) {}
+
+			//! @brief Construct from nw::sa_family::INET nw::addr
+			slim_addr(
+				const addr<sa_family::INET> &src	//!< nw::sa_family::INET nw::addr
+			) : _struct(src._struct) {}
+
+			//! @brief Convert to nw::sa_family::INET nw::addr
+			operator addr<sa_family::INET>(void) const {
+				return addr<sa_family::INET>(this->_struct);
+			}
+
+			inline sa_family			get_family(void) const {
+				return sa_family::INET;
+			}
+
+			inline port_type			get_port(void) const {
+				return ntohs(this->_struct.sin_port);
+			}
+
+			inline const type &			get_ref(void) const {
+				return this->_struct;
+			}
+
+			//! @brief sockaddr pointer for system calls
+			inline const struct sockaddr *	data(void) const {
+				return reinterpret_cast<const struct sockaddr *>(&this->_struct);
+			}
+
+			//! @brief sockaddr length for system calls
+			inline socklen_type			size(void) const {
+				return sizeof(type);
+			}
+
+			inline bool					operator==(const slim_addr &rhs) const {
+				return this->_struct.sin_port == rhs._struct.sin_port && this->_struct.sin_addr.s_addr == rhs._struct.sin_addr.s_addr;
+			}
+
+			inline bool					operator!=(const slim_addr &rhs) const {
+				return !(*this == rhs);
+			}
+
+			inline bool					operator<(const slim_addr &rhs) const {
+				return this->_key() < rhs._key();
+			}
+
+			inline size_type			hash(void) const {
+				return static_cast<size_type>(_slim_addr_mix(this->_key()));
+			}
+
+			const std::string			to_string(void) const {
+				return static_cast<addr<sa_family::INET> >(*this).to_string();
+			}
+
+			//! @brief Write addr data to a nw::formatter, without allocation
+			void						format(formatter &f) const {
+				static_cast<addr<sa_family::INET> >(*this).format(f);
+			}
+
+		protected:
+			type	_struct;
+
+			//! @brief Address and port in host order, ordering addresses first
+			inline uint64_t	_key(void) const {
+				return (static_cast<uint64_t>(ntohl(this->_struct.sin_addr.s_addr)) << 16) | ntohs(this->_struct.sin_port);
+			}
+	};
+
+	template <>
+	//! IPv6 slim_addr specialization, 28 bytes
+	class slim_addr<sa_family::INET6> {
+		public:
+			//! @brief type is struct sockaddr_in6
+			typedef struct sockaddr_in6	type;
+
+			//! @brief Default constructor, :: port 0
+			slim_addr(void) : _struct() {
+				this->_struct.sin6_family = AF_INET6;
+			}
+
+			//! @brief Construct from port, address, flowinfo and scope_id
+			//! @throw nw::logic_error if inet_pton(3) function fail's
+			slim_addr(
+				const port_type		&port,				//!< port
+				const std::string	&ipv6_addr = "::",	//!< IPv6 address
+				uint32_t			flowinfo = 0,		//!< IPv6 flow info
+				uint32_t			scope_id = 0		//!< IPv6 scope id
+			) : slim_addr() {
+				this->_struct.sin6_port = htons(port);
+				this->_struct.sin6_flowinfo = htonl(flowinfo);
+				this->_struct.sin6_scope_id = htonl(scope_id);
+				if (inet_pton(AF_INET6, ipv6_addr.c_str(), &this->_struct.sin6_addr) != 1)
+					throw logic_error("inet_pton: invalid address");
+			}
+
+			//! @brief Construct from nw::slim_addr::type
+			slim_addr(
+				const type &sa_in6	//!< struct sockaddr_in6
+			) : _struct(sa_in6) {}
+
+			//! @brief Construct from nw::sa_family::INET6 nw::addr
+			slim_addr(
+				const addr<sa_family::INET6> &src	//!< nw::sa_family::INET6 nw::addr
+			) : _struct(src._struct) {}
+
+			//! @brief Convert to nw::sa_family::INET6 nw::addr
+			operator addr<sa_family::INET6>(void) const {
+				return addr<sa_family::INET6>(this->_struct);
+			}
+
+			inline sa_family			get_family(void) const {
+				return sa_family::INET6;
+			}
+
+			inline port_type			get_port(void) const {
+				return ntohs(this->_struct.sin6_port);
+			}
+
+			inline const type &			get_ref(void) const {
+				return this->_struct;
+			}
+
+			//! @brief sockaddr pointer for system calls
+			inline const struct sockaddr *	data(void) const {
+				return reinterpret_cast<const struct sockaddr *>(&this->_struct);
+			}
+
+			//! @brief sockaddr length for system calls
+			inline socklen_type			size(void) const {
+				return sizeof(type);
+			}
+
+			//! @brief Compare address, port and scope id, flow info is ignored
+			inline bool					operator==(const slim_addr &rhs) const {
+				return this->_struct.sin6_port == rhs._struct.sin6_port && this->_struct.sin6_scope_id == rhs._struct.sin6_scope_id \
+					&& !std::memcmp(&this->_struct.sin6_addr, &rhs._struct.sin6_addr, sizeof(this->_struct.sin6_addr));
+			}
+
+			inline bool					operator!=(const slim_addr &rhs) const {
+				return !(*this == rhs);
+			}
+
+			inline bool					operator<(const slim_addr &rhs) const {
+				const int	cmp = std::memcmp(&this->_struct.sin6_addr, &rhs._struct.sin6_addr, sizeof(this->_struct.sin6_addr));
+
+				if (cmp)
+					return cmp < 0;
+				if (this->_struct.sin6_port != rhs._struct.sin6_port)
+					return ntohs(this->_struct.sin6_port) < ntohs(rhs._struct.sin6_port);
+				return ntohl(this->_struct.sin6_scope_id) < ntohl(rhs._struct.sin6_scope_id);
+			}
+
+			inline size_type			hash(void) const {
+				uint64_t	words[2];
+
+				std::memcpy(words, &this->_struct.sin6_addr, sizeof(words));
+				return static_cast<size_type>(_slim_addr_mix(words[0] ^ _slim_addr_mix(words[1] \
+					^ (static_cast<uint64_t>(this->_struct.sin6_port) << 32) ^ this->_struct.sin6_scope_id)));
+			}
+
+			const std::string			to_string(void) const {
+				return static_cast<addr<sa_family::INET6> >(*this).to_string();
+			}
+
+			//! @brief Write addr data to a nw::formatter, without allocation
+			void						format(formatter &f) const {
+				static_cast<addr<sa_family::INET6> >(*this).format(f);
+			}
+
+		protected:
+			type	_struct;
+	};
+
+	template <>
+	//! Unspecified IP slim_addr specialization, IPv4 or IPv6 tagged by the family, 28 bytes
+	class slim_addr<sa_family::UNSPEC> {
+		public:
+			//! @brief Default constructor, AF_UNSPEC
+			slim_addr(void) : _u() {
+				this->_u.family = AF_UNSPEC;
+			}
+
+			//! @brief Construct from IPv4 slim_addr
+			slim_addr(
+				const slim_addr<sa_family::INET> &src	//!< nw::sa_family::INET nw::slim_addr
+			) : _u() {
+				this->_u.in = src.get_ref();
+			}
+
+			//! @brief Construct from IPv6 slim_addr
+			slim_addr(
+				const slim_addr<sa_family::INET6> &src	//!< nw::sa_family::INET6 nw::slim_addr
+			) : _u() {
+				this->_u.in6 = src.get_ref();
+			}
+
+			//! @brief Construct from nw::sa_family::UNSPEC nw::addr
+			//! @throw nw::logic_error if src holds neither an IPv4 nor an IPv6 address
+			slim_addr(
+				const addr<sa_family::UNSPEC> &src	//!< nw::sa_family::UNSPEC nw::addr
+			) : _u() {
+				switch (src.get_family()) {
+					case sa_family::UNSPEC:
+						this->_u.family = AF_UNSPEC;
+						break ;
+					case sa_family::INET:
+						std::memcpy(&this->_u.in, &src._struct, sizeof(this->_u.in));
+						break ;
+					case sa_family::INET6:
+						std::memcpy(&this->_u.in6, &src._struct, sizeof(this->_u.in6));
+						break ;
+					default:
+						throw logic_error("slim_addr: unsupported family");
+				}
+			}
+
+			//! @brief Convert to nw::sa_family::UNSPEC nw::addr
+			operator addr<sa_family::UNSPEC>(void) const {
+				addr<sa_family::UNSPEC>::type	storage = {};
+
+				std::memcpy(&storage, &this->_u, sizeof(this->_u));
+				return addr<sa_family::UNSPEC>(storage);
+			}
+
+			inline sa_family			get_family(void) const {
+				return static_cast<sa_family>(this->_u.family);
+			}
+
+			//! @brief Port, 0 for AF_UNSPEC
+			inline port_type			get_port(void) const {
+				switch (this->get_family()) {
+					case sa_family::INET:
+						return ntohs(this->_u.in.sin_port);
+					case sa_family::INET6:
+						return ntohs(this->_u.in6.sin6_port);
+					default:
+						return 0;
+				}
+			}
+
+			//! @brief IPv4 address
+			//! @throw nw::logic_error if the address is not IPv4
+			slim_addr<sa_family::INET>	get_inet(void) const {
+				if (this->get_family() != sa_family::INET)
+					throw logic_error("slim_addr: not an IPv4 address");
+				return slim_addr<sa_family::INET>(this->_u.in);
+			}
+
+			//! @brief IPv6 address
+			//! @throw nw::logic_error if the address is not IPv6
+			slim_addr<sa_family::INET6>	get_inet6(void) const {
+				if (this->get_family() != sa_family::INET6)
+					throw logic_error("slim_addr: not an IPv6 address");
+				return slim_addr<sa_family::INET6>(this->_u.in6);
+			}
+
+			//! @brief sockaddr pointer for system calls
+			inline const struct sockaddr *	data(void) const {
+				return &this->_u.sa;
+			}
+
+			//! @brief sockaddr length for system calls, 0 for AF_UNSPEC
+			inline socklen_type			size(void) const {
+				switch (this->get_family()) {
+					case sa_family::INET:
+						return sizeof(this->_u.in);
+					case sa_family::INET6:
+						return sizeof(this->_u.in6);
+					default:
+						return 0;
+				}
+			}
+
+			inline bool					operator==(const slim_addr &rhs) const {
+				if (this->get_family() != rhs.get_family())
+					return false;
+				switch (this->get_family()) {
+					case sa_family::INET:
+						return this->get_inet() == rhs.get_inet();
+					case sa_family::INET6:
+						return this->get_inet6() == rhs.get_inet6();
+					default:
+						return true;
+				}
+			}
+
+			inline bool					operator!=(const slim_addr &rhs) const {
+				return !(*this == rhs);
+			}
+
+			//! @brief Order by family, then by address
+			inline bool					operator<(const slim_addr &rhs) const {
+				if (this->get_family() != rhs.get_family())
+					return this->_u.family < rhs._u.family;
+				switch (this->get_family()) {
+					case sa_family::INET:
+						return this->get_inet() < rhs.get_inet();
+					case sa_family::INET6:
+						return this->get_inet6() < rhs.get_inet6();
+					default:
+						return false;
+				}
+			}
+
+			inline size_type			hash(void) const {
+				switch (this->get_family()) {
+					case sa_family::INET:
+						return this->get_inet().hash();
+					case sa_family::INET6:
+						return this->get_inet6().hash();
+					default:
+						return 0;
+				}
+			}
+
+			const std::string			to_string(void) const {
+				return static_cast<addr<sa_family::UNSPEC> >(*this).to_string();
+			}
+
+			//! @brief Write addr data to a nw::formatter, without allocation
+			void						format(formatter &f) const {
+				static_cast<addr<sa_family::UNSPEC> >(*this).format(f);
+			}
+
+		protected:
+			union {
+				sa_family_t			family;
+				struct sockaddr		sa;
+				struct sockaddr_in	in;
+				struct sockaddr_in6	in6;
+			}	_u;
+	};
+
+	static_assert(std::is_trivially_copyable<slim_addr<sa_family::INET> >::value && sizeof(slim_addr<sa_family::INET>) == 16, "slim_addr<INET> layout");
+	static_assert(std::is_trivially_copyable<slim_addr<sa_family::INET6> >::value && sizeof(slim_addr<sa_family::INET6>) == 28, "slim_addr<INET6> layout");
+	static_assert(std::is_trivially_copyable<slim_addr<sa_family::UNSPEC> >::value && sizeof(slim_addr<sa_family::UNSPEC>) == 28, "slim_addr<UNSPEC> layout");
+};
+
+namespace std {
+	template <nw::sa_family FAMILY>
+	struct	hash<nw::slim_addr<FAMILY> > {
+		size_t	operator()(const nw::slim_addr<FAMILY> &a) const {
+			return a.hash();
+		}
+	};
+};
+
+template <nw::sa_family FAMILY>
+std::ostream &	operator<<(std::ostream &o, const nw::slim_addr<FAMILY> &C) {
+	o << C.to_string();
+	return o;
+}
+
+#endif
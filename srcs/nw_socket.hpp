@@ -10,28 +10,54 @@
 # include <ostream>
 # include <string>
 # include <functional>
+# include <utility>
+
+# include <algorithm>
+# include <cstring>
 
 # include <sys/socket.h>
+# include <netinet/udp.h>
+# include <netinet/tcp.h>
+# include <net/if.h>
 # include <unistd.h>
-
-static const std::function<int(int, int, int)>								_s_socket = &socket;
-static const std::function<int(int, const struct sockaddr *, socklen_t)>	_s_bind = &bind;
-static const std::function<int(int, int)>									_s_listen = &listen;
-static const std::function<int(int, const struct sockaddr *, socklen_t)>	_s_connect = &connect;
-static const std::function<int(int, struct sockaddr *, socklen_t *)>		_s_accept = &accept;
-static const std::function<int(int)>										_s_close = &close;
-static const std::function<ssize_t(int, void *, size_t, int)>				_s_send = &send;
+# include <fcntl.h>
+
+# include "nw_transport.hpp"
+
+static const std::function<int(int, int, int)> &								_s_socket = nw::transport::current.socket;
+static const std::function<int(int, int, int, int *)> &						_s_socketpair = nw::transport::current.socketpair;
+static const std::function<int(int, const struct sockaddr *, socklen_t)> &	_s_bind = nw::transport::current.bind;
+static const std::function<int(int, int)> &									_s_listen = nw::transport::current.listen;
+static const std::function<int(int, const struct sockaddr *, socklen_t)> &	_s_connect = nw::transport::current.connect;
+static const std::function<int(int, struct sockaddr *, socklen_t *)> &		_s_accept = nw::transport::current.accept;
+static const std::function<int(int)> &										_s_close = nw::transport::current.close;
+static const std::function<int(int, int)> &									_s_shutdown = nw::transport::current.shutdown;
+static const std::function<int(int, int, int)> &								_s_fcntl = nw::transport::current.fcntl;
+static const std::function<int(int, int, int, void *, socklen_t *)> &			_s_getsockopt = nw::transport::current.getsockopt;
+static const std::function<int(int, int, int, const void *, socklen_t)> &		_s_setsockopt = nw::transport::current.setsockopt;
+static const std::function<ssize_t(int, void *, size_t, int)> &				_s_send = nw::transport::current.send;
 static const std::function<ssize_t(int, void *, size_t, int, \
-		const struct sockaddr *dest_addr, socklen_t addrlen)>				_s_sendto = &sendto;
-static const std::function<ssize_t(int, const struct msghdr *, int)>		_s_sendmsg = &sendmsg;
-static const std::function<ssize_t(int, void *, size_t, int)>				_s_recv = &recv;
+		const struct sockaddr *dest_addr, socklen_t addrlen)> &				_s_sendto = nw::transport::current.sendto;
+static const std::function<ssize_t(int, const struct msghdr *, int)> &		_s_sendmsg = nw::transport::current.sendmsg;
+static const std::function<ssize_t(int, void *, size_t, int)> &				_s_recv = nw::transport::current.recv;
 static const std::function<ssize_t(int, void *, size_t, int, \
-		struct sockaddr *dest_addr, socklen_t *addrlen)>					_s_recvfrom = &recvfrom;
-static const std::function<ssize_t(int, struct msghdr *, int)>				_s_recvmsg = &recvmsg;
+		struct sockaddr *dest_addr, socklen_t *addrlen)> &					_s_recvfrom = nw::transport::current.recvfrom;
+static const std::function<ssize_t(int, struct msghdr *, int)> &				_s_recvmsg = nw::transport::current.recvmsg;
+static const std::function<int(int, struct mmsghdr *, unsigned int, \
+		int, struct timespec *)> &											_s_recvmmsg = nw::transport::current.recvmmsg;
+static const std::function<int(int, struct mmsghdr *, unsigned int, int)> &	_s_sendmmsg = nw::transport::current.sendmmsg;
 
 # include "nw_typedef.hpp"
 # include "nw_protoent.hpp"
 # include "nw_addr.hpp"
+# include "nw_poller.hpp"
+# include "nw_tcp_info.hpp"
+# include "nw_histogram.hpp"
+# include "nw_io_stats.hpp"
+# include "nw_timestamping.hpp"
+# include "nw_bpf.hpp"
+# include "nw_datagram_batch.hpp"
+# include "nw_record_batch.hpp"
 //# include "nw_addrinfo.hpp"
 //# include "nw_sockopt.hpp"
 
@@ -39,6 +65,15 @@ static const std::function<ssize_t(int, struct msghdr *, int)>				_s_recvmsg = &
 # include "buffer/nw_obuffer.hpp"
 
 namespace nw {
+	//! @brief nw::socket::send write coalescing counters
+	struct	flush_stats {
+		uint64_t	sends;		//!< nw::socket::send calls
+		uint64_t	flushes;	//!< nw::socket::flush calls
+		uint64_t	syscalls;	//!< send(2), sendmsg(2) and cork setsockopt(2) issued
+		uint64_t	bytes;		//!< bytes sent
+		uint64_t	packets;	//!< segments sent by the kernel (tcpi_segs_out), 0 if not a TCP socket
+	};
+
 	//! @tparam FAMILY nw::sa_family
 	template <sa_family FAMILY>
 	//! @brief Protected socket storage class
@@ -49,9 +84,14 @@ namespace nw {
 			const protoent		_proto;
 			const sockfd_type	_fd;
 			addr<FAMILY>		_addr;
+			io_counters			_io;
+			uint64_t			_tx_bytes = 0;	//!< bytes sent since SOF_TIMESTAMPING_OPT_ID was enabled
+			uint64_t			_tx_sends = 0;	//!< sends since SOF_TIMESTAMPING_OPT_ID was enabled
+			uint32_t			_ts_flags = 0;	//!< SO_TIMESTAMPING flags set by nw::socket::set_timestamping
 
 			socket_storage(socket_storage &&src) \
-				: _type(src._type), _proto(src._proto), _fd(src._fd), _addr(src._addr) {
+				: _type(src._type), _proto(src._proto), _fd(src._fd), _addr(src._addr), _io(src._io), _tx_bytes(src._tx_bytes), _tx_sends(src._tx_sends), \
+				_ts_flags(src._ts_flags) {
 				*const_cast<sockfd_type *>(&src._fd) = -1;
 			}
 
@@ -76,18 +116,97 @@ namespace nw {
 				*const_cast<sockfd_type *>(&this->_fd) = -1;
 			}
 
-			virtual const std::string	to_string(void) const {
-				std::string	str;
+			const sockfd_type &	get_fd(void) const {
+				return this->_fd;
+			}
+
+			void	set_nonblocking(const bool &nonblocking) {
+				int32_t	flags = _s_fcntl(this->_fd, F_GETFL, 0);
+
+				if (flags == -1)
+					throw system_error(errno, std::generic_category(), "fcntl");
+				flags = (nonblocking) ? flags | O_NONBLOCK : flags & ~O_NONBLOCK;
+				if (_s_fcntl(this->_fd, F_SETFL, flags) == -1)
+					throw system_error(errno, std::generic_category(), "fcntl");
+			}
+
+			int32_t	get_error(void) const {
+				int32_t			error = 0;
+				socklen_type	len = sizeof(error);
+
+				if (_s_getsockopt(this->_fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1)
+					throw system_error(errno, std::generic_category(), "getsockopt");
+				return error;
+			}
+
+			//! @brief Count a system call in socket and process wide counters, errno is preserved
+			template <typename R>
+			R	_count_call(const R &ret) {
+				this->_io.add(io_counter::SYSCALLS);
+				global_io_counters::add(io_counter::SYSCALLS);
+				if (ret != -1)
+					return ret;
+				if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS) {
+					this->_io.add(io_counter::WOULD_BLOCK);
+					global_io_counters::add(io_counter::WOULD_BLOCK);
+				} else {
+					this->_io.error(errno);
+					global_io_counters::error(errno);
+				}
+				return ret;
+			}
+
+			//! @brief Count a data transfer system call offered size bytes, errno is preserved
+			ssize_t	_count_io(const ssize_t &ret, const size_type &size, const bool &in) {
+				this->_count_call(ret);
+				if (ret <= 0)
+					return ret;
+				if (!in) {
+					this->_tx_bytes += ret;
+					++this->_tx_sends;
+				}
+				this->_io.add((in) ? io_counter::BYTES_IN : io_counter::BYTES_OUT, ret);
+				global_io_counters::add((in) ? io_counter::BYTES_IN : io_counter::BYTES_OUT, ret);
+				if (static_cast<size_type>(ret) < size) {
+					this->_io.add((in) ? io_counter::SHORT_READS : io_counter::SHORT_WRITES);
+					global_io_counters::add((in) ? io_counter::SHORT_READS : io_counter::SHORT_WRITES);
+				}
+				return ret;
+			}
+
+			static size_type	_iov_size(const struct iovec *iov, const size_type &iovcnt) {
+				size_type	size = 0;
+
+				for (size_type i = 0; i != iovcnt; ++i)
+					size += iov[i].iov_len;
+				return size;
+			}
 
-				str = "{ \"family\": \"" + sa_family_str(FAMILY) + "\", ";
-				str += "\"fd\": \"" + std::to_string(this->_fd) + "\", ";
-				str += "\"type\": \"" + sock_type_str(this->_type) + "\", ";
-				str += "\"protocol\": " + this->_proto.to_string() + ", ";
-				str += "\"address\": " + this->_addr.to_string() + "}";
+			//! @throw nw::system_error with ETIMEDOUT if deadline expire before events
+			//! @throw nw::system_error if the socket is in error
+			void	wait(const uint32_t &events, const time_point &deadline, const char *what) const {
+				if (!nw::wait(this->_fd, events, deadline, what))
+					throw system_error(ETIMEDOUT, std::generic_category(), what);
+			}
 
-				return str;
+			virtual const std::string	to_string(void) const {
+				return format_string([this](formatter &f){ this->format(f); }, 1024);
 			};
 
+			virtual void				format(formatter &f) const {
+				f.begin_object();
+				f.key("family").value(sa_family_name(FAMILY));
+				f.key("fd").value(this->_fd);
+				f.key("type").value(sock_type_name(this->_type));
+				f.key("protocol");
+				this->_proto.format(f);
+				f.key("address");
+				this->_addr.format(f);
+				f.key("io");
+				this->_io.snapshot().format(f);
+				f.end_object();
+			}
+
 			virtual	~socket_storage(void) {}
 
 			template <sa_family>
@@ -138,7 +257,11 @@ namespace nw {
 			//! @brief Move constructor
 			socket(
 				socket<FAMILY, TYPE> &&src	//!< nw::socket
-			) : socket_storage<FAMILY>(std::move(src)) {}
+			) : socket_storage<FAMILY>(std::move(src)), _flush_policy(src._flush_policy), _more_pending(src._more_pending), _flush_stats(src._flush_stats), _truncated(src._truncated) {
+# ifdef NW_LATENCY_HISTOGRAMS
+				this->_latency = src._latency;
+# endif
+			}
 
 			//! @brief Unspecified address family socket move constructor
 			socket(
@@ -154,6 +277,20 @@ namespace nw {
 				this->close(std::nothrow);
 			}
 
+			//! @brief Create a pair of connected nw::sa_family::LOCAL sockets
+			//! @return std::pair of connected nw::socket
+			//! @throw nw::system_error if socketpair(2) function fail's
+			static std::pair<socket, socket>	pair(
+				const protoent &proto = 0	//!< nw::protoent
+			) {
+				static_assert(FAMILY == sa_family::LOCAL, "socketpair requires a nw::sa_family::LOCAL socket");
+				sockfd_type	fds[2];
+
+				if (_s_socketpair(static_cast<int32_t>(FAMILY), static_cast<int32_t>(TYPE), proto._struct->p_proto, fds) == -1)
+					throw system_error(errno, std::generic_category(), "socketpair");
+				return std::pair<socket, socket>(socket(proto, fds[0], addr<FAMILY>()), socket(proto, fds[1], addr<FAMILY>()));
+			}
+
 			//! @brief Marks the socket as a passive socket, that is, as a socket that will be used to accept incoming connection requests using nw::socket::accept.
 			//!
 			//! @throw nw::system_error if listen(2) function fail's
@@ -189,11 +326,64 @@ namespace nw {
 			void	connect(
 				const addr<FAMILY> &addr	//!< nw::addr
 			) {
-				if (_s_connect(this->_fd, reinterpret_cast<const sockaddr *>(&addr._struct), addr._sizeof) == -1)
+				NW_LATENCY_SCOPE(this->_latency.connect);
+
+				if (this->_count_call(_s_connect(this->_fd, reinterpret_cast<const sockaddr *>(&addr._struct), addr._sizeof)) == -1)
 					throw system_error(errno, std::generic_category(), "connect");
 				this->_addr = addr;
 			}
 
+			//! @brief Connects the socket to the address specified by addr with no throw behavior.
+			//! @details
+			//! On a non-blocking socket (see nw::socket::set_nonblocking) EINPROGRESS is returned while the connection is being established,
+			//! completion is signaled by writability and its result by nw::socket::get_error.
+			//!
+			//! @return 0 on success, errno value of connect(2) otherwise
+			int32_t	connect(
+				const addr<FAMILY> &addr,	//!< nw::addr
+				std::nothrow_t
+			) {
+				NW_LATENCY_SCOPE(this->_latency.connect);
+				return this->_connect(addr);
+			}
+
+			//! @brief Connects the socket to the address specified by addr before deadline.
+			//! @details
+			//! The connection is started non-blocking, its completion is awaited as writability until deadline and its result read from SO_ERROR.
+			//! The O_NONBLOCK file status flag is restored on return.
+			//!
+			//! @throw nw::system_error with ETIMEDOUT if deadline expire
+			//! @throw nw::system_error if connect(2) function or the connection fail's
+			void	connect(
+				const addr<FAMILY> &addr,		//!< nw::addr
+				const time_point &deadline		//!< nw::time_point
+			) {
+				NW_LATENCY_SCOPE(this->_latency.connect);
+
+				int32_t	flags = _s_fcntl(this->_fd, F_GETFL, 0);
+
+				if (flags == -1)
+					throw system_error(errno, std::generic_category(), "fcntl");
+				if (!(flags & O_NONBLOCK))
+					this->set_nonblocking(true);
+				try {
+					int32_t	error = this->_connect(addr);
+
+					if (error == EINPROGRESS) {
+						socket_storage<FAMILY>::wait(poller::OUT, deadline, "connect");
+						error = this->get_error();
+					}
+					if (error)
+						throw system_error(error, std::generic_category(), "connect");
+				} catch (...) {
+					if (!(flags & O_NONBLOCK))
+						this->set_nonblocking(false);
+					throw ;
+				}
+				if (!(flags & O_NONBLOCK))
+					this->set_nonblocking(false);
+			}
+
 			//! @brief Connects the socket to the address specified by addr.
 			//! @details
 			//! Call to nw::socket<FAMILY, TYPE>::connect(const addr<FAMILY> &addr)
@@ -230,13 +420,15 @@ namespace nw {
 			//! @throw nw::system_error if accept(2) function fail's
 			//! @throw nw::logic_error if connected socket come from unsupported address family
 			socket<FAMILY, TYPE> accept(void) {
+				NW_LATENCY_SCOPE(this->_latency.accept);
+
 				sockfd_type					fd;
-				typename addr<FAMILY>::type	addr_struct;
+				typename addr<FAMILY>::type	addr_struct = {};
 				socklen_type				addr_len	= sizeof(addr_struct);
 
-				if ((fd = _s_accept(this->_fd, reinterpret_cast<struct sockaddr *>(&addr_struct), &addr_len)) == -1)
+				if ((fd = this->_accept(addr_struct, addr_len)) == -1)
 					throw system_error(errno, std::generic_category(), "accept");
-				return socket<FAMILY, TYPE>(this->_proto, fd, *reinterpret_cast<typename addr<FAMILY>::type *>(&addr_struct));
+				return this->_accepted(fd, addr_struct, addr_len);
 			}
 
 			//! @brief Close the socket.
@@ -250,33 +442,340 @@ namespace nw {
 				socket_storage<FAMILY>::close(std::nothrow);
 			}
 
+			//! @brief Shut down part of a full-duplex connection, waking up threads blocked in nw::socket::recv.
+			//! @throw nw::system_error if shutdown(2) function fail's
+			void	shutdown(
+				const int32_t &how	//!< SHUT_RD, SHUT_WR or SHUT_RDWR
+			) {
+				if (_s_shutdown(this->_fd, how) == -1)
+					throw system_error(errno, std::generic_category(), "shutdown");
+			}
+
+			//! @brief Return the socket file descriptor
+			const sockfd_type &	get_fd(void) const {
+				return socket_storage<FAMILY>::get_fd();
+			}
+
+			//! @brief Set or clear O_NONBLOCK file status flag
+			//! @throw nw::system_error if fcntl(2) function fail's
+			void	set_nonblocking(
+				const bool &nonblocking	//!< true to set, false to clear
+			) {
+				socket_storage<FAMILY>::set_nonblocking(nonblocking);
+			}
+
+			//! @brief Get and clear the pending socket error (SO_ERROR)
+			//! @return errno value, 0 if no error is pending
+			//! @throw nw::system_error if getsockopt(2) function fail's
+			int32_t	get_error(void) const {
+				return socket_storage<FAMILY>::get_error();
+			}
+
+			//! @brief Set the minimum number of bytes to receive before the socket is readable or a blocking receive returns (SO_RCVLOWAT)
+			//! @details
+			//! Fewer wakeups for protocols with known message sizes: set bytes to the size of the next expected message, or to
+			//! the free space left below the high watermark of the receive nw::ibuffer.
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_recv_lowat(
+				const int32_t &bytes	//!< minimum readable bytes, 1 by default
+			) {
+				if (_s_setsockopt(this->_fd, SOL_SOCKET, SO_RCVLOWAT, &bytes, sizeof(bytes)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			//! @brief Set the maximum number of unsent bytes below which the socket is writable (TCP_NOTSENT_LOWAT)
+			//! @details
+			//! Keeps data queued in user space, in the send nw::obuffer where its watermarks apply, instead of in the kernel
+			//! send buffer: writable means the peer is keeping up, not only that send buffer space is left.
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_notsent_lowat(
+				const uint32_t &bytes	//!< unsent bytes limit
+			) {
+				static_assert(TYPE == sock_type::STREAM, "TCP_NOTSENT_LOWAT requires a nw::sock_type::STREAM socket");
+				if (_s_setsockopt(this->_fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &bytes, sizeof(bytes)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			//! @brief Send small segments without waiting for outstanding data to be acknowledged (TCP_NODELAY)
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_nodelay(
+				const bool &enable	//!< true to disable Nagle's algorithm
+			) {
+				static_assert(TYPE == sock_type::STREAM, "TCP_NODELAY requires a nw::sock_type::STREAM socket");
+				int32_t	value = enable;
+
+				if (_s_setsockopt(this->_fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			//! @brief Busy poll the device queue for up to usec microseconds on a blocking receive or an empty poll (SO_BUSY_POLL)
+			//! @details Raising it above net.core.busy_read requires CAP_NET_ADMIN.
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_busy_poll(
+				const int32_t &usec	//!< busy poll duration, 0 to disable
+			) {
+				if (_s_setsockopt(this->_fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			//! @brief Allow binding an address still held by connections in TIME_WAIT (SO_REUSEADDR), must be set before nw::socket::bind
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_reuseaddr(
+				const bool &enable	//!< true to enable
+			) {
+				int32_t	value = enable;
+
+				if (_s_setsockopt(this->_fd, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			//! @brief Allow several sockets to bind the same address and port (SO_REUSEPORT), must be set before nw::socket::bind
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_reuseport(
+				const bool &enable	//!< true to enable
+			) {
+				int32_t	value = enable;
+
+				if (_s_setsockopt(this->_fd, SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			//! @brief Drop packets not accepted by prog in the kernel, see nw::bpf_program::attach
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	attach_filter(
+				const bpf_program &prog	//!< nw::bpf_program, nw::bpf_filter::compile
+			) {
+				prog.attach(this->_fd);
+			}
+
+			//! @brief Remove the packet filter, see nw::bpf_program::detach
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	detach_filter(void) {
+				bpf_program::detach(this->_fd);
+			}
+
+			//! @brief Select the socket of the SO_REUSEPORT group receiving each packet with prog, see nw::bpf_program::attach_reuseport
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	attach_reuseport_filter(
+				const bpf_program &prog	//!< nw::bpf_program, nw::bpf_program::reuseport_cpu
+			) {
+				prog.attach_reuseport(this->_fd);
+			}
+
+			//! @brief Return a snapshot of the socket I/O counters, see nw::global_io_counters::snapshot for process wide counters
+			io_stats	get_io_stats(void) const {
+				return this->_io.snapshot();
+			}
+
+			//! @brief Clear the socket I/O counters
+			void	reset_io_stats(void) {
+				this->_io.reset();
+			}
+
 			//! @brief Return a json formated std::string containing socket data
 			//! @return json formated std::string
 			const std::string	to_string(void) const {
 				return socket_storage<FAMILY>::to_string();
 			}
 
+			//! @brief Write socket data to a nw::formatter, without allocation
+			void	format(formatter &f) const {
+				socket_storage<FAMILY>::format(f);
+			}
+
 			//! @tparam TYPE nw::size_type
 			template <size_type SIZE>
 			//! @brief Transmit a message to another socket.
 			//! @details
 			//! The send() call may be used only with an connected socket.
 			//!
+			//! Write coalescing is driven by nw::flush_policy (see nw::socket::set_flush_policy): with nw::flush_policy::BATCH no system call
+			//! is issued until buf is half full, pending data must then be sent by nw::socket::flush.
+			//!
 			//! @throw nw::system_error if send(2) function fail's
 			size_type	send(
 				obuffer<SIZE> &buf,	//!< nw::obuffer<SIZE>
 				int flags = 0		//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 send.
 			) {
-				const sockfd_type	fd = this->_fd;
+				const size_type	ret = this->send(buf, flags, std::nothrow);
 
-				return buf.sync([fd, flags](void *buf, size_type size){
-					ssize_t	ret = _s_send(fd, buf, size, flags);
-					if (ret == -1)
-						throw system_error(errno, std::generic_category(), "send");
+				if (ret == npos)
+					throw system_error(errno, std::generic_category(), "send");
+				return ret;
+			}
+
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Transmit a message to another socket with no throw behavior.
+			//! @details
+			//! Same as nw::socket::send, on a non-blocking socket EAGAIN is reported while the send buffer is full.
+			//!
+			//! @return number of bytes sent, nw::npos if send(2) function fail's with errno set
+			size_type	send(
+				obuffer<SIZE> &buf,	//!< nw::obuffer<SIZE>
+				int flags,			//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 send.
+				std::nothrow_t
+			) {
+				NW_LATENCY_SCOPE(this->_latency.send);
+
+				const sockfd_type	fd = this->_fd;
+				flush_stats			&stats = this->_flush_stats;
+
+				++stats.sends;
+				if (this->_flush_policy == flush_policy::BATCH && buf.in_avail() < buf.size() / 2)
+					return 0;
+				if (this->_flush_policy == flush_policy::BATCH || this->_flush_policy == flush_policy::MORE) {
+					flags |= MSG_MORE;
+					this->_more_pending = true;
+				}
+				return buf.sync([this, fd, flags, &stats](void *buf, size_type size){
+					++stats.syscalls;
+					ssize_t	ret = this->_count_io(_s_send(fd, buf, size, flags), size, false);
+					if (ret != -1)
+						stats.bytes += ret;
 					return ret;
 				});
 			}
 
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief End the message: send every pending data and push partial frames held by the nw::flush_policy.
+			//! @details
+			//! To be called at end of message or once per event loop iteration for every socket written to.
+			//! Pending data is sent with sendmsg(2) without MSG_MORE, with nw::flush_policy::CORK the cork is released and set again.
+			//!
+			//! @return number of bytes sent
+			//! @throw nw::system_error if sendmsg(2) or setsockopt(2) function fail's
+			size_type	flush(
+				obuffer<SIZE> &buf,	//!< nw::obuffer<SIZE>
+				int flags = 0		//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 send.
+			) {
+				NW_LATENCY_SCOPE(this->_latency.send);
+
+				const sockfd_type	fd = this->_fd;
+				flush_stats			&stats = this->_flush_stats;
+				size_type			total = 0;
+
+				++stats.flushes;
+				while (!buf.is_empty()) {
+					size_type	ret = buf.syncv([this, fd, flags, &stats](struct iovec *iov, size_type iovcnt){
+						struct msghdr	msg = {};
+
+						msg.msg_iov = iov;
+						msg.msg_iovlen = iovcnt;
+						++stats.syscalls;
+						ssize_t	ret = this->_count_io(_s_sendmsg(fd, &msg, flags & ~MSG_MORE), socket_storage<FAMILY>::_iov_size(iov, iovcnt), false);
+						if (ret == -1)
+							throw system_error(errno, std::generic_category(), "sendmsg");
+						stats.bytes += ret;
+						return ret;
+					});
+					if (!ret || ret == npos)
+						break ;
+					total += ret;
+				}
+				if (this->_flush_policy == flush_policy::CORK) {
+					this->_set_cork(false);
+					this->_set_cork(true);
+				} else if (this->_more_pending && !total && CORKABLE)
+					this->_set_cork(false);
+				this->_more_pending = false;
+				return total;
+			}
+
+			//! @brief Set the write coalescing policy of nw::socket::send, nw::flush_policy::IMMEDIATE by default
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			//! @throw nw::logic_error if policy is nw::flush_policy::CORK and the socket is not an internet STREAM or DGRAM socket
+			void	set_flush_policy(
+				const flush_policy &policy	//!< nw::flush_policy
+			) {
+				if (policy == this->_flush_policy)
+					return ;
+				if (policy == flush_policy::CORK && !CORKABLE)
+					throw logic_error("set_flush_policy: CORK requires an internet STREAM or DGRAM socket");
+				if (this->_flush_policy == flush_policy::CORK || (this->_more_pending && CORKABLE))
+					this->_set_cork(false);
+				if (policy == flush_policy::CORK)
+					this->_set_cork(true);
+				this->_flush_policy = policy;
+				this->_more_pending = false;
+			}
+
+			//! @brief Return the write coalescing policy
+			const flush_policy &	get_flush_policy(void) const {
+				return this->_flush_policy;
+			}
+
+			//! @brief Return write coalescing counters
+			//! @details packets is read from TCP_INFO on nw::sock_type::STREAM sockets.
+			//! @throw nw::system_error if getsockopt(2) function fail's
+			flush_stats	get_flush_stats(void) const {
+				flush_stats	stats = this->_flush_stats;
+
+				stats.packets = 0;
+				if (TYPE == sock_type::STREAM && (FAMILY == sa_family::INET || FAMILY == sa_family::INET6))
+					stats.packets = this->_tcp_info().tcpi_segs_out;
+				return stats;
+			}
+
+			//! @brief Return a TCP_INFO snapshot of the connection: rtt, cwnd, retransmits, delivery rate, unacked segments...
+			//! @details See nw::tcp_info_sampler to sample every connection of a listener.
+			//! @throw nw::system_error if getsockopt(2) function fail's
+			tcp_info_struct	get_tcp_info(void) const {
+				static_assert(TYPE == sock_type::STREAM && (FAMILY == sa_family::INET || FAMILY == sa_family::INET6), "TCP_INFO requires a nw::sock_type::STREAM internet socket");
+				return this->_tcp_info();
+			}
+
+# ifdef NW_LATENCY_HISTOGRAMS
+			//! @brief Return send, recv, accept and connect latency histograms
+			//! @details
+			//! Only built with NW_LATENCY_HISTOGRAMS defined. Every call to a send, flush, recv, accept or connect method records its
+			//! duration, waits included, flush and deadline bounded variants are recorded as send, recv or connect.
+			const socket_latency &	get_latency(void) const {
+				return this->_latency;
+			}
+
+			//! @brief Clear latency histograms
+			void	reset_latency(void) {
+				this->_latency.reset();
+			}
+# endif
+
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Transmit a message to another socket before deadline.
+			//! @details
+			//! send(2) is issued with MSG_DONTWAIT and writability awaited until deadline while it would block.
+			//!
+			//! @throw nw::system_error with ETIMEDOUT if deadline expire
+			//! @throw nw::system_error if send(2) function fail's
+			size_type	send(
+				obuffer<SIZE> &buf,				//!< nw::obuffer<SIZE>
+				const time_point &deadline,		//!< nw::time_point
+				int flags = 0					//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 send.
+			) {
+				NW_LATENCY_SCOPE(this->_latency.send);
+
+				const sockfd_type	fd = this->_fd;
+
+				while (true) {
+					bool		would_block = false;
+					size_type	ret = buf.sync([this, fd, flags, &would_block](void *buf, size_type size){
+						ssize_t	ret = this->_count_io(_s_send(fd, buf, size, flags | MSG_DONTWAIT), size, false);
+						if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+							would_block = true;
+							return static_cast<ssize_t>(0);
+						}
+						if (ret == -1)
+							throw system_error(errno, std::generic_category(), "send");
+						return ret;
+					});
+					if (!would_block)
+						return ret;
+					socket_storage<FAMILY>::wait(poller::OUT, deadline, "send");
+				}
+			}
+
 			//! @tparam TYPE nw::size_type
 			template <size_type SIZE>
 			//! @brief Transmit a message to another socket.
@@ -303,23 +802,34 @@ namespace nw {
 				const addr<FAMILY> &addr,	//!< nw::addr<FAMILY>
 				int flags = 0				//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 send.
 			) {
+				NW_LATENCY_SCOPE(this->_latency.send);
+
 				const sockfd_type	fd = this->_fd;
 
-				return buf.sync([fd, flags, &addr](void *buf, size_type size){
-					size_t	ret = _s_sendto(fd, buf, size, flags, &addr._struct, sizeof(nw::addr<FAMILY>::type));
+				return buf.sync([this, fd, flags, &addr](void *buf, size_type size){
+					ssize_t	ret = this->_count_io(_s_sendto(fd, buf, size, flags, reinterpret_cast<const sockaddr *>(&addr._struct), addr._sizeof), size, false);
 					if (ret == -1)
 						throw system_error(errno, std::generic_category(), "sendto");
 					return ret;
 				});
 			}
 
+			//! @brief Transmit a message to another socket.
+			//! @details
+			//! The sendmsg() call can transmit scattered data and ancillary data (control messages), see man 2 sendmsg and man 3 cmsg.
+			//!
+			//! @throw nw::system_error if sendmsg(2) function fail's
 			size_type	send(
-				struct msghdr msg,
-				int flags
+				const struct msghdr &msg,	//!< struct msghdr
+				int flags = 0				//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 send.
 			) {
-				static_cast<void>(msg);
-				static_cast<void>(flags);
-				//sendmsg
+				NW_LATENCY_SCOPE(this->_latency.send);
+
+				ssize_t	ret = this->_count_io(_s_sendmsg(this->_fd, &msg, flags), socket_storage<FAMILY>::_iov_size(msg.msg_iov, msg.msg_iovlen), false);
+
+				if (ret == -1)
+					throw system_error(errno, std::generic_category(), "sendmsg");
+				return ret;
 			}
 
 			//! @tparam TYPE nw::size_type
@@ -333,16 +843,73 @@ namespace nw {
 				ibuffer<SIZE> &buf,		//!< nw::ibuffer<SIZE>
 				int flags = 0			//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recv.
 			) {
+				const size_type	ret = this->recv(buf, flags, std::nothrow);
+
+				if (ret == npos)
+					throw system_error(errno, std::generic_category(), "recv");
+				return ret;
+			}
+
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Receive a message from another socket with no throw behavior.
+			//! @details
+			//! Same as nw::socket::recv, on a non-blocking socket EAGAIN is reported while no data is available.
+			//!
+			//! @return number of bytes received, nw::npos if recv(2) function fail's with errno set
+			size_type	recv(
+				ibuffer<SIZE> &buf,		//!< nw::ibuffer<SIZE>
+				int flags,				//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recv.
+				std::nothrow_t
+			) {
+				NW_LATENCY_SCOPE(this->_latency.recv);
+				if (buf.is_full())
+					this->_io.add(io_counter::BUFFER_FULL);
+
 				const sockfd_type	fd = this->_fd;
 
-				return buf.sync([fd, flags](void *buf, size_type size){
-					ssize_t	ret = _s_recv(fd, buf, size, flags);
-					if (ret == -1)
-						throw system_error(errno, std::generic_category(), "recv");
-					return ret;
+				return buf.sync([this, fd, flags](void *buf, size_type size){
+					return this->_count_io(_s_recv(fd, buf, size, flags), size, true);
 				});
 			}
 
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Receive a message from another socket before deadline.
+			//! @details
+			//! recv(2) is issued with MSG_DONTWAIT and readability awaited until deadline while it would block.
+			//!
+			//! @throw nw::system_error with ETIMEDOUT if deadline expire
+			//! @throw nw::system_error if recv(2) function fail's
+			size_type	recv(
+				ibuffer<SIZE> &buf,				//!< nw::ibuffer<SIZE>
+				const time_point &deadline,		//!< nw::time_point
+				int flags = 0					//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recv.
+			) {
+				NW_LATENCY_SCOPE(this->_latency.recv);
+				if (buf.is_full())
+					this->_io.add(io_counter::BUFFER_FULL);
+
+				const sockfd_type	fd = this->_fd;
+
+				while (true) {
+					bool		would_block = false;
+					size_type	ret = buf.sync([this, fd, flags, &would_block](void *buf, size_type size){
+						ssize_t	ret = this->_count_io(_s_recv(fd, buf, size, flags | MSG_DONTWAIT), size, true);
+						if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+							would_block = true;
+							return static_cast<ssize_t>(0);
+						}
+						if (ret == -1)
+							throw system_error(errno, std::generic_category(), "recv");
+						return ret;
+					});
+					if (!would_block)
+						return ret;
+					socket_storage<FAMILY>::wait(poller::IN, deadline, "recv");
+				}
+			}
+
 			//! @tparam TYPE nw::size_type
 			template <size_type SIZE>
 			//! @brief Receive a message from another socket.
@@ -367,38 +934,627 @@ namespace nw {
 			//! @throw nw::system_error if sendto(2) function fail's
 			size_type	recv(
 				ibuffer<SIZE> &buf,			//!< nw::ibuffer<SIZE>
-				const addr<FAMILY> &addr,	//!< nw::addr<FAMILY>
+				addr<FAMILY> &addr,			//!< nw::addr<FAMILY>
 				int flags = 0				//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recv.
 			) {
-				typename nw::addr<FAMILY>::type	sa;
-				socklen_type					sa_len = sizeof(nw::addr<FAMILY>::type);
+				NW_LATENCY_SCOPE(this->_latency.recv);
+				if (buf.is_full())
+					this->_io.add(io_counter::BUFFER_FULL);
+
+				typename nw::addr<FAMILY>::type	sa = {};
+				socklen_type					sa_len = sizeof(sa);
 
 				size_type ret = buf.sync([this, flags, &sa, &sa_len](void *buf, size_type size){
-					ssize_t	ret = _s_recvfrom(this->_fd, buf, size, flags, &sa, &sa_len);
+					ssize_t	ret = this->_count_io(_s_recvfrom(this->_fd, buf, size, flags, reinterpret_cast<sockaddr *>(&sa), &sa_len), size, true);
 					if (ret == -1)
 						throw system_error(errno, std::generic_category(), "recvfrom");
 					return ret;
 				});
 				addr = nw::addr<FAMILY>(sa);
+				const_cast<socklen_type &>(addr._sizeof) = sa_len;
+				return ret;
+			}
+
+			//! @brief Receive a message from another socket.
+			//! @details
+			//! The recvmsg() call can receive scattered data and ancillary data (control messages), msg.msg_flags and msg.msg_controllen are updated on return.
+			//!
+			//! @throw nw::system_error if recvmsg(2) function fail's
+			size_type	recv(
+				struct msghdr &msg,		//!< struct msghdr
+				int flags = 0			//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recv.
+			) {
+				NW_LATENCY_SCOPE(this->_latency.recv);
+
+				ssize_t	ret = this->_count_io(_s_recvmsg(this->_fd, &msg, flags), socket_storage<FAMILY>::_iov_size(msg.msg_iov, msg.msg_iovlen), true);
+
+				if (ret == -1)
+					throw system_error(errno, std::generic_category(), "recvmsg");
+				return ret;
+			}
+
+			//! @brief Enable kernel timestamping (SO_TIMESTAMPING) of received and transmitted data.
+			//! @details
+			//! Receive timestamps are read along the data with nw::socket::recv_timestamped, transmit timestamps from the socket error queue
+			//! with nw::socket::recv_tx_timestamps. With SOF_TIMESTAMPING_OPT_ID, transmit timestamps carry the nw::socket::get_tx_id of their send,
+			//! counted from the call that enabled it: as the kernel key, ids are kept by calls leaving it enabled. SOF_TIMESTAMPING_TX_ACK is
+			//! dropped on other than nw::sock_type::STREAM sockets. Hardware timestamps also require the device to be configured (SIOCSHWTSTAMP).
+			//!
+			//! The kernel accepts SOF_TIMESTAMPING_OPT_ID (in TIMESTAMPING_DEFAULT) on a nw::sock_type::STREAM socket once it is connected
+			//! only: call after connect or accept.
+			//!
+			//! @throw nw::system_error if setsockopt(2) function fail's, EINVAL for SOF_TIMESTAMPING_OPT_ID on a STREAM socket not connected
+			void	set_timestamping(
+				const uint32_t &flags = TIMESTAMPING_DEFAULT	//!< SOF_TIMESTAMPING_* flags, 0 to disable
+			) {
+				int32_t	value = static_cast<int32_t>((TYPE == sock_type::STREAM) ? flags : flags & ~SOF_TIMESTAMPING_TX_ACK);
+
+				if (_s_setsockopt(this->_fd, SOL_SOCKET, SO_TIMESTAMPING, &value, sizeof(value)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+				if ((flags & SOF_TIMESTAMPING_OPT_ID) && !(this->_ts_flags & SOF_TIMESTAMPING_OPT_ID)) {
+					this->_tx_bytes = 0;
+					this->_tx_sends = 0;
+				}
+				this->_ts_flags = static_cast<uint32_t>(value);
+			}
+
+			//! @brief Return the id transmit timestamps of the last send carry
+			//! @details
+			//! For nw::sock_type::STREAM the offset of its last byte, otherwise its index, since SOF_TIMESTAMPING_OPT_ID was enabled.
+			//! A send issued with UDP_SEGMENT counts once, the kernel reports it once.
+			uint32_t	get_tx_id(void) const {
+				return static_cast<uint32_t>(((TYPE == sock_type::STREAM) ? this->_tx_bytes : this->_tx_sends) - 1);
+			}
+
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Receive a message from another socket with its kernel timestamps.
+			//! @details
+			//! On datagram sockets ts are the timestamps of the received datagram, on nw::sock_type::STREAM sockets those of the
+			//! last segment read. Timestamps not taken, or all if timestamping is disabled, are zeroed.
+			//!
+			//! @throw nw::system_error if recvmsg(2) function fail's
+			size_type	recv_timestamped(
+				ibuffer<SIZE> &buf,		//!< nw::ibuffer<SIZE>
+				rx_timestamp &ts,		//!< set to the kernel timestamps
+				int flags = 0			//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recv.
+			) {
+				NW_LATENCY_SCOPE(this->_latency.recv);
+				if (buf.is_full())
+					this->_io.add(io_counter::BUFFER_FULL);
+
+				const sockfd_type	fd = this->_fd;
+
+				ts = rx_timestamp();
+				return buf.syncv([this, fd, flags, &ts](struct iovec *iov, size_type iovcnt){
+					char			control[CMSG_SPACE(sizeof(struct scm_timestamping)) + CMSG_SPACE(sizeof(struct timespec))] = {0};
+					struct msghdr	msg = {};
+
+					msg.msg_iov = iov;
+					msg.msg_iovlen = iovcnt;
+					msg.msg_control = control;
+					msg.msg_controllen = sizeof(control);
+
+					ssize_t	ret = this->_count_io(_s_recvmsg(fd, &msg, flags), socket_storage<FAMILY>::_iov_size(iov, iovcnt), true);
+					if (ret == -1)
+						throw system_error(errno, std::generic_category(), "recvmsg");
+					for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+						if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING)
+							_timestamps(cmsg, ts.software, ts.hardware);
+					}
+					return ret;
+				});
+			}
+
+			//! @brief Read every pending transmit timestamp from the socket error queue (MSG_ERRQUEUE).
+			//! @details
+			//! fct is called in order with each timestamp. The error queue is readable (nw::poller::ERR) while timestamps are pending.
+			//!
+			//! @return number of timestamps read
+			//! @throw nw::system_error if recvmsg(2) function fail's
+			size_type	recv_tx_timestamps(
+				const std::function<void(const tx_timestamp &)> &fct	//!< called with each transmit timestamp
+			) {
+				size_type	count = 0;
+
+				while (true) {
+					char			control[CMSG_SPACE(sizeof(struct scm_timestamping)) + CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))] = {0};
+					struct msghdr	msg = {};
+					tx_timestamp	ts = {};
+					bool			found = false;
+
+					msg.msg_control = control;
+					msg.msg_controllen = sizeof(control);
+					if (_s_recvmsg(this->_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+						if (errno == EAGAIN || errno == EWOULDBLOCK)
+							return count;
+						throw system_error(errno, std::generic_category(), "recvmsg");
+					}
+					for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+						if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING)
+							_timestamps(cmsg, ts.software, ts.hardware);
+						else if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+							struct sock_extended_err	err;
+
+							std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+							if (err.ee_errno == ENOMSG && err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+								ts.id = err.ee_data;
+								ts.type = static_cast<tstamp_type>(err.ee_info);
+								found = true;
+							}
+						}
+					}
+					if (found) {
+						fct(ts);
+						++count;
+					}
+				}
+			}
+
+			//! @brief Enable or disable UDP generic receive offload (UDP_GRO).
+			//! @details
+			//! Once enabled, consecutive datagrams of a flow may be coalesced by the kernel and must be read with nw::socket::recv_gro.
+			//!
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_gro(
+				const bool &enable	//!< true to enable
+			) {
+				static_assert(TYPE == sock_type::DGRAM, "UDP_GRO requires a nw::sock_type::DGRAM socket");
+				int32_t	value = enable;
+
+				if (_s_setsockopt(this->_fd, SOL_UDP, UDP_GRO, &value, sizeof(value)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Transmit pending data as datagrams of segment_size bytes with a single sendmsg(2) (UDP_SEGMENT).
+			//! @details
+			//! The kernel, or the NIC, split the super-buffer in segment_size datagrams, the last one may be shorter.
+			//! At most 64 datagrams and 64KiB are sent per call, remaining data stays in buf.
+			//!
+			//! @throw nw::system_error if sendmsg(2) function fail's
+			//! @throw nw::logic_error if segment_size is null or does not fit in a datagram
+			size_type	send_gso(
+				obuffer<SIZE> &buf,				//!< nw::obuffer<SIZE>
+				const uint16_t &segment_size,	//!< datagram size
+				int flags = 0					//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 send.
+			) {
+				return this->_send_gso(buf, nullptr, 0, segment_size, flags);
+			}
+
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Transmit pending data as datagrams of segment_size bytes to addr with a single sendmsg(2) (UDP_SEGMENT).
+			//! @details
+			//! Call to nw::socket<FAMILY, TYPE>::send_gso(obuffer<SIZE> &buf, const uint16_t &segment_size, int flags = 0) with a destination address.
+			//!
+			//! @throw nw::system_error if sendmsg(2) function fail's
+			//! @throw nw::logic_error if segment_size is null or does not fit in a datagram
+			size_type	send_gso(
+				obuffer<SIZE> &buf,				//!< nw::obuffer<SIZE>
+				const addr<FAMILY> &addr,		//!< nw::addr<FAMILY>
+				const uint16_t &segment_size,	//!< datagram size
+				int flags = 0					//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 send.
+			) {
+				return this->_send_gso(buf, &addr._struct, addr._sizeof, segment_size, flags);
+			}
+
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Receive a datagram or a GRO super-packet.
+			//! @details
+			//! segment_size is set from the UDP_GRO control message: datagram i is the bytes [i * segment_size, (i + 1) * segment_size) of the received data,
+			//! the last one may be shorter. Without control message a single datagram was received and segment_size is its size.
+			//! buf should have 64KiB of free space: data not fitting is dropped by the kernel, the received part is kept in buf and
+			//! nw::socket::truncated returns true.
+			//!
+			//! @throw nw::system_error if recvmsg(2) function fail's
+			size_type	recv_gro(
+				ibuffer<SIZE> &buf,			//!< nw::ibuffer<SIZE>
+				uint16_t &segment_size,		//!< set to datagram size
+				int flags = 0				//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recv.
+			) {
+				static_assert(TYPE == sock_type::DGRAM, "UDP_GRO requires a nw::sock_type::DGRAM socket");
+				NW_LATENCY_SCOPE(this->_latency.recv);
+				if (buf.is_full())
+					this->_io.add(io_counter::BUFFER_FULL);
+
+				const sockfd_type	fd = this->_fd;
+
+				segment_size = 0;
+				this->_truncated = false;
+				return buf.syncv([this, fd, flags, &segment_size](struct iovec *iov, size_type iovcnt){
+					char			control[CMSG_SPACE(sizeof(int32_t))] = {0};
+					struct msghdr	msg = {};
+
+					msg.msg_iov = iov;
+					msg.msg_iovlen = iovcnt;
+					msg.msg_control = control;
+					msg.msg_controllen = sizeof(control);
+
+					ssize_t	ret = this->_count_io(_s_recvmsg(fd, &msg, flags), socket_storage<FAMILY>::_iov_size(iov, iovcnt), true);
+					if (ret == -1)
+						throw system_error(errno, std::generic_category(), "recvmsg");
+					this->_truncated = msg.msg_flags & MSG_TRUNC;
+					segment_size = static_cast<uint16_t>(ret);
+					for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+						if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+							int32_t	gso_size;
+
+							std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+							segment_size = static_cast<uint16_t>(gso_size);
+						}
+					}
+					return ret;
+				});
+			}
+
+			//! @tparam TYPE nw::size_type
+			template <size_type SIZE>
+			//! @brief Receive a datagram or a GRO super-packet, split in datagrams.
+			//! @details
+			//! fct is called in order with the size of every received datagram, which data can be read from buf.
+			//! If nw::socket::truncated returns true the last one was cut.
+			//!
+			//! @throw nw::system_error if recvmsg(2) function fail's
+			size_type	recv_gro(
+				ibuffer<SIZE> &buf,							//!< nw::ibuffer<SIZE>
+				const std::function<void(size_type)> &fct,	//!< called with each datagram size
+				int flags = 0								//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recv.
+			) {
+				uint16_t	segment_size;
+				size_type	ret = this->recv_gro(buf, segment_size, flags);
+
+				if (ret == npos || !segment_size)
+					return ret;
+				for (size_type off = 0; off < ret; off += segment_size)
+					fct(std::min<size_type>(segment_size, ret - off));
 				return ret;
 			}
 
-			size_type recv(
-				struct msghdr msg,
-				int flags
+			//! @brief Return true if the data of the last nw::socket::recv_gro did not fit in the buffer and was cut (MSG_TRUNC)
+			bool	truncated(void) const {
+				return this->_truncated;
+			}
+
+			//! @brief Join the multicast group on interface ifname (MCAST_JOIN_GROUP)
+			//! @details The socket should be bound to the group port, on the wildcard or the group address.
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			//! @throw nw::logic_error if ifname is not an interface name
+			void	join_group(
+				const addr<FAMILY> &group,			//!< multicast group address, port ignored
+				const std::string &ifname = ""		//!< interface name, empty to let the kernel choose
+			) {
+				this->_group_req(MCAST_JOIN_GROUP, group, ifname);
+			}
+
+			//! @brief Leave a group joined by nw::socket::join_group (MCAST_LEAVE_GROUP)
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			//! @throw nw::logic_error if ifname is not an interface name
+			void	leave_group(
+				const addr<FAMILY> &group,			//!< multicast group address, port ignored
+				const std::string &ifname = ""		//!< interface name given to nw::socket::join_group
+			) {
+				this->_group_req(MCAST_LEAVE_GROUP, group, ifname);
+			}
+
+			//! @brief Join the source-specific multicast channel (source, group) on interface ifname (MCAST_JOIN_SOURCE_GROUP)
+			//! @details May be called once per source of a group to receive from several sources.
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			//! @throw nw::logic_error if ifname is not an interface name
+			void	join_source_group(
+				const addr<FAMILY> &group,			//!< multicast group address, port ignored
+				const addr<FAMILY> &source,			//!< source address, port ignored
+				const std::string &ifname = ""		//!< interface name, empty to let the kernel choose
+			) {
+				this->_group_source_req(MCAST_JOIN_SOURCE_GROUP, group, source, ifname);
+			}
+
+			//! @brief Leave a channel joined by nw::socket::join_source_group (MCAST_LEAVE_SOURCE_GROUP)
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			//! @throw nw::logic_error if ifname is not an interface name
+			void	leave_source_group(
+				const addr<FAMILY> &group,			//!< multicast group address, port ignored
+				const addr<FAMILY> &source,			//!< source address, port ignored
+				const std::string &ifname = ""		//!< interface name given to nw::socket::join_source_group
 			) {
-				static_cast<void>(msg);
-				static_cast<void>(flags);
-				//recvmsg
+				this->_group_source_req(MCAST_LEAVE_SOURCE_GROUP, group, source, ifname);
+			}
+
+			//! @brief Enable or disable the loop back of sent multicast datagrams to local members (IP_MULTICAST_LOOP, IPV6_MULTICAST_LOOP)
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_multicast_loop(
+				const bool &enable	//!< true to enable, the kernel default
+			) {
+				this->_ip_option((FAMILY == sa_family::INET) ? IP_MULTICAST_LOOP : IPV6_MULTICAST_LOOP, enable);
+			}
+
+			//! @brief Set the time to live of sent multicast datagrams (IP_MULTICAST_TTL, IPV6_MULTICAST_HOPS)
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_multicast_ttl(
+				const uint8_t &ttl	//!< hop limit, 1 by default to stay on the local network
+			) {
+				this->_ip_option((FAMILY == sa_family::INET) ? IP_MULTICAST_TTL : IPV6_MULTICAST_HOPS, ttl);
+			}
+
+			//! @brief Set the interface sent multicast datagrams leave from (IP_MULTICAST_IF, IPV6_MULTICAST_IF)
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			//! @throw nw::logic_error if ifname is not an interface name
+			void	set_multicast_interface(
+				const std::string &ifname	//!< interface name, empty to let the kernel choose
+			) {
+				const int32_t	ifindex = static_cast<int32_t>(_ifindex(ifname));
+
+				if (FAMILY == sa_family::INET) {
+					struct ip_mreqn	mreq = {};
+
+					mreq.imr_ifindex = ifindex;
+					if (_s_setsockopt(this->_fd, IPPROTO_IP, IP_MULTICAST_IF, &mreq, sizeof(mreq)) == -1)
+						throw system_error(errno, std::generic_category(), "setsockopt");
+				} else
+					this->_ip_option(IPV6_MULTICAST_IF, ifindex);
+			}
+
+			//! @brief Enable or disable destination address and interface of received datagrams (IP_PKTINFO, IPV6_RECVPKTINFO), see nw::datagram_batch
+			//! @throw nw::system_error if setsockopt(2) function fail's
+			void	set_pktinfo(
+				const bool &enable	//!< true to enable
+			) {
+				this->_ip_option((FAMILY == sa_family::INET) ? IP_PKTINFO : IPV6_RECVPKTINFO, enable);
+			}
+
+			//! @tparam COUNT nw::size_type
+			//! @tparam SIZE nw::size_type
+			template <size_type COUNT, size_type SIZE>
+			//! @brief Receive up to COUNT datagrams with a single recvmmsg(2).
+			//! @details
+			//! Datagrams are read from batch until the next receive, each one tagged with its source and, if nw::socket::set_pktinfo
+			//! is enabled, its destination group. Without MSG_WAITFORONE nor MSG_DONTWAIT in flags, a blocking socket waits
+			//! for COUNT datagrams.
+			//!
+			//! @return number of datagrams received, 0 if none is pending on a non blocking socket
+			//! @throw nw::system_error if recvmmsg(2) function fail's
+			size_type	recv_batch(
+				datagram_batch<FAMILY, COUNT, SIZE> &batch,	//!< nw::datagram_batch
+				int flags = 0								//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recvmmsg.
+			) {
+				static_assert(TYPE == sock_type::DGRAM, "recv_batch requires a nw::sock_type::DGRAM socket");
+				NW_LATENCY_SCOPE(this->_latency.recv);
+				int32_t	ret = this->_count_call(_s_recvmmsg(this->_fd, batch._prepare(), COUNT, flags, nullptr));
+
+				if (ret == -1) {
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+						return 0;
+					throw system_error(errno, std::generic_category(), "recvmmsg");
+				}
+				batch._complete(static_cast<size_type>(ret));
+				for (int32_t i = 0; i != ret; ++i) {
+					this->_io.add(io_counter::BYTES_IN, batch._msgs[i].msg_len);
+					global_io_counters::add(io_counter::BYTES_IN, batch._msgs[i].msg_len);
+				}
+				return static_cast<size_type>(ret);
+			}
+
+			//! @tparam COUNT nw::size_type
+			//! @tparam SIZE nw::size_type
+			template <size_type COUNT, size_type SIZE>
+			//! @brief Receive up to COUNT records, one per slot of batch, with a single recvmmsg(2).
+			//! @details
+			//! Previous records of batch are discarded. A record larger than SIZE is cut and flagged truncated, its remaining
+			//! bytes are lost. Without MSG_WAITFORONE nor MSG_DONTWAIT in flags, a blocking socket waits for COUNT records.
+			//!
+			//! @return number of records received, 0 if none is pending on a non blocking socket
+			//! @throw nw::system_error if recvmmsg(2) function fail's
+			size_type	recv_records(
+				record_batch<COUNT, SIZE> &batch,	//!< nw::record_batch
+				int flags = 0						//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 recvmmsg.
+			) {
+				static_assert(TYPE == sock_type::SEQPACKET || TYPE == sock_type::DGRAM, "recv_records requires a nw::sock_type::SEQPACKET or nw::sock_type::DGRAM socket");
+				NW_LATENCY_SCOPE(this->_latency.recv);
+				int32_t	ret = this->_count_call(_s_recvmmsg(this->_fd, batch._prepare_recv(), COUNT, flags, nullptr));
+
+				if (ret == -1) {
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+						return 0;
+					throw system_error(errno, std::generic_category(), "recvmmsg");
+				}
+				batch._complete_recv(static_cast<size_type>(ret));
+				for (int32_t i = 0; i != ret; ++i) {
+					this->_io.add(io_counter::BYTES_IN, batch._lens[i]);
+					global_io_counters::add(io_counter::BYTES_IN, batch._lens[i]);
+				}
+				return static_cast<size_type>(ret);
+			}
+
+			//! @tparam COUNT nw::size_type
+			//! @tparam SIZE nw::size_type
+			template <size_type COUNT, size_type SIZE>
+			//! @brief Send the records queued in batch with a single sendmmsg(2), one message per record.
+			//! @details Sent records are removed from batch, the others stay queued in order.
+			//!
+			//! @return number of records sent, 0 if the socket send buffer is full on a non blocking socket
+			//! @throw nw::system_error if sendmmsg(2) function fail's
+			size_type	send_records(
+				record_batch<COUNT, SIZE> &batch,	//!< nw::record_batch
+				int flags = 0						//!< The flags argument is the bitwise OR of zero or more of flags defined in man 2 sendmmsg.
+			) {
+				static_assert(TYPE == sock_type::SEQPACKET || TYPE == sock_type::DGRAM, "send_records requires a nw::sock_type::SEQPACKET or nw::sock_type::DGRAM socket");
+				NW_LATENCY_SCOPE(this->_latency.send);
+				if (batch.empty())
+					return 0;
+
+				struct mmsghdr	*msgs = batch._prepare_send();
+				int32_t			ret = this->_count_call(_s_sendmmsg(this->_fd, msgs, static_cast<unsigned int>(batch._count), flags));
+
+				if (ret == -1) {
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+						return 0;
+					throw system_error(errno, std::generic_category(), "sendmmsg");
+				}
+				for (int32_t i = 0; i != ret; ++i) {
+					this->_tx_bytes += msgs[i].msg_len;
+					++this->_tx_sends;
+					this->_io.add(io_counter::BYTES_OUT, msgs[i].msg_len);
+					global_io_counters::add(io_counter::BYTES_OUT, msgs[i].msg_len);
+				}
+				batch._complete_send(static_cast<size_type>(ret));
+				return static_cast<size_type>(ret);
 			}
 
 		protected:
+			flush_policy	_flush_policy = flush_policy::IMMEDIATE;
+			bool			_more_pending = false;
+			flush_stats		_flush_stats = flush_stats();
+			bool			_truncated = false;	//!< set by nw::socket::recv_gro
+# ifdef NW_LATENCY_HISTOGRAMS
+			socket_latency	_latency;
+# endif
+
 			socket(const protoent &proto, const sockfd_type &fd, const addr<FAMILY> &a) \
 				: socket_storage<FAMILY>(TYPE, proto, fd, a) {}
 
+			//! @return connected socket file descriptor, -1 if accept(2) function fail's with errno set
+			sockfd_type	_accept(typename addr<FAMILY>::type &addr_struct, socklen_type &addr_len) {
+				return this->_count_call(_s_accept(this->_fd, reinterpret_cast<struct sockaddr *>(&addr_struct), &addr_len));
+			}
+
+			socket<FAMILY, TYPE>	_accepted(const sockfd_type &fd, const typename addr<FAMILY>::type &addr_struct, const socklen_type &addr_len) const {
+				addr<FAMILY>	peer(addr_struct);
+
+				const_cast<socklen_type &>(peer._sizeof) = addr_len;
+				return socket<FAMILY, TYPE>(this->_proto, fd, peer);
+			}
+
+			//! @return 0 on success, errno value of connect(2) otherwise
+			int32_t	_connect(const addr<FAMILY> &addr) {
+				int32_t	error = 0;
+
+				if (this->_count_call(_s_connect(this->_fd, reinterpret_cast<const sockaddr *>(&addr._struct), addr._sizeof)) == -1)
+					error = errno;
+				if (!error || error == EINPROGRESS)
+					this->_addr = addr;
+				return error;
+			}
+
+			tcp_info_struct	_tcp_info(void) const {
+				tcp_info_struct	info = {};
+				socklen_type	len = sizeof(info);
+
+				if (_s_getsockopt(this->_fd, IPPROTO_TCP, TCP_INFO, &info, &len) == -1)
+					throw system_error(errno, std::generic_category(), "getsockopt");
+				return info;
+			}
+
+			//! @brief Copy software and raw hardware timestamps of a SCM_TIMESTAMPING control message
+			static void	_timestamps(const struct cmsghdr *cmsg, struct timespec &software, struct timespec &hardware) {
+				struct scm_timestamping	tss;
+
+				std::memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+				software = tss.ts[0];
+				hardware = tss.ts[2];
+			}
+
+			//! @throw nw::logic_error if ifname is not an interface name
+			static uint32_t	_ifindex(const std::string &ifname) {
+				uint32_t	ifindex;
+
+				if (ifname.empty())
+					return 0;
+				if (!(ifindex = if_nametoindex(ifname.c_str())))
+					throw logic_error("if_nametoindex: unknown interface");
+				return ifindex;
+			}
+
+			//! @brief Set an integer IPPROTO_IP or IPPROTO_IPV6 level option, according to FAMILY
+			void	_ip_option(const int32_t &option, const int32_t &value) {
+				if (_s_setsockopt(this->_fd, (FAMILY == sa_family::INET) ? IPPROTO_IP : IPPROTO_IPV6, option, &value, sizeof(value)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			void	_group_req(const int32_t &option, const addr<FAMILY> &group, const std::string &ifname) {
+				static_assert(FAMILY == sa_family::INET || FAMILY == sa_family::INET6, "multicast requires a nw::sa_family::INET or nw::sa_family::INET6 socket");
+				struct group_req	req = {};
+
+				req.gr_interface = _ifindex(ifname);
+				std::memcpy(&req.gr_group, &group._struct, sizeof(group._struct));
+				if (_s_setsockopt(this->_fd, (FAMILY == sa_family::INET) ? IPPROTO_IP : IPPROTO_IPV6, option, &req, sizeof(req)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			void	_group_source_req(const int32_t &option, const addr<FAMILY> &group, const addr<FAMILY> &source, const std::string &ifname) {
+				static_assert(FAMILY == sa_family::INET || FAMILY == sa_family::INET6, "multicast requires a nw::sa_family::INET or nw::sa_family::INET6 socket");
+				struct group_source_req	req = {};
+
+				req.gsr_interface = _ifindex(ifname);
+				std::memcpy(&req.gsr_group, &group._struct, sizeof(group._struct));
+				std::memcpy(&req.gsr_source, &source._struct, sizeof(source._struct));
+				if (_s_setsockopt(this->_fd, (FAMILY == sa_family::INET) ? IPPROTO_IP : IPPROTO_IPV6, option, &req, sizeof(req)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			//! @brief TCP_CORK and UDP_CORK exist for internet sockets only
+			static constexpr bool	CORKABLE = (FAMILY == sa_family::INET || FAMILY == sa_family::INET6) \
+				&& (TYPE == sock_type::STREAM || TYPE == sock_type::DGRAM);
+
+			//! @brief Set or release TCP_CORK, UDP_CORK on nw::sock_type::DGRAM socket, called on CORKABLE sockets only
+			void	_set_cork(const bool &cork) {
+				int32_t	value = cork;
+
+				++this->_flush_stats.syscalls;
+				if (_s_setsockopt(this->_fd, (TYPE == sock_type::DGRAM) ? SOL_UDP : IPPROTO_TCP, (TYPE == sock_type::DGRAM) ? UDP_CORK : TCP_CORK, &value, sizeof(value)) == -1)
+					throw system_error(errno, std::generic_category(), "setsockopt");
+			}
+
+			template <size_type SIZE>
+			size_type	_send_gso(obuffer<SIZE> &buf, const void *name, const socklen_type &namelen, const uint16_t &segment_size, int flags) {
+				static_assert(TYPE == sock_type::DGRAM, "UDP_SEGMENT requires a nw::sock_type::DGRAM socket");
+				NW_LATENCY_SCOPE(this->_latency.send);
+				const size_type		max_segments = 64;
+				const size_type		max_size = 65507;
+				const sockfd_type	fd = this->_fd;
+
+				if (!segment_size || segment_size > max_size)
+					throw logic_error("send_gso: invalid segment size");
+				return buf.syncv([this, fd, name, namelen, segment_size, flags, max_segments, max_size](struct iovec *iov, size_type iovcnt){
+					size_type		limit = segment_size * std::min(max_segments, max_size / segment_size);
+					char			control[CMSG_SPACE(sizeof(uint16_t))] = {0};
+					struct msghdr	msg = {};
+
+					for (size_type i = 0; i != iovcnt; ++i) {
+						iov[i].iov_len = std::min(iov[i].iov_len, limit);
+						limit -= iov[i].iov_len;
+					}
+					msg.msg_name = const_cast<void *>(name);
+					msg.msg_namelen = namelen;
+					msg.msg_iov = iov;
+					msg.msg_iovlen = (iov[iovcnt - 1].iov_len) ? iovcnt : 1;
+					msg.msg_control = control;
+					msg.msg_controllen = sizeof(control);
+
+					struct cmsghdr	*cmsg = CMSG_FIRSTHDR(&msg);
+
+					cmsg->cmsg_level = SOL_UDP;
+					cmsg->cmsg_type = UDP_SEGMENT;
+					cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+					std::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+
+					ssize_t	ret = this->_count_io(_s_sendmsg(fd, &msg, flags), socket_storage<FAMILY>::_iov_size(iov, msg.msg_iovlen), false);
+					if (ret == -1)
+						throw system_error(errno, std::generic_category(), "sendmsg");
+					return ret;
+				});
+			}
+
 			template <sa_family, sock_type>
 			friend class socket;
 
+			template <sa_family, sock_type>
+			friend class co_socket;
+
+			template <sa_family, sock_type>
+			friend class socket_handle;
+
 		private:
 			socket(void) = delete;
 			socket(const socket &src) = delete;
@@ -438,6 +1594,31 @@ namespace nw {
 				return socket_storage<sa_family::UNSPEC>::to_string();
 			}
 
+			//! @brief Write socket data to a nw::formatter, without allocation
+			virtual void	format(formatter &f) const {
+				socket_storage<sa_family::UNSPEC>::format(f);
+			}
+
+			//! @brief Return the socket file descriptor
+			const sockfd_type &	get_fd(void) const {
+				return socket_storage<sa_family::UNSPEC>::get_fd();
+			}
+
+			//! @brief Set or clear O_NONBLOCK file status flag
+			//! @throw nw::system_error if fcntl(2) function fail's
+			void	set_nonblocking(
+				const bool &nonblocking	//!< true to set, false to clear
+			) {
+				socket_storage<sa_family::UNSPEC>::set_nonblocking(nonblocking);
+			}
+
+			//! @brief Get and clear the pending socket error (SO_ERROR)
+			//! @return errno value, 0 if no error is pending
+			//! @throw nw::system_error if getsockopt(2) function fail's
+			int32_t	get_error(void) const {
+				return socket_storage<sa_family::UNSPEC>::get_error();
+			}
+
 			//! @brief Destructor
 			//! @details
 			//! If socket is valid close it with no throw behavior
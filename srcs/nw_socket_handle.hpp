@@ -0,0 +1,257 @@
+#ifndef __NW_SOCKET_HANDLE_HPP__
+# define __NW_SOCKET_HANDLE_HPP__
+
+/*!
+@file nw_socket_handle.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+
+# include "nw_typedef.hpp"
+# include "nw_socket.hpp"
+
+namespace nw {
+	//! @tparam FAMILY nw::sa_family
+	//! @tparam TYPE nw::sock_type
+	template <sa_family FAMILY, sock_type TYPE>
+	//! @brief Compact socket handle, a file descriptor owner the size of an int
+	//! @details
+	//! Unlike nw::socket, the handle has no vtable, protocol nor address: it is default constructible, move assignable
+	//! and may be stored by value in a std::vector. Peer addresses are returned by nw::socket_handle::accept to be
+	//! stored separately when needed. Data transfers are counted in nw::global_io_counters only.
+	//!
+	//! A handle is converted from and to a nw::socket to reach the rest of the socket API.
+	class socket_handle {
+		public:
+			//! @brief Construct an invalid handle
+			socket_handle(void) : _fd(-1) {}
+
+			//! @brief Take ownership of fd
+			explicit socket_handle(
+				const sockfd_type &fd	//!< socket file descriptor of FAMILY and TYPE
+			) : _fd(fd) {}
+
+			//! @brief Take ownership of the file descriptor of sock, sock is left invalid
+			explicit socket_handle(
+				socket<FAMILY, TYPE> &&sock	//!< nw::socket
+			) : _fd(sock._fd) {
+				*const_cast<sockfd_type *>(&sock._fd) = -1;
+			}
+
+			//! @brief Move constructor
+			socket_handle(
+				socket_handle &&src	//!< nw::socket_handle
+			) : _fd(src._fd) {
+				src._fd = -1;
+			}
+
+			//! @brief Destructor
+			//! @details If handle is valid close it with no throw behavior
+			~socket_handle(void) {
+				this->close(std::nothrow);
+			}
+
+			//! @brief Move operator, the held socket is closed with no throw behavior
+			socket_handle &	operator=(
+				socket_handle &&src	//!< nw::socket_handle
+			) {
+				if (this != &src) {
+					this->close(std::nothrow);
+					this->_fd = src._fd;
+					src._fd = -1;
+				}
+				return *this;
+			}
+
+			//! @brief Return the socket file descriptor, -1 if invalid
+			inline const sockfd_type &	get_fd(void) const {
+				return this->_fd;
+			}
+
+			inline bool		is_valid(void) const {
+				return this->_fd != -1;
+			}
+
+			//! @brief Give up ownership of the file descriptor
+			//! @return file descriptor, -1 if invalid
+			sockfd_type		release(void) {
+				const sockfd_type	fd = this->_fd;
+
+				this->_fd = -1;
+				return fd;
+			}
+
+			//! @brief Convert back to a nw::socket of protocol proto, the handle is left invalid
+			socket<FAMILY, TYPE>	to_socket(
+				const protoent &proto	//!< socket protocol
+			) {
+				return socket<FAMILY, TYPE>(proto, this->release(), addr<FAMILY>());
+			}
+
+			//! @throw nw::system_error if close(2) function fail's
+			void	close(void) {
+				if (this->_fd == -1)
+					return ;
+				if (_s_close(this->release()) == -1)
+					throw system_error(errno, std::generic_category(), "close");
+			}
+
+			void	close(std::nothrow_t) {
+				if (this->_fd == -1)
+					return ;
+				_s_close(this->release());
+			}
+
+			//! @brief Set or clear O_NONBLOCK file status flag
+			//! @throw nw::system_error if fcntl(2) function fail's
+			void	set_nonblocking(
+				const bool &nonblocking	//!< true to set, false to clear
+			) {
+				int32_t	flags = _s_fcntl(this->_fd, F_GETFL, 0);
+
+				if (flags == -1)
+					throw system_error(errno, std::generic_category(), "fcntl");
+				flags = (nonblocking) ? flags | O_NONBLOCK : flags & ~O_NONBLOCK;
+				if (_s_fcntl(this->_fd, F_SETFL, flags) == -1)
+					throw system_error(errno, std::generic_category(), "fcntl");
+			}
+
+			//! @brief Accept incoming connection, see nw::socket::accept
+			//! @return connected nw::socket_handle, invalid with errno set if accept(2) function fail's with EAGAIN
+			//! @throw nw::system_error if accept(2) function fail's otherwise
+			socket_handle	accept(void) {
+				sockfd_type	fd = _count_call(_s_accept(this->_fd, nullptr, nullptr));
+
+				if (fd == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+					throw system_error(errno, std::generic_category(), "accept");
+				return socket_handle(fd);
+			}
+
+			//! @brief Accept incoming connection and return its peer address in peer, see nw::socket::accept
+			//! @return connected nw::socket_handle, invalid with errno set if accept(2) function fail's with EAGAIN
+			//! @throw nw::system_error if accept(2) function fail's otherwise
+			socket_handle	accept(
+				addr<FAMILY> &peer	//!< peer address, unchanged if no connection is accepted
+			) {
+				typename addr<FAMILY>::type	addr_struct = {};
+				socklen_type				addr_len = sizeof(addr_struct);
+				sockfd_type					fd = _count_call(_s_accept(this->_fd, reinterpret_cast<struct sockaddr *>(&addr_struct), &addr_len));
+
+				if (fd == -1) {
+					if (errno != EAGAIN && errno != EWOULDBLOCK)
+						throw system_error(errno, std::generic_category(), "accept");
+					return socket_handle();
+				}
+				peer = addr<FAMILY>(addr_struct);
+				const_cast<socklen_type &>(peer._sizeof) = addr_len;
+				return socket_handle(fd);
+			}
+
+			//! @tparam SIZE nw::size_type
+			template <size_type SIZE>
+			//! @brief Send pending data of buf, see nw::socket::send
+			//! @throw nw::system_error if send(2) function fail's
+			size_type	send(obuffer<SIZE> &buf, const int &flags = 0) {
+				const size_type	ret = this->send(buf, flags, std::nothrow);
+
+				if (ret == npos)
+					throw system_error(errno, std::generic_category(), "send");
+				return ret;
+			}
+
+			//! @tparam SIZE nw::size_type
+			template <size_type SIZE>
+			//! @brief Send pending data of buf with no throw behavior
+			//! @return number of bytes sent, nw::npos if send(2) function fail's with errno set
+			size_type	send(obuffer<SIZE> &buf, const int &flags, std::nothrow_t) {
+				const sockfd_type	fd = this->_fd;
+
+				return buf.sync([fd, flags](void *buf, size_type size){
+					return _count_io(_s_send(fd, buf, size, flags), size, io_counter::BYTES_OUT, io_counter::SHORT_WRITES);
+				});
+			}
+
+			//! @tparam SIZE nw::size_type
+			template <size_type SIZE>
+			//! @brief Receive into buf, see nw::socket::recv
+			//! @throw nw::system_error if recv(2) function fail's
+			size_type	recv(ibuffer<SIZE> &buf, const int &flags = 0) {
+				const size_type	ret = this->recv(buf, flags, std::nothrow);
+
+				if (ret == npos)
+					throw system_error(errno, std::generic_category(), "recv");
+				return ret;
+			}
+
+			//! @tparam SIZE nw::size_type
+			template <size_type SIZE>
+			//! @brief Receive into buf with no throw behavior
+			//! @return number of bytes received, nw::npos if recv(2) function fail's with errno set
+			size_type	recv(ibuffer<SIZE> &buf, const int &flags, std::nothrow_t) {
+				const sockfd_type	fd = this->_fd;
+
+				return buf.sync([fd, flags](void *buf, size_type size){
+					return _count_io(_s_recv(fd, buf, size, flags), size, io_counter::BYTES_IN, io_counter::SHORT_READS);
+				});
+			}
+
+			//! @brief Return a json formated std::string containing handle data
+			const std::string	to_string(void) const {
+				return format_string([this](formatter &f){ this->format(f); }, 64);
+			}
+
+			//! @brief Write handle data to a nw::formatter, without allocation
+			void				format(formatter &f) const {
+				f.begin_object();
+				f.key("family").value(sa_family_name(FAMILY));
+				f.key("fd").value(this->_fd);
+				f.key("type").value(sock_type_name(TYPE));
+				f.end_object();
+			}
+
+		protected:
+			sockfd_type	_fd;
+
+			//! @brief Count a system call in nw::global_io_counters, errno is preserved
+			static sockfd_type	_count_call(const sockfd_type &ret) {
+				global_io_counters::add(io_counter::SYSCALLS);
+				if (ret != -1)
+					return ret;
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					global_io_counters::add(io_counter::WOULD_BLOCK);
+				else
+					global_io_counters::error(errno);
+				return ret;
+			}
+
+			//! @brief Count a data transfer system call in nw::global_io_counters, errno is preserved
+			static ssize_t		_count_io(const ssize_t &ret, const size_type &size, const io_counter &bytes, const io_counter &shorts) {
+				global_io_counters::add(io_counter::SYSCALLS);
+				if (ret == -1) {
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+						global_io_counters::add(io_counter::WOULD_BLOCK);
+					else
+						global_io_counters::error(errno);
+					return ret;
+				}
+				global_io_counters::add(bytes, ret);
+				if (ret > 0 && static_cast<size_type>(ret) < size)
+					global_io_counters::add(shorts);
+				return ret;
+			}
+
+		private:
+			socket_handle(const socket_handle &src) = delete;
+			socket_handle &	operator=(const socket_handle &src) = delete;
+	};
+};
+
+template <nw::sa_family FAMILY, nw::sock_type TYPE>
+std::ostream &	operator<<(std::ostream &o, const nw::socket_handle<FAMILY, TYPE> &C) {
+	o << C.to_string();
+	return o;
+}
+
+#endif
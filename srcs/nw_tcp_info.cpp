@@ -0,0 +1,184 @@
+
+/*!
+@file nw_tcp_info.cpp
+@brief ...
+*/
+
+#include <algorithm>
+#include <limits>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "nw_tcp_info.hpp"
+#include "nw_transport.hpp"
+
+static const std::function<int(int, int, int, void *, socklen_t *)> &	_s_getsockopt = nw::transport::current.getsockopt;
+
+const std::string	nw::tcp_info_struct::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 512);
+}
+
+void				nw::tcp_info_struct::format(formatter &f) const {
+	f.begin_object();
+	f.key("state").value(static_cast<uint32_t>(this->tcpi_state));
+	f.key("rtt_us").value(this->tcpi_rtt);
+	f.key("rttvar_us").value(this->tcpi_rttvar);
+	f.key("min_rtt_us").value(this->tcpi_min_rtt);
+	f.key("snd_cwnd").value(this->tcpi_snd_cwnd);
+	f.key("snd_ssthresh").value(this->tcpi_snd_ssthresh);
+	f.key("unacked").value(this->tcpi_unacked);
+	f.key("lost").value(this->tcpi_lost);
+	f.key("retransmits").value(static_cast<uint32_t>(this->tcpi_retransmits));
+	f.key("total_retrans").value(this->tcpi_total_retrans);
+	f.key("delivery_rate").value(this->tcpi_delivery_rate);
+	f.key("pacing_rate").value(this->tcpi_pacing_rate);
+	f.key("notsent_bytes").value(this->tcpi_notsent_bytes);
+	f.key("bytes_acked").value(this->tcpi_bytes_acked);
+	f.key("bytes_received").value(this->tcpi_bytes_received);
+	f.key("snd_wnd").value(this->tcpi_snd_wnd);
+	f.key("rwnd_limited_us").value(this->tcpi_rwnd_limited);
+	f.key("sndbuf_limited_us").value(this->tcpi_sndbuf_limited);
+	f.end_object();
+}
+
+nw::tcp_info_aggregate::tcp_info_aggregate(void) \
+	: time(), connections(0), snd_cwnd_min(0), snd_cwnd_max(0), snd_cwnd(0), unacked(0), lost(0), total_retrans(0), \
+	notsent_bytes(0), delivery_rate(0), slowest_fd(-1), slowest_rtt(0) {
+}
+
+void				nw::tcp_info_aggregate::add(const sockfd_type &fd, const tcp_info_struct &info) {
+	this->rtt.record(static_cast<latency_histogram::value_type>(info.tcpi_rtt) * 1000);
+	this->snd_cwnd_min = (this->connections) ? std::min(this->snd_cwnd_min, info.tcpi_snd_cwnd) : info.tcpi_snd_cwnd;
+	this->snd_cwnd_max = std::max(this->snd_cwnd_max, info.tcpi_snd_cwnd);
+	this->snd_cwnd += info.tcpi_snd_cwnd;
+	this->unacked += info.tcpi_unacked;
+	this->lost += info.tcpi_lost;
+	this->total_retrans += info.tcpi_total_retrans;
+	this->notsent_bytes += info.tcpi_notsent_bytes;
+	this->delivery_rate += info.tcpi_delivery_rate;
+	if (this->slowest_fd == -1 || info.tcpi_rtt > this->slowest_rtt) {
+		this->slowest_fd = fd;
+		this->slowest_rtt = info.tcpi_rtt;
+	}
+	++this->connections;
+}
+
+const std::string	nw::tcp_info_aggregate::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 768);
+}
+
+void				nw::tcp_info_aggregate::format(formatter &f) const {
+	f.begin_object();
+	f.key("connections").value(this->connections);
+	f.key("rtt_ns");
+	this->rtt.format(f);
+	f.key("snd_cwnd_min").value(this->snd_cwnd_min);
+	f.key("snd_cwnd_max").value(this->snd_cwnd_max);
+	f.key("snd_cwnd").value(this->snd_cwnd);
+	f.key("unacked").value(this->unacked);
+	f.key("lost").value(this->lost);
+	f.key("total_retrans").value(this->total_retrans);
+	f.key("notsent_bytes").value(this->notsent_bytes);
+	f.key("delivery_rate").value(this->delivery_rate);
+	f.key("slowest").begin_object();
+	f.key("fd").value(this->slowest_fd);
+	f.key("rtt_us").value(this->slowest_rtt);
+	f.end_object();
+	f.end_object();
+}
+
+nw::tcp_info_sampler::tcp_info_sampler(const msec_type &interval) \
+	: _interval(interval), _last(time_point::min()) {
+}
+
+nw::tcp_info_sampler::~tcp_info_sampler(void) {
+}
+
+void				nw::tcp_info_sampler::add(const sockfd_type &fd) {
+	if (fd < 0)
+		throw logic_error("tcp_info_sampler: invalid fd");
+	this->_fds.push_back(fd);
+}
+
+bool				nw::tcp_info_sampler::remove(const sockfd_type &fd) {
+	std::vector<sockfd_type>::iterator	it = std::find(this->_fds.begin(), this->_fds.end(), fd);
+
+	if (it == this->_fds.end())
+		return false;
+	*it = this->_fds.back();
+	this->_fds.pop_back();
+	return true;
+}
+
+nw::size_type		nw::tcp_info_sampler::size(void) const {
+	return this->_fds.size();
+}
+
+const nw::tcp_info_aggregate &	nw::tcp_info_sampler::sample(const sample_fct_t &fct) {
+	tcp_info_aggregate	&aggregate = this->_aggregate;
+
+	aggregate = tcp_info_aggregate();
+	aggregate.time = clock_type::now();
+	for (size_type i = 0; i < this->_fds.size();) {
+		tcp_info_struct	info = {};
+		socklen_type	len = sizeof(info);
+
+		if (_s_getsockopt(this->_fds[i], IPPROTO_TCP, TCP_INFO, &info, &len) == -1) {
+			this->_fds[i] = this->_fds.back();
+			this->_fds.pop_back();
+			continue ;
+		}
+		aggregate.add(this->_fds[i], info);
+		if (fct)
+			fct(this->_fds[i], info);
+		++i;
+	}
+	this->_last = aggregate.time;
+	return aggregate;
+}
+
+bool				nw::tcp_info_sampler::poll(const time_point &now, const sample_fct_t &fct) {
+	if (now < this->next_sample())
+		return false;
+	this->sample(fct);
+	return true;
+}
+
+nw::time_point		nw::tcp_info_sampler::next_sample(void) const {
+	if (this->_last == time_point::min())
+		return this->_last;
+	return this->_last + this->_interval;
+}
+
+const nw::tcp_info_aggregate &	nw::tcp_info_sampler::get_aggregate(void) const {
+	return this->_aggregate;
+}
+
+const std::string	nw::tcp_info_sampler::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 1024);
+}
+
+void				nw::tcp_info_sampler::format(formatter &f) const {
+	f.begin_object();
+	f.key("interval_ms").value(static_cast<int64_t>(std::chrono::duration_cast<msec_type>(this->_interval).count()));
+	f.key("connections").value(this->_fds.size());
+	f.key("aggregate");
+	this->_aggregate.format(f);
+	f.end_object();
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::tcp_info_struct &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::tcp_info_aggregate &C) {
+	o << C.to_string();
+	return (o);
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::tcp_info_sampler &C) {
+	o << C.to_string();
+	return (o);
+}
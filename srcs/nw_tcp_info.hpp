@@ -0,0 +1,179 @@
+#ifndef __NW_TCP_INFO_HPP__
+# define __NW_TCP_INFO_HPP__
+
+/*!
+@file nw_tcp_info.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <vector>
+# include <functional>
+# include <cstdint>
+
+# include <netinet/tcp.h>
+
+# include "nw_typedef.hpp"
+# include "nw_histogram.hpp"
+
+namespace nw {
+	//! @brief Mirror of linux/tcp.h struct tcp_info, netinet/tcp.h one stops at tcpi_total_retrans
+	//! @details Fields unknown to the running kernel are left to 0 by getsockopt(2).
+	struct	tcp_info_struct {
+		uint8_t	tcpi_state;
+		uint8_t	tcpi_ca_state;
+		uint8_t	tcpi_retransmits;
+		uint8_t	tcpi_probes;
+		uint8_t	tcpi_backoff;
+		uint8_t	tcpi_options;
+		uint8_t	tcpi_snd_wscale : 4, tcpi_rcv_wscale : 4;
+		uint8_t	tcpi_delivery_rate_app_limited:1, tcpi_fastopen_client_fail:2;
+
+		uint32_t	tcpi_rto;
+		uint32_t	tcpi_ato;
+		uint32_t	tcpi_snd_mss;
+		uint32_t	tcpi_rcv_mss;
+
+		uint32_t	tcpi_unacked;
+		uint32_t	tcpi_sacked;
+		uint32_t	tcpi_lost;
+		uint32_t	tcpi_retrans;
+		uint32_t	tcpi_fackets;
+
+		uint32_t	tcpi_last_data_sent;
+		uint32_t	tcpi_last_ack_sent;
+		uint32_t	tcpi_last_data_recv;
+		uint32_t	tcpi_last_ack_recv;
+
+		uint32_t	tcpi_pmtu;
+		uint32_t	tcpi_rcv_ssthresh;
+		uint32_t	tcpi_rtt;
+		uint32_t	tcpi_rttvar;
+		uint32_t	tcpi_snd_ssthresh;
+		uint32_t	tcpi_snd_cwnd;
+		uint32_t	tcpi_advmss;
+		uint32_t	tcpi_reordering;
+
+		uint32_t	tcpi_rcv_rtt;
+		uint32_t	tcpi_rcv_space;
+
+		uint32_t	tcpi_total_retrans;
+
+		uint64_t	tcpi_pacing_rate;
+		uint64_t	tcpi_max_pacing_rate;
+		uint64_t	tcpi_bytes_acked;		//!< RFC4898 tcpEStatsAppHCThruOctetsAcked
+		uint64_t	tcpi_bytes_received;	//!< RFC4898 tcpEStatsAppHCThruOctetsReceived
+		uint32_t	tcpi_segs_out;		//!< RFC4898 tcpEStatsPerfSegsOut
+		uint32_t	tcpi_segs_in;		//!< RFC4898 tcpEStatsPerfSegsIn
+
+		uint32_t	tcpi_notsent_bytes;
+		uint32_t	tcpi_min_rtt;
+		uint32_t	tcpi_data_segs_in;		//!< RFC4898 tcpEStatsDataSegsIn
+		uint32_t	tcpi_data_segs_out;		//!< RFC4898 tcpEStatsDataSegsOut
+
+		uint64_t	tcpi_delivery_rate;
+
+		uint64_t	tcpi_busy_time;		//!< Time (usec) busy sending data
+		uint64_t	tcpi_rwnd_limited;		//!< Time (usec) limited by receive window
+		uint64_t	tcpi_sndbuf_limited;		//!< Time (usec) limited by send buffer
+
+		uint32_t	tcpi_delivered;
+		uint32_t	tcpi_delivered_ce;
+
+		uint64_t	tcpi_bytes_sent;		//!< RFC4898 tcpEStatsPerfHCDataOctetsOut
+		uint64_t	tcpi_bytes_retrans;		//!< RFC4898 tcpEStatsPerfOctetsRetrans
+		uint32_t	tcpi_dsack_dups;		//!< RFC4898 tcpEStatsStackDSACKDups
+		uint32_t	tcpi_reord_seen;		//!< reordering events seen
+
+		uint32_t	tcpi_rcv_ooopack;		//!< Out-of-order packets received
+
+		uint32_t	tcpi_snd_wnd;			//!< peer's advertised receive window after scaling (bytes)
+
+		//! @brief Return a json formated std::string of the diagnostic fields
+		const std::string	to_string(void) const;
+
+		//! @brief Write the diagnostic fields to a nw::formatter, without allocation
+		void				format(formatter &f) const;
+	};
+
+	//! @brief TCP_INFO of a set of connections, summed or summarized
+	struct	tcp_info_aggregate {
+		time_point			time;				//!< sample time
+		size_type			connections;		//!< connections sampled
+		latency_histogram	rtt;				//!< smoothed rtt distribution, in nanoseconds
+		uint32_t			snd_cwnd_min;		//!< segments
+		uint32_t			snd_cwnd_max;		//!< segments
+		uint64_t			snd_cwnd;			//!< sum, segments
+		uint64_t			unacked;			//!< sum, segments
+		uint64_t			lost;				//!< sum, segments
+		uint64_t			total_retrans;		//!< sum, segments
+		uint64_t			notsent_bytes;		//!< sum, bytes
+		uint64_t			delivery_rate;		//!< sum, bytes per second
+		sockfd_type			slowest_fd;			//!< connection with the highest rtt, -1 if none
+		uint32_t			slowest_rtt;		//!< its rtt, microseconds
+
+		tcp_info_aggregate(void);
+
+		//! @brief Add a connection TCP_INFO
+		void	add(const sockfd_type &fd, const tcp_info_struct &info);
+
+		const std::string	to_string(void) const;
+		void				format(formatter &f) const;
+	};
+
+	//! @brief Periodic TCP_INFO sampler of a set of connections, typically those accepted by a listener
+	//! @details
+	//! A sample costs one getsockopt(2) per connection. Connections should be removed before being closed, a connection
+	//! which getsockopt(2) fails is removed by the next sample.
+	class tcp_info_sampler {
+		public:
+			typedef std::function<void(sockfd_type, const tcp_info_struct &)>	sample_fct_t;
+
+			//! @brief Construct with sampling interval used by nw::tcp_info_sampler::poll
+			tcp_info_sampler(const msec_type &interval = msec_type(1000));
+			virtual	~tcp_info_sampler(void);
+
+			void		add(const sockfd_type &fd);
+
+			//! @return false if fd was not sampled
+			bool		remove(const sockfd_type &fd);
+
+			size_type	size(void) const;
+
+			//! @brief Sample every connection now, fct is called with each connection TCP_INFO
+			const tcp_info_aggregate &	sample(const sample_fct_t &fct = nullptr);
+
+			//! @brief Sample if the interval elapsed since the last sample
+			//! @return true if sampled
+			bool		poll(const time_point &now, const sample_fct_t &fct = nullptr);
+
+			//! @brief Return the next sample time, suitable as a readiness wait deadline
+			time_point	next_sample(void) const;
+
+			//! @brief Return the last sample
+			const tcp_info_aggregate &	get_aggregate(void) const;
+
+			const std::string	to_string(void) const;
+			void				format(formatter &f) const;
+
+		protected:
+			const clock_type::duration	_interval;
+			time_point					_last;
+			std::vector<sockfd_type>	_fds;
+			tcp_info_aggregate			_aggregate;
+
+		private:
+			tcp_info_sampler(const tcp_info_sampler &src) = delete;
+			tcp_info_sampler(tcp_info_sampler &&src) = delete;
+
+			tcp_info_sampler &	operator=(const tcp_info_sampler &src) = delete;
+			tcp_info_sampler &	operator=(tcp_info_sampler &&src) = delete;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::tcp_info_struct &C);
+std::ostream &	operator<<(std::ostream &o, const nw::tcp_info_aggregate &C);
+std::ostream &	operator<<(std::ostream &o, const nw::tcp_info_sampler &C);
+
+#endif
@@ -0,0 +1,189 @@
+
+/*!
+@file nw_timer_wheel.cpp
+@brief ...
+*/
+
+#include <algorithm>
+#include <limits>
+
+#include "nw_timer_wheel.hpp"
+
+const uint8_t		nw::timer_wheel::LEVEL_BITS;
+const uint8_t		nw::timer_wheel::SLOTS;
+const uint8_t		nw::timer_wheel::LEVELS;
+const uint16_t		nw::timer_wheel::NIL_SLOT;
+const nw::sockfd_type	nw::timer_wheel::NIL;
+
+//! @return level of the highest 6 bits group where a and b differ, a != b
+static uint8_t		_level(const nw::timer_wheel::tick_type &a, const nw::timer_wheel::tick_type &b) {
+	return static_cast<uint8_t>((63 - __builtin_clzll(a ^ b)) / 6);
+}
+
+//! @return bits of tick above level
+static nw::timer_wheel::tick_type	_high(const nw::timer_wheel::tick_type &tick, const uint8_t &level) {
+	const uint8_t	shift = static_cast<uint8_t>((level + 1) * 6);
+
+	return (shift >= 64) ? 0 : (tick >> shift) << shift;
+}
+
+nw::timer_wheel::timer_wheel(const msec_type &resolution) \
+	: _origin(clock_type::now()), _resolution(std::max(clock_type::duration(resolution), clock_type::duration(1))), _now(0), _count(0) {
+	std::fill(this->_heads, this->_heads + LEVELS * SLOTS, NIL);
+	std::fill(this->_bitmap, this->_bitmap + LEVELS, 0);
+}
+
+nw::timer_wheel::~timer_wheel(void) {
+}
+
+nw::timer_wheel::tick_type	nw::timer_wheel::_tick(const time_point &tp, const bool &round_up) const {
+	if (tp <= this->_origin)
+		return 0;
+	if (tp == time_point::max())
+		return std::numeric_limits<tick_type>::max();
+
+	const clock_type::duration	d = tp - this->_origin;
+
+	return static_cast<tick_type>(d / this->_resolution) + ((round_up && d % this->_resolution != clock_type::duration::zero()) ? 1 : 0);
+}
+
+nw::time_point		nw::timer_wheel::_time(const tick_type &tick) const {
+	if (tick > static_cast<tick_type>((time_point::max() - this->_origin) / this->_resolution))
+		return time_point::max();
+	return this->_origin + this->_resolution * static_cast<clock_type::rep>(tick);
+}
+
+void				nw::timer_wheel::_link(const sockfd_type &fd, const tick_type &expiry) {
+	node			&n = this->_nodes[fd];
+	const uint8_t	level = _level(expiry, this->_now);
+	const uint16_t	slot = static_cast<uint16_t>(level * SLOTS + ((expiry >> (level * LEVEL_BITS)) & (SLOTS - 1)));
+
+	n.expiry = expiry;
+	n.slot = slot;
+	n.prev = NIL;
+	n.next = this->_heads[slot];
+	if (n.next != NIL)
+		this->_nodes[n.next].prev = fd;
+	this->_heads[slot] = fd;
+	this->_bitmap[level] |= uint64_t(1) << (slot % SLOTS);
+}
+
+void				nw::timer_wheel::_unlink(const sockfd_type &fd) {
+	node	&n = this->_nodes[fd];
+
+	if (n.prev != NIL)
+		this->_nodes[n.prev].next = n.next;
+	else
+		this->_heads[n.slot] = n.next;
+	if (n.next != NIL)
+		this->_nodes[n.next].prev = n.prev;
+	if (this->_heads[n.slot] == NIL)
+		this->_bitmap[n.slot / SLOTS] &= ~(uint64_t(1) << (n.slot % SLOTS));
+	n.slot = NIL_SLOT;
+}
+
+void				nw::timer_wheel::schedule(const sockfd_type &fd, const time_point &expiry) {
+	if (fd < 0)
+		throw logic_error("timer_wheel: invalid fd");
+	if (static_cast<size_type>(fd) >= this->_nodes.size())
+		this->_nodes.resize(std::max<size_type>(fd + 1, this->_nodes.size() * 2), node{0, NIL, NIL, NIL_SLOT});
+	if (this->_nodes[fd].slot != NIL_SLOT)
+		this->_unlink(fd);
+	else
+		++this->_count;
+	this->_link(fd, std::max(this->_tick(expiry, true), this->_now + 1));
+}
+
+void				nw::timer_wheel::schedule(const sockfd_type &fd, const msec_type &timeout) {
+	this->schedule(fd, clock_type::now() + timeout);
+}
+
+bool				nw::timer_wheel::cancel(const sockfd_type &fd) {
+	if (!this->is_scheduled(fd))
+		return false;
+	this->_unlink(fd);
+	--this->_count;
+	return true;
+}
+
+bool				nw::timer_wheel::is_scheduled(const sockfd_type &fd) const {
+	return fd >= 0 && static_cast<size_type>(fd) < this->_nodes.size() && this->_nodes[fd].slot != NIL_SLOT;
+}
+
+nw::time_point		nw::timer_wheel::expiry(const sockfd_type &fd) const {
+	if (!this->is_scheduled(fd))
+		return time_point::max();
+	return this->_time(this->_nodes[fd].expiry);
+}
+
+nw::time_point		nw::timer_wheel::next_expiry(void) const {
+	for (uint8_t level = 0; level != LEVELS; ++level) {
+		if (!this->_bitmap[level])
+			continue ;
+
+		const tick_type	slot = static_cast<tick_type>(__builtin_ctzll(this->_bitmap[level]));
+
+		return this->_time(_high(this->_now, level) | (slot << (level * LEVEL_BITS)));
+	}
+	return time_point::max();
+}
+
+nw::size_type		nw::timer_wheel::expire(const time_point &now, const expire_fct_t &fct) {
+	const tick_type	target = this->_tick(now, false);
+	size_type		fired = 0;
+
+	while (this->_now < target) {
+		uint8_t	level = 0;
+
+		while (level != LEVELS && !this->_bitmap[level])
+			++level;
+		if (level == LEVELS)
+			break ;
+
+		const uint16_t	slot = static_cast<uint16_t>(__builtin_ctzll(this->_bitmap[level]));
+		const tick_type	tick = _high(this->_now, level) | (static_cast<tick_type>(slot) << (level * LEVEL_BITS));
+
+		if (tick > target)
+			break ;
+		this->_now = tick;
+		// every slot is strictly ahead of current tick on its level, so cascading relative to the new tick
+		// moves timers to lower levels only, and never back into the slot being drained
+		for (sockfd_type fd = this->_heads[level * SLOTS + slot]; fd != NIL; fd = this->_heads[level * SLOTS + slot]) {
+			this->_unlink(fd);
+			if (this->_nodes[fd].expiry != tick) {
+				this->_link(fd, this->_nodes[fd].expiry);
+				continue ;
+			}
+			--this->_count;
+			++fired;
+			fct(fd);
+		}
+	}
+	this->_now = std::max(this->_now, target);
+	return fired;
+}
+
+nw::size_type		nw::timer_wheel::size(void) const {
+	return this->_count;
+}
+
+const std::string	nw::timer_wheel::to_string(void) const {
+	return format_string([this](formatter &f){ this->format(f); }, 256);
+}
+
+void				nw::timer_wheel::format(formatter &f) const {
+	f.begin_object();
+	f.key("resolution_ns").value(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(this->_resolution).count()));
+	f.key("tick").value(this->_now);
+	f.key("timers").value(this->_count);
+	f.key("levels").begin_array();
+	for (uint8_t level = 0; level != LEVELS; ++level)
+		f.value(static_cast<int32_t>(__builtin_popcountll(this->_bitmap[level])));
+	f.end_array();
+	f.end_object();
+}
+
+std::ostream &		operator<<(std::ostream &o, const nw::timer_wheel &C) {
+	o << C.to_string();
+	return (o);
+}
@@ -0,0 +1,111 @@
+#ifndef __NW_TIMER_WHEEL_HPP__
+# define __NW_TIMER_WHEEL_HPP__
+
+/*!
+@file nw_timer_wheel.hpp
+@brief ...
+*/
+
+# include <ostream>
+# include <string>
+# include <vector>
+# include <functional>
+
+# include "nw_typedef.hpp"
+# include "nw_format.hpp"
+
+namespace nw {
+	//! @brief Hierarchical timing wheel of per fd timers
+	//! @details
+	//! Time is counted in ticks of resolution since construction. Each level has 64 slots, level n slot covering 64^n ticks,
+	//! so that 11 levels span the whole 64 bits tick range. A timer is stored on the level of the highest 6 bits group
+	//! where its expiry tick differs from current tick and cascaded down when current tick reach its slot.
+	//!
+	//! Timers are keyed by fd, at most one per fd: schedule, reschedule and cancel are O(1) and do not allocate
+	//! once the fd table has grown to the highest fd in use.
+	class timer_wheel {
+		public:
+			typedef uint64_t							tick_type;
+			typedef std::function<void(sockfd_type)>	expire_fct_t;
+
+			//! @brief Construct with tick resolution
+			timer_wheel(const msec_type &resolution = msec_type(1));
+
+			//! @brief Destructor
+			virtual	~timer_wheel(void);
+
+			//! @brief Schedule or reschedule fd timer at expiry
+			//! @details An expiry not after current tick fire on the next tick
+			void		schedule(const sockfd_type &fd, const time_point &expiry);
+
+			//! @brief Schedule or reschedule fd timer timeout from now
+			void		schedule(const sockfd_type &fd, const msec_type &timeout);
+
+			//! @brief Cancel fd timer
+			//! @return false if fd had no timer
+			bool		cancel(const sockfd_type &fd);
+
+			//! @brief Return true if fd has a timer
+			bool		is_scheduled(const sockfd_type &fd) const;
+
+			//! @brief Return fd timer expiry, time_point::max() if fd has no timer
+			time_point	expiry(const sockfd_type &fd) const;
+
+			//! @brief Return a lower bound of the nearest expiry, time_point::max() if no timer is scheduled
+			//! @details Suitable as a readiness wait deadline: waking up on it at worst cascade timers without firing any.
+			time_point	next_expiry(void) const;
+
+			//! @brief Fire every timer expired at now
+			//! @details Timers are removed before fct is called, fct may schedule or cancel any timer.
+			//! @return number of fired timers
+			size_type	expire(const time_point &now, const expire_fct_t &fct);
+
+			//! @brief Number of scheduled timers
+			size_type	size(void) const;
+
+			inline bool	empty(void) const {
+				return !this->_count;
+			}
+
+			const std::string	to_string(void) const;
+			void				format(formatter &f) const;
+
+		protected:
+			static const uint8_t	LEVEL_BITS	= 6;
+			static const uint8_t	SLOTS		= 1 << LEVEL_BITS;
+			static const uint8_t	LEVELS		= (64 + LEVEL_BITS - 1) / LEVEL_BITS;
+			static const uint16_t	NIL_SLOT	= static_cast<uint16_t>(~0);
+			static const sockfd_type	NIL		= -1;
+
+			struct	node {
+				tick_type	expiry;
+				sockfd_type	prev;
+				sockfd_type	next;
+				uint16_t	slot;
+			};
+
+			const time_point				_origin;
+			const clock_type::duration		_resolution;
+			tick_type						_now;
+			size_type						_count;
+			std::vector<node>				_nodes;
+			sockfd_type						_heads[LEVELS * SLOTS];
+			uint64_t						_bitmap[LEVELS];
+
+			tick_type	_tick(const time_point &tp, const bool &round_up) const;
+			time_point	_time(const tick_type &tick) const;
+			void		_link(const sockfd_type &fd, const tick_type &expiry);
+			void		_unlink(const sockfd_type &fd);
+
+		private:
+			timer_wheel(const timer_wheel &src) = delete;
+			timer_wheel(timer_wheel &&src) = delete;
+
+			timer_wheel &	operator=(const timer_wheel &src) = delete;
+			timer_wheel &	operator=(timer_wheel &&src) = delete;
+	};
+};
+
+std::ostream &	operator<<(std::ostream &o, const nw::timer_wheel &C);
+
+#endif
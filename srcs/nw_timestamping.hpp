@@ -0,0 +1,48 @@
+#ifndef __NW_TIMESTAMPING_HPP__
+# define __NW_TIMESTAMPING_HPP__
+
+/*!
+@file nw_timestamping.hpp
+@brief ...
+*/
+
+# include <cstdint>
+# include <ctime>
+
+# include <linux/net_tstamp.h>
+# include <linux/errqueue.h>
+
+namespace nw {
+	//! @brief SO_TIMESTAMPING flags enabled by default by nw::socket::set_timestamping
+	//! @details
+	//! Software and raw hardware timestamps on receive, on transmit when the packet enters the packet scheduler and leaves
+	//! the stack (and the NIC), and on acknowledgment for TCP. Transmit timestamps are reported without payload and keyed by nw::socket::get_tx_id.
+	//! SOF_TIMESTAMPING_OPT_ID requires a nw::sock_type::STREAM socket to be connected.
+	const uint32_t	TIMESTAMPING_DEFAULT = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_RX_HARDWARE \
+		| SOF_TIMESTAMPING_TX_SCHED | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_TX_ACK \
+		| SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_RAW_HARDWARE \
+		| SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+
+	//! @enum tstamp_type
+	enum class	tstamp_type : uint32_t {
+		SND		= SCM_TSTAMP_SND,	//!< packet handed to the device (software) or sent by the NIC (hardware)
+		SCHED	= SCM_TSTAMP_SCHED,	//!< packet entered the packet scheduler
+		ACK		= SCM_TSTAMP_ACK	//!< every byte of the send was acknowledged by the peer (TCP)
+	};
+
+	//! @brief Kernel timestamps of a received chunk or datagram, a zeroed timespec was not taken
+	struct	rx_timestamp {
+		struct timespec	software;	//!< CLOCK_REALTIME, taken when the packet entered the stack
+		struct timespec	hardware;	//!< raw NIC clock
+	};
+
+	//! @brief Kernel timestamps of a transmitted send
+	struct	tx_timestamp {
+		uint32_t		id;			//!< nw::socket::get_tx_id of the send
+		tstamp_type		type;		//!< nw::tstamp_type
+		struct timespec	software;	//!< CLOCK_REALTIME
+		struct timespec	hardware;	//!< raw NIC clock
+	};
+};
+
+#endif
@@ -0,0 +1,35 @@
+
+/*!
+@file nw_transport.cpp
+@brief ...
+*/
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "nw_transport.hpp"
+
+const nw::transport	nw::transport::system = {
+	&::socket,
+	&::socketpair,
+	&::bind,
+	&::listen,
+	&::connect,
+	&::accept,
+	&::close,
+	&::shutdown,
+	&::fcntl,
+	&::getsockopt,
+	&::setsockopt,
+	&::send,
+	&::sendto,
+	&::sendmsg,
+	&::recv,
+	&::recvfrom,
+	&::recvmsg,
+	&::recvmmsg,
+	&::sendmmsg,
+	&::poll
+};
+
+nw::transport		nw::transport::current = nw::transport::system;
@@ -0,0 +1,50 @@
+#ifndef __NW_TRANSPORT_HPP__
+# define __NW_TRANSPORT_HPP__
+
+/*!
+@file nw_transport.hpp
+@brief ...
+*/
+
+# include <functional>
+
+# include <sys/socket.h>
+# include <poll.h>
+
+namespace nw {
+	//! @brief Socket system calls issued by nw
+	//! @details
+	//! nw::socket, nw::wait and the other socket wrappers call through nw::transport::current, which holds the system
+	//! calls of nw::transport::system unless a backend replaced them (see nw::sim_network). Replacing entries is not thread safe, it is done while no socket is
+	//! in use.
+	struct	transport {
+		std::function<int(int, int, int)>								socket;
+		std::function<int(int, int, int, int *)>						socketpair;
+		std::function<int(int, const struct sockaddr *, socklen_t)>	bind;
+		std::function<int(int, int)>									listen;
+		std::function<int(int, const struct sockaddr *, socklen_t)>	connect;
+		std::function<int(int, struct sockaddr *, socklen_t *)>		accept;
+		std::function<int(int)>										close;
+		std::function<int(int, int)>									shutdown;
+		std::function<int(int, int, int)>								fcntl;
+		std::function<int(int, int, int, void *, socklen_t *)>			getsockopt;
+		std::function<int(int, int, int, const void *, socklen_t)>		setsockopt;
+		std::function<ssize_t(int, void *, size_t, int)>				send;
+		std::function<ssize_t(int, void *, size_t, int, \
+				const struct sockaddr *, socklen_t)>					sendto;
+		std::function<ssize_t(int, const struct msghdr *, int)>		sendmsg;
+		std::function<ssize_t(int, void *, size_t, int)>				recv;
+		std::function<ssize_t(int, void *, size_t, int, \
+				struct sockaddr *, socklen_t *)>						recvfrom;
+		std::function<ssize_t(int, struct msghdr *, int)>				recvmsg;
+		std::function<int(int, struct mmsghdr *, unsigned int, \
+				int, struct timespec *)>								recvmmsg;
+		std::function<int(int, struct mmsghdr *, unsigned int, int)>	sendmmsg;
+		std::function<int(struct pollfd *, nfds_t, int)>				poll;
+
+		static const transport	system;		//!< system calls
+		static transport		current;	//!< calls issued by nw::socket
+	};
+};
+
+#endif
@@ -4,30 +4,50 @@
 @brief ...
 */
 
-#include <map>
-
 #include "nw_typedef.hpp"
 
-static const std::map<const nw::sa_family, const std::string>	s_family_str = {
-	{nw::sa_family::UNSPEC,		"AF_UNSPEC"},
-	{nw::sa_family::INET,		"AF_INET"},
-	{nw::sa_family::INET6,		"AF_INET6"}
+static const std::string	s_family_str[] = {
+	"AF_UNSPEC", "AF_LOCAL", "AF_INET", "AF_INET6"
 };
 
+static uint8_t				_family_index(const nw::sa_family &family) {
+	switch (family) {
+		case nw::sa_family::UNSPEC:	return 0;
+		case nw::sa_family::LOCAL:	return 1;
+		case nw::sa_family::INET:	return 2;
+		case nw::sa_family::INET6:	return 3;
+		default:					throw std::out_of_range("sa_family_str: unknown family");
+	}
+}
+
 const std::string &	nw::sa_family_str(const nw::sa_family &family) {
-	return s_family_str.at(family);
+	return s_family_str[_family_index(family)];
+}
+
+const char *		nw::sa_family_name(const nw::sa_family &family) {
+	return s_family_str[_family_index(family)].c_str();
 }
 
-static const std::map<const nw::sock_type, const std::string>	s_type_str = {
-	{nw::sock_type::UNSPEC,		"UNSPEC"},
-	{nw::sock_type::STREAM,		"STREAM"},
-	{nw::sock_type::DGRAM,		"DGRAM"},
-	{nw::sock_type::SEQPACKET,	"SEQPACKET"},
-	{nw::sock_type::RAW,		"RAW"},
-	{nw::sock_type::RDM,		"RDM"}
+static const std::string	s_type_str[] = {
+	"UNSPEC", "STREAM", "DGRAM", "RAW", "RDM", "SEQPACKET"
 };
 
+static uint8_t				_type_index(const nw::sock_type &type) {
+	switch (type) {
+		case nw::sock_type::UNSPEC:		return 0;
+		case nw::sock_type::STREAM:		return 1;
+		case nw::sock_type::DGRAM:		return 2;
+		case nw::sock_type::RAW:		return 3;
+		case nw::sock_type::RDM:		return 4;
+		case nw::sock_type::SEQPACKET:	return 5;
+		default:						throw std::out_of_range("sock_type_str: unknown type");
+	}
+}
+
 const std::string &	nw::sock_type_str(const nw::sock_type &type) {
-	return s_type_str.at(type);
+	return s_type_str[_type_index(type)];
 }
 
+const char *		nw::sock_type_name(const nw::sock_type &type) {
+	return s_type_str[_type_index(type)].c_str();
+}
@@ -11,6 +11,7 @@
 # include <cerrno>
 # include <stdexcept>
 # include <system_error>
+# include <chrono>
 
 # include <netdb.h>
 
@@ -18,6 +19,7 @@ namespace nw {
 	//! @enum sa_family
 	enum class	sa_family : sa_family_t {
 		UNSPEC		= AF_UNSPEC,					//!< Unspecified Internet family
+		LOCAL		= AF_LOCAL,						//!< Local communication (AF_UNIX) family
 		INET		= AF_INET,						//!< IPv4 Internet family
 		INET6		= AF_INET6,						//!< IPv6 Internet family
 		INET6V4M	= static_cast<sa_family_t>(~0)	//!< IPv6 with IPv4 mapped Internet family
@@ -33,6 +35,14 @@ namespace nw {
 		RDM			= SOCK_RDM			//!< Provides a reliable datagram layer that does not guarantee ordering.
 	};
 
+	//! @enum flush_policy
+	enum class	flush_policy : uint8_t {
+		IMMEDIATE,	//!< Every nw::socket::send issue a system call.
+		MORE,		//!< nw::socket::send issue a system call flagged MSG_MORE, nw::socket::flush end the message.
+		CORK,		//!< TCP_CORK (UDP_CORK) is held, nw::socket::send issue a system call and nw::socket::flush push partial frames.
+		BATCH		//!< nw::socket::send defer system calls until the buffer is half full then send with MSG_MORE, nw::socket::flush end the message.
+	};
+
 	typedef socklen_t	socklen_type;
 	typedef in_port_t	port_type;
 	typedef int32_t		proto_id;
@@ -42,6 +52,10 @@ namespace nw {
 	typedef size_type	pos_type;
 	const pos_type		npos = ~0;
 
+	typedef std::chrono::steady_clock	clock_type;
+	typedef clock_type::time_point		time_point;
+	typedef std::chrono::milliseconds	msec_type;
+
 	typedef std::exception		exception;
 	typedef std::bad_alloc		bad_alloc;
 	typedef std::logic_error	logic_error;
@@ -49,6 +63,11 @@ namespace nw {
 
 	const std::string &	sa_family_str(const sa_family &family);
 	const std::string &	sock_type_str(const sock_type &type);
+
+	//! @brief Same as nw::sa_family_str, for allocation free formatting
+	const char *		sa_family_name(const sa_family &family);
+	//! @brief Same as nw::sock_type_str, for allocation free formatting
+	const char *		sock_type_name(const sock_type &type);
 };
 
 #endif